@@ -0,0 +1,461 @@
+// Tests of WeatherflowTempestSVGLogger. They're built from the program's own source, with its main() renamed so this file can have its own.
+// Each test is chosen by name on the command line, and the program returns 0 when it passes. CMakeLists.txt runs each one under CTest.
+#define main WeatherflowTempestSVGLoggerMain
+#include "weatherflowtempestsvglogger.cpp"
+#undef main
+/////////////////////////////////////////////////////////////////////////////
+// A directory under the system temporary directory that's removed with everything in it when the test is done
+class TestDirectory {
+public:
+	explicit TestDirectory(const std::string& Name) : Path(std::filesystem::temp_directory_path() / ("weatherflow-test-" + Name + "-" + std::to_string(getpid()))) { std::filesystem::remove_all(Path); std::filesystem::create_directories(Path); };
+	~TestDirectory() { std::error_code ec; std::filesystem::remove_all(Path, ec); };
+	const std::filesystem::path Path;
+};
+std::string ReadTestFile(const std::filesystem::path& FileName)
+{
+	std::ifstream TheFile(FileName, std::ios_base::in | std::ios_base::binary);
+	std::ostringstream rval;
+	rval << TheFile.rdbuf();
+	return(rval.str());
+}
+/////////////////////////////////////////////////////////////////////////////
+// Writes a text log for each month, with two stations reporting every five minutes, and the rapid wind, hub status and broken lines a real log also has.
+// The values only depend on the time, so the logs are the same every time.
+void WriteTestLogs(const std::filesystem::path& Directory, const std::vector<std::string>& Months)
+{
+	const std::array<std::string, 2> Serials = { "ST-00000512", "ST-00000513" };
+	for (auto const& Month : Months)
+	{
+		struct tm Start = { 0 };
+		Start.tm_year = std::stoi(Month.substr(0, 4)) - 1900;
+		Start.tm_mon = std::stoi(Month.substr(5, 2)) - 1;
+		Start.tm_mday = 1;
+		struct tm End(Start);
+		End.tm_mon++;
+		std::ofstream LogFile(Directory / ("weatherflow-" + Month + ".txt"), std::ios_base::out | std::ios_base::trunc);
+		for (time_t TheTime = timegm(&Start); TheTime < timegm(&End); TheTime += 5 * 60)
+		{
+			const double Day = std::sin(2 * M_PI * (TheTime % (24 * 60 * 60)) / (24 * 60 * 60));
+			for (size_t index = 0; index < Serials.size(); index++)
+			{
+				const double Wind = 2 + 1.5 * std::sin(TheTime / 4000.0 + index);
+				LogFile << "{\"serial_number\":\"" << Serials[index] << "\",\"type\":\"obs_st\",\"hub_sn\":\"HB-00000001\",\"obs\":[[" << TheTime + index
+					<< "," << FixedPoint(Wind * 0.5, 2) << "," << FixedPoint(Wind, 2) << "," << FixedPoint(Wind * 1.5, 2) << "," << (TheTime / 300 + index * 90) % 360 << ",3"
+					<< "," << FixedPoint(1013 + 8 * std::sin(TheTime / 200000.0), 2) << "," << FixedPoint(10 + index + 8 * Day, 2) << "," << FixedPoint(60 - 20 * Day, 2)
+					<< "," << std::max(0, int(50000 * Day)) << "," << FixedPoint(std::max(0.0, 6 * Day), 2) << "," << std::max(0, int(600 * Day))
+					<< "," << ((TheTime / 3600) % 37 == 0 ? "0.250000" : "0.000000") << ",0,0," << ((TheTime / 3600) % 101 == 0 ? 2 : 0) << "," << FixedPoint(2.6 + 0.1 * Day, 3) << ",1]],\"firmware_revision\":176}\n";
+				LogFile << "{\"serial_number\":\"" << Serials[index] << "\",\"type\":\"rapid_wind\",\"hub_sn\":\"HB-00000001\",\"ob\":[" << TheTime + index + 3 << "," << FixedPoint(Wind, 2) << ",127]}\n";
+			}
+			if (TheTime % (60 * 60) == 0)
+				LogFile << "{\"serial_number\":\"HB-00000001\",\"type\":\"hub_status\",\"firmware_revision\":\"177\",\"uptime\":1234,\"rssi\":-40,\"timestamp\":" << TheTime << ",\"seq\":1}\n";
+			if (TheTime % (24 * 60 * 60) == 0)
+				LogFile << "{\"serial_number\":\"ST-00000512\",\"type\":\"obs_st\",\"obs\":[[" << TheTime << ",1.0\n";	// cut off, as when the program was stopped mid write
+		}
+	}
+}
+// Reads the logs into TempestDevices with the given number of threads, starting from the cache files in CacheFrom if there are any, and writes the cache files into CacheTo.
+void ReadTestLogs(const std::filesystem::path& Logs, const std::filesystem::path& CacheFrom, const std::filesystem::path& CacheTo, const unsigned int Threads)
+{
+	TempestDevices.clear();
+	LogDirectory = Logs;
+	CacheDirectory = CacheFrom;
+	if (!CacheDirectory.empty())
+		ReadCacheDirectory();
+	LogReadThreads = Threads;
+	ReadLoggedData();
+	std::filesystem::create_directories(CacheTo);
+	CacheDirectory = CacheTo;
+	GenerateCacheFile();
+}
+// Compares every cache file written into two directories, byte for byte
+bool CompareCacheFiles(const std::filesystem::path& Expected, const std::filesystem::path& Actual, const std::string& Description)
+{
+	bool rval = true;
+	size_t Count = 0;
+	for (auto const& dir_entry : std::filesystem::directory_iterator{ Expected })
+	{
+		Count++;
+		const std::filesystem::path ActualFile(Actual / dir_entry.path().filename());
+		if (!std::filesystem::exists(ActualFile) || (ReadTestFile(dir_entry.path()) != ReadTestFile(ActualFile)))
+		{
+			std::cerr << Description << ": " << ActualFile.string() << " differs from " << dir_entry.path().string() << std::endl;
+			rval = false;
+		}
+	}
+	if (Count != std::distance(std::filesystem::directory_iterator{ Actual }, std::filesystem::directory_iterator{}))
+	{
+		std::cerr << Description << ": " << Actual.string() << " doesn't hold the same files as " << Expected.string() << std::endl;
+		rval = false;
+	}
+	if (Count == 0)
+	{
+		std::cerr << Description << ": no cache files were written" << std::endl;
+		rval = false;
+	}
+	return(rval);
+}
+// Reading the logs with one thread and with several has to give exactly the same rings, both from nothing and when a cache already covers the older months,
+// even when one station has no cache file, or one that is rejected.
+int TestWorkers(void)
+{
+	int rval = 0;
+	TestDirectory Test("workers");
+	const std::filesystem::path Logs(Test.Path / "logs"), OlderLogs(Test.Path / "older");
+	std::filesystem::create_directories(Logs);
+	std::filesystem::create_directories(OlderLogs);
+	WriteTestLogs(Logs, { "2024-01", "2024-02", "2024-03", "2024-04" });
+	WriteTestLogs(OlderLogs, { "2024-01", "2024-02" });
+	ReadTestLogs(Logs, "", Test.Path / "serial", 1);
+	for (auto Threads : { 2u, 4u })
+	{
+		ReadTestLogs(Logs, "", Test.Path / ("parallel-" + std::to_string(Threads)), Threads);
+		if (!CompareCacheFiles(Test.Path / "serial", Test.Path / ("parallel-" + std::to_string(Threads)), "--workers " + std::to_string(Threads)))
+			rval = 1;
+	}
+	ReadTestLogs(OlderLogs, "", Test.Path / "older-cache", 1);
+	ReadTestLogs(Logs, Test.Path / "older-cache", Test.Path / "cached-serial", 1);
+	ReadTestLogs(Logs, Test.Path / "older-cache", Test.Path / "cached-parallel", 4);
+	if (!CompareCacheFiles(Test.Path / "cached-serial", Test.Path / "cached-parallel", "--workers 4 from a cache"))
+		rval = 1;
+	if (!CompareCacheFiles(Test.Path / "serial", Test.Path / "cached-serial", "--workers 1 from a cache"))
+		rval = 1;
+	// A station without a cache file, or with one that's rejected, still gets all of its history when the other station's cache covers the older months
+	std::filesystem::copy(Test.Path / "older-cache", Test.Path / "missing-cache");
+	std::filesystem::remove(Test.Path / "missing-cache" / "weatherflow-ST-00000513-cache.dat");
+	std::filesystem::copy(Test.Path / "older-cache", Test.Path / "rejected-cache");
+	std::filesystem::resize_file(Test.Path / "rejected-cache" / "weatherflow-ST-00000513-cache.dat", 100);
+	for (auto const Cache : { "missing", "rejected" })
+		for (auto Threads : { 1u, 4u })
+		{
+			const std::string Name(std::string(Cache) + "-" + std::to_string(Threads));
+			ReadTestLogs(Logs, Test.Path / (std::string(Cache) + "-cache"), Test.Path / Name, Threads);
+			if (!CompareCacheFiles(Test.Path / "serial", Test.Path / Name, "--workers " + std::to_string(Threads) + " from a cache with one station " + Cache))
+				rval = 1;
+		}
+	return(rval);
+}
+/////////////////////////////////////////////////////////////////////////////
+// An archive file has to give back exactly the observations of the JSON it was written from, including the ones newer than a given time.
+// A month with archive files still has to give exactly the same rings as its text log, when one station's archive stops partway through the month,
+// as when --archive is turned off or a write fails, and another station has no archive at all.
+int TestArchive(void)
+{
+	int rval = 0;
+	TestDirectory Test("archive");
+	const std::vector<std::string> Lines = {
+		"{\"serial_number\":\"ST-00000512\",\"type\":\"obs_st\",\"hub_sn\":\"HB-00013030\",\"obs\":[[1588948614,0.18,0.22,0.27,144,6,1017.57,22.37,50.26,328,0.03,3,0.000000,0,0,0,2.410,1]],\"firmware_revision\":129}",
+		"{\"serial_number\":\"ST-00000513\",\"type\":\"obs_st\",\"hub_sn\":\"HB-00013030\",\"obs\":[[1588948620,1.1,2.2,3.3,90,3,980.5,35.25,12.5,88000,9.8,760,0.01,3,5,1,2.6,1]],\"firmware_revision\":129}",
+		"{\"serial_number\":\"ST-00000512\",\"type\":\"rapid_wind\",\"hub_sn\":\"HB-00013030\",\"ob\":[1588948650,2.3,128]}",
+		"{\"serial_number\":\"ST-00000512\",\"type\":\"obs_st\",\"hub_sn\":\"HB-00013030\",\"obs\":[[1588948674,0,0,0,0,3,1017.6,-3.5,99.9,0,0,0,0.000000,0,0,0,2.39,1]],\"firmware_revision\":129}",
+		"{\"serial_number\":\"HB-00013030\",\"type\":\"hub_status\",\"firmware_revision\":\"177\",\"uptime\":1234,\"rssi\":-40,\"timestamp\":1588948680,\"seq\":1}",
+		"{\"serial_number\":\"ST-00000512\",\"type\":\"obs_st\",\"hub_sn\":\"HB-00013030\",\"obs\":[[1588948734,5.12,8.3,12.91,359,3,1017.54,-0.06,100,120000,11.52,1014,0.123457,1,17,3,2.812,1]],\"firmware_revision\":129}",
+	};
+	const std::filesystem::path JSONLog(Test.Path / "weatherflow-2020-05.txt");
+	{
+		std::ofstream LogFile(JSONLog, std::ios_base::out | std::ios_base::trunc);
+		for (auto const& Line : Lines)
+			LogFile << Line << "\n";
+	}
+	const std::map<std::string, std::vector<ArchiveRow>> DeviceRows(ReadLogFileRows(JSONLog));
+	if ((DeviceRows.size() != 2) || (DeviceRows.at("ST-00000512").size() != 3) || (DeviceRows.at("ST-00000513").size() != 1))
+	{
+		std::cerr << "The obs_st lines of " << JSONLog.string() << " weren't all read" << std::endl;
+		return(1);
+	}
+	for (auto const& [Serial, Rows] : DeviceRows)
+	{
+		const std::filesystem::path ArchiveFileName(GenerateArchiveFileName(JSONLog, Serial));
+		std::ofstream(ArchiveFileName, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc) << EncodeArchiveFile(Rows);
+		std::vector<std::string> Expected;	// the obs_st lines of this device
+		for (auto const& Line : Lines)
+			if ((GetJSONString(Line, "serial_number") == Serial) && (GetJSONString(Line, "type") == "obs_st"))
+				Expected.push_back(Line);
+		for (auto const NewestTime : { time_t(0), time_t(1588948674) })
+		{
+			const std::vector<ArchiveRow> Replayed(ReadArchiveFile(ArchiveFileName, NewestTime));
+			size_t Count = 0;
+			for (auto const& Line : Expected)
+			{
+				double FromLine[18];
+				if (TempestObservation::ParseObservation(Line, FromLine) && (time_t(FromLine[0]) > NewestTime))
+				{
+					// The values must come back as exactly the same doubles, and make the same observation as parsing the JSON does
+					std::ostringstream FromJSON, FromArchive;
+					TempestObservation(Line).WriteCache(FromJSON);
+					if (Count < Replayed.size())
+					{
+						double obs[18];
+						std::copy(Replayed[Count].begin(), Replayed[Count].end(), obs);
+						TempestObservation(obs).WriteCache(FromArchive);
+					}
+					if ((Count >= Replayed.size()) || (0 != memcmp(Replayed[Count].data(), FromLine, sizeof(FromLine))) || (FromJSON.str() != FromArchive.str()))
+					{
+						std::cerr << ArchiveFileName.string() << " newer than " << NewestTime << " doesn't give back " << Line << std::endl;
+						rval = 1;
+					}
+					Count++;
+				}
+			}
+			if (Replayed.size() != Count)
+			{
+				std::cerr << ArchiveFileName.string() << " newer than " << NewestTime << " has " << Replayed.size() << " observations instead of " << Count << std::endl;
+				rval = 1;
+			}
+		}
+	}
+	const std::filesystem::path Logs(Test.Path / "logs"), Archived(Test.Path / "archived");
+	std::filesystem::create_directories(Logs);
+	std::filesystem::create_directories(Archived);
+	WriteTestLogs(Logs, { "2024-02", "2024-03" });
+	WriteTestLogs(Archived, { "2024-02", "2024-03" });
+	for (auto const& [Serial, Rows] : ReadLogFileRows(Archived / "weatherflow-2024-02.txt"))
+		std::ofstream(GenerateArchiveFileName(Archived / "weatherflow-2024-02.txt", Serial), std::ios_base::out | std::ios_base::binary | std::ios_base::trunc) << EncodeArchiveFile(Rows);
+	std::vector<ArchiveRow> HalfMonth(ReadLogFileRows(Archived / "weatherflow-2024-03.txt")["ST-00000512"]);
+	HalfMonth.resize(HalfMonth.size() / 2);
+	std::ofstream(GenerateArchiveFileName(Archived / "weatherflow-2024-03.txt", "ST-00000512"), std::ios_base::out | std::ios_base::binary | std::ios_base::trunc) << EncodeArchiveFile(HalfMonth);
+	ReadTestLogs(Logs, "", Test.Path / "text", 1);
+	for (auto Threads : { 1u, 4u })
+	{
+		ReadTestLogs(Archived, "", Test.Path / ("archived-" + std::to_string(Threads)), Threads);
+		if (!CompareCacheFiles(Test.Path / "text", Test.Path / ("archived-" + std::to_string(Threads)), "Archive files with --workers " + std::to_string(Threads)))
+			rval = 1;
+	}
+	return(rval);
+}
+/////////////////////////////////////////////////////////////////////////////
+// LocalTimeBoundaries has to agree with localtime_r() for every minute of the days the clocks change, and the days either side of them.
+// It's run by CTest with TZ set to zones that move their clocks by an hour and by half an hour, and fails if the zone has no transitions to check.
+int TestDST(void)
+{
+	int rval = 0;
+	tzset();
+	LocalTimeBoundaries Boundaries;
+	auto GetOffset = [](const time_t TheTime) { struct tm Local; localtime_r(&TheTime, &Local); return(Local.tm_gmtoff); };
+	std::vector<time_t> Transitions;
+	for (time_t TheTime = 1672531200; TheTime < 1767225600; TheTime += 60 * 60)	// 2023 through 2025
+		if (GetOffset(TheTime) != GetOffset(TheTime + 60 * 60))
+			Transitions.push_back(TheTime + 60 * 60);
+	if (Transitions.size() < 6)
+	{
+		std::cerr << "TZ=" << (getenv("TZ") == nullptr ? "" : getenv("TZ")) << " only has " << Transitions.size() << " DST transitions from 2023 through 2025" << std::endl;
+		rval = 1;
+	}
+	size_t Checked = 0;
+	for (auto const Transition : Transitions)
+	{
+		// The local day starts at the first minute with a new date. Every zone tested is a whole number of minutes from UTC.
+		time_t DayStart = 0;
+		int DayOfYear = -1;
+		for (time_t TheTime = Transition - 54 * 60 * 60; (TheTime < Transition + 54 * 60 * 60) && (rval < 10); TheTime += 60)
+		{
+			struct tm Local;
+			localtime_r(&TheTime, &Local);
+			if (Local.tm_yday != DayOfYear)
+			{
+				DayStart = (DayOfYear == -1) ? 0 : TheTime;
+				DayOfYear = Local.tm_yday;
+			}
+			for (auto const Second : { 0, 37 })
+			{
+				if (Boundaries.GetMinuteOfDay(TheTime + Second) != Local.tm_hour * 60 + Local.tm_min)
+				{
+					std::cerr << "GetMinuteOfDay(" << TheTime + Second << ") is " << Boundaries.GetMinuteOfDay(TheTime + Second) << ", localtime_r() says " << Local.tm_hour * 60 + Local.tm_min << std::endl;
+					rval++;
+				}
+				if ((DayStart != 0) && (Boundaries.GetLocalMidnight(TheTime + Second) != DayStart))
+				{
+					std::cerr << "GetLocalMidnight(" << TheTime + Second << ") is " << Boundaries.GetLocalMidnight(TheTime + Second) << ", localtime_r() says " << DayStart << std::endl;
+					rval++;
+				}
+				Checked++;
+			}
+		}
+	}
+	if (ConsoleVerbosity > 0)
+		std::cout << Transitions.size() << " transitions, " << Checked << " times checked" << std::endl;
+	return(rval > 0 ? 1 : 0);
+}
+// Whether a wind graph has wind direction arrows, and all of them inside the graph, which is narrower when it has the pressure scale on the right
+bool WindDirectionInside(const std::string_view SVG)
+{
+	const double GraphRight = (SVG.find("fill:green;dominant-baseline:middle") == std::string_view::npos) ? 500 - 14 : 500 - 14 - 12 - 4;
+	double Right = 0;
+	for (auto pos = SVG.find("class=\"wind-direction\""); pos != std::string_view::npos; pos = SVG.find("class=\"wind-direction\"", pos + 1))
+		for (auto const Attribute : { " x1=\"", " x2=\"" })
+		{
+			const auto Value = SVG.find(Attribute, pos);
+			if (Value != std::string_view::npos)
+				Right = std::max(Right, std::atof(std::string(SVG.substr(Value + 5, 16)).c_str()));
+		}
+	if ((Right == 0) || (Right > GraphRight))
+		std::cerr << "The wind direction is drawn out to " << Right << " on a graph ending at " << GraphRight << std::endl;
+	return((Right > 0) && (Right <= GraphRight));
+}
+/////////////////////////////////////////////////////////////////////////////
+// Two years of daily samples, as many as the yearly ring holds, folded into the width of a graph, have to keep the extremes of every column,
+// including a hot day, a cold day and a wet day that are too old to be drawn without --envelope.
+int TestEnvelope(void)
+{
+	int rval = 0;
+	setenv("TZ", "UTC", 1);	// the yearly samples are at midnight
+	tzset();
+	const time_t Newest = 1735689600;	// 2025-01-01
+	std::vector<TempestObservation> Days;	// newest first, like the rings
+	for (size_t index = 0; index < YEAR_COUNT; index++)
+	{
+		double obs[18] = { double(Newest - time_t(index) * YEAR_SAMPLE), 1, 2, 3, 180, 3, 1013 + 10 * std::sin(index / 40.0), 10 + 8 * std::sin(index / 58.0), 60, 20000, 3, 300, 0, 0, 0, 0, 2.6, 1 };
+		if (index == 600)
+			obs[7] = 41.5;	// hot
+		if (index == 650)
+			obs[7] = -23.25;	// cold
+		if (index == 700)
+			obs[12] = 31;	// wet
+		Days.push_back(TempestObservation(obs));
+	}
+	const TempestColumns Samples(Days);
+	const TempestSeries TheSamples(Samples.GetSeries());
+	const int GraphWidth = 430;
+	const GraphColumns Columns(TheSamples, GraphWidth, true);
+	const TempestSeries& TheColumns(Columns.Series);
+	if ((TheColumns.size() != size_t(GraphWidth)) || (Columns.SampleCount != YEAR_COUNT))
+	{
+		std::cerr << YEAR_COUNT << " samples were folded into " << TheColumns.size() << " columns covering " << Columns.SampleCount << " samples" << std::endl;
+		return(1);
+	}
+	// Each column against the samples that went into it
+	size_t Start = 0;
+	for (size_t Column = 0; Column < TheColumns.size(); Column++)
+	{
+		size_t End = Start;
+		while ((End < TheSamples.size()) && (End * TheColumns.size() / TheSamples.size() == Column))
+			End++;
+		if ((End == Start) ||
+			(TheColumns.Time[Column] != TheSamples.Time[Start]) ||
+			(TheColumns.TemperatureMax[Column] != *std::max_element(TheSamples.TemperatureMax.begin() + Start, TheSamples.TemperatureMax.begin() + End)) ||
+			(TheColumns.TemperatureMin[Column] != *std::min_element(TheSamples.TemperatureMin.begin() + Start, TheSamples.TemperatureMin.begin() + End)) ||
+			(TheColumns.Rain[Column] != *std::max_element(TheSamples.Rain.begin() + Start, TheSamples.Rain.begin() + End)))
+		{
+			std::cerr << "Column " << Column << " doesn't keep the extremes of samples " << Start << " to " << End << std::endl;
+			rval = 1;
+		}
+		Start = End;
+	}
+	if (Start != TheSamples.size())
+	{
+		std::cerr << "The columns cover " << Start << " of " << TheSamples.size() << " samples" << std::endl;
+		rval = 1;
+	}
+	if ((GetColumnMax(TheColumns.TemperatureMax.data(), TheColumns.size()) != 41.5) || (GetColumnMin(TheColumns.TemperatureMin.data(), TheColumns.size()) != -23.25) || (GetColumnMax(TheColumns.Rain.data(), TheColumns.size()) != 31))
+	{
+		std::cerr << "The hot, cold and wet days were lost from the columns" << std::endl;
+		rval = 1;
+	}
+	// The graphs are scaled to the extremes, so they show up in the labels, and the time axis covers all of the two years
+	auto CountText = [](const std::string_view SVG, const std::string_view Text) { size_t rval = 0; for (auto pos = SVG.find(Text); pos != std::string_view::npos; pos = SVG.find(Text, pos + 1)) rval++; return(rval); };
+	for (auto const Envelope : { false, true })
+	{
+		TimeAxisLayout TimeAxis;
+		SVGBuffer Temperature, Wind, Rain;
+		RenderTemperatureSVG(Temperature, TheSamples, "Test", GraphType::yearly, TimeAxis, false, false, true, false, Envelope);
+		RenderWindSVG(Wind, TheSamples, "Test", GraphType::yearly, TimeAxis, true, 4.0, false, Envelope);
+		RenderRainSVG(Rain, TheSamples, "Test", GraphType::yearly, TimeAxis, false, Envelope);
+		const bool Extremes = (CountText(Temperature.view(), ">41.5<") == 1) && (CountText(Temperature.view(), ">-23.2<") + CountText(Temperature.view(), ">-23.3<") == 1) && (CountText(Rain.view(), ">31.00<") == 1);
+		const size_t Months = CountText(Temperature.view(), "<text style=\"text-anchor:middle\"");
+		size_t AllMonths = 0;	// the yearly graph labels the 15th of each month
+		for (size_t index = 0; index < TheSamples.size(); index++)
+		{
+			struct tm UTC;
+			const time_t TheTime = TheSamples.Time[index];
+			if ((gmtime_r(&TheTime, &UTC) != nullptr) && (UTC.tm_mday == 15))
+				AllMonths++;
+		}
+		if (Extremes != Envelope)
+		{
+			std::cerr << "The extremes are " << (Extremes ? "" : "not ") << "labeled on the graphs " << (Envelope ? "with" : "without") << " --envelope" << std::endl;
+			rval = 1;
+		}
+		if (!WindDirectionInside(Wind.view()))
+		{
+			std::cerr << "The yearly wind graph " << (Envelope ? "with" : "without") << " --envelope draws the wind direction outside the graph" << std::endl;
+			rval = 1;
+		}
+		if (Envelope ? (Months != AllMonths) : (Months >= AllMonths))
+		{
+			std::cerr << "The yearly graph " << (Envelope ? "with" : "without") << " --envelope labels " << Months << " of " << AllMonths << " months" << std::endl;
+			rval = 1;
+		}
+	}
+	return(rval);
+}
+/////////////////////////////////////////////////////////////////////////////
+// The resolution of a --query is converted to seconds without overflowing, and the number of samples rounds up to cover the end of the range.
+int TestQuery(void)
+{
+	int rval = 0;
+	const std::vector<std::pair<std::string, time_t>> Resolutions = {
+		{ "300", 300 }, { "300s", 300 }, { "5m", 300 }, { "1h", 3600 }, { "2d", 2 * 24 * 60 * 60 },
+		{ "0", 0 }, { "-1h", 0 }, { "1w", 0 }, { "h", 0 }, { "", 0 },
+		{ "999999999999999d", 0 }, { "9999999999999999h", 0 }, { "9223372036854775807m", 0 }, { "99999999999999999999", 0 },
+		{ std::to_string(std::numeric_limits<time_t>::max() / (24 * 60 * 60)) + "d", (std::numeric_limits<time_t>::max() / (24 * 60 * 60)) * 24 * 60 * 60 },
+	};
+	for (auto const& [Text, Seconds] : Resolutions)
+		if (LogQuery::ParseResolution(Text) != Seconds)
+		{
+			std::cerr << "ParseResolution(\"" << Text << "\") is " << LogQuery::ParseResolution(Text) << " instead of " << Seconds << std::endl;
+			rval = 1;
+		}
+	const std::vector<std::pair<std::string, size_t>> Queries = {
+		{ "1709251200,1711929600,1h", 744 }, { "1709251200,1711929600,7h", 107 }, { "1709251200,1711929601,1h", 745 },
+		{ "1709251200,1711929600," + std::to_string(std::numeric_limits<time_t>::max()), 1 },
+		{ "1," + std::to_string(std::numeric_limits<time_t>::max()) + "," + std::to_string(std::numeric_limits<time_t>::max() / (24 * 60 * 60)) + "d", 2 },
+	};
+	for (auto const& [Argument, Buckets] : Queries)
+	{
+		LogQuery Query;
+		if (!Query.Parse(Argument) || (Query.GetBucketCount() != Buckets))
+		{
+			std::cerr << "--query " << Argument << " has " << Query.GetBucketCount() << " samples instead of " << Buckets << std::endl;
+			rval = 1;
+		}
+	}
+	// A month at 1h is more samples than the graphs are wide, so they're folded, and the wind direction has to stay inside the graph
+	TestDirectory Test("query");
+	WriteTestLogs(Test.Path, { "2024-03" });
+	LogDirectory = Test.Path;
+	SVGDirectory = Test.Path;
+	if (!RunLogQuery("1709251200,1711929600,1h,ST-00000512"))
+	{
+		std::cerr << "--query 1709251200,1711929600,1h --svg failed" << std::endl;
+		rval = 1;
+	}
+	else if (!WindDirectionInside(ReadTestFile(Test.Path / "weatherflow-ST-00000512-query-wind.svg")))
+	{
+		std::cerr << "--query 1709251200,1711929600,1h --svg draws the wind direction outside the graph" << std::endl;
+		rval = 1;
+	}
+	LogDirectory.clear();
+	SVGDirectory.clear();
+	return(rval);
+}
+/////////////////////////////////////////////////////////////////////////////
+int main(int argc, char** argv)
+{
+	const std::map<std::string, std::function<int(void)>> Tests = {
+		{ "archive", TestArchive },
+		{ "dst", TestDST },
+		{ "envelope", TestEnvelope },
+		{ "query", TestQuery },
+		{ "workers", TestWorkers },
+	};
+	ConsoleVerbosity = 0;
+	const auto Test = (argc == 2) ? Tests.find(argv[1]) : Tests.end();
+	if (Test == Tests.end())
+	{
+		std::cerr << "Usage: " << argv[0] << " test" << std::endl << "  Tests:";
+		for (auto const& [Name, TestFunction] : Tests)
+			std::cerr << " " << Name;
+		std::cerr << std::endl;
+		return(2);
+	}
+	return(Test->second());
+}
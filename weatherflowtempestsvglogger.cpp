@@ -1,22 +1,48 @@
 #include "wimiso8601.h"
+#include <algorithm>
 #include <arpa/inet.h>
+#include <array>
+#include <atomic>
+#include <cctype>
 #include <cfloat>
+#include <charconv>
+#include <chrono>
 #include <climits>
+#include <cmath>
 #include <csignal>
 #include <cstdio>
 #include <cstring>
 #include <ctime>
+#include <deque>
+#include <fcntl.h>
 #include <filesystem>
 #include <fstream>
+#include <functional>
+#include <future>
 #include <getopt.h>
 #include <iostream>
 #include <jsoncpp/json/json.h> // sudo apt install libjsoncpp-dev
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <poll.h>
 #include <queue>
 #include <regex>
+#include <string_view>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/uio.h>
+#include <thread>
 #include <unistd.h>
+#include <unordered_map>
 #include <utime.h>
+#include <zlib.h> // sudo apt install zlib1g-dev
 
 /////////////////////////////////////////////////////////////////////////////
 #if __has_include("weatherflowtempestsvglogger-version.h")
@@ -34,9 +60,16 @@ std::filesystem::path LogDirectory;	// If this remains empty, log Files are not
 std::filesystem::path CacheDirectory;	// If this remains empty, cache Files are not used. Cache Files should greatly speed up startup of the program if logged data runs multiple years over many devices.
 std::filesystem::path SVGDirectory;	// If this remains empty, SVG Files are not created. If it's specified, _day, _week, _month, and _year.svg files are created for each bluetooth address seen.
 int LogFileTime(60);	// Time between log file writes, to reduce frequency of writing to SD Card
+bool LogFileSync(false);	// fdatasync() the log file after each write
+bool LogArchive(false);	// Also write the observations to a compressed archive file next to each text log file
 int SVGBattery(0); // 0x01 = Draw Battery line on daily, 0x02 = Draw Battery line on weekly, 0x04 = Draw Battery line on monthly, 0x08 = Draw Battery line on yearly
 int SVGMinMax(0); // 0x01 = Draw Temperature and Humiditiy Minimum and Maximum line on daily, 0x02 = on weekly, 0x04 = on monthly, 0x08 = on yearly
+int SVGSimplify(0); // 0x01 = Merge points along straight runs of the lines on daily, 0x02 = on weekly, 0x04 = on monthly, 0x08 = on yearly
+int SVGEnvelope(0); // 0x01 = Fold every sample into the width of the daily graph, keeping the minimum and maximum of each column, 0x02 = weekly, 0x04 = monthly, 0x08 = yearly
 bool SVGFahrenheit(true);
+unsigned int LogReadThreads(std::max(1u, std::thread::hardware_concurrency()));	// Number of log files parsed concurrently at startup
+unsigned int SVGRenderThreads(std::max(1u, std::min(8u, std::thread::hardware_concurrency())));	// Number of SVG files rendered concurrently
+int HTTPPort(0);	// If this remains 0, the built in web server isn't started
 //std::filesystem::path SVGTitleMapFilename;
 //std::filesystem::path SVGIndexFilename;
 // The following details were taken from https://github.com/oetiker/mrtg
@@ -49,11 +82,238 @@ const size_t WEEK_SAMPLE(30 * 60);		/* Sample every 30 minutes */
 const size_t MONTH_SAMPLE(2 * 60 * 60);	/* Sample every 2 hours */
 const size_t YEAR_SAMPLE(24 * 60 * 60);	/* Sample every 24 hours */
 /////////////////////////////////////////////////////////////////////////////
+// The hub broadcasts compact single line JSON. These routines pull the few fields we care about directly out of the received bytes
+// without building a Json::Value tree. They return false (or empty) if the message isn't in the expected shape so the caller can fall back to jsoncpp.
+inline void SkipJSONWhitespace(std::string_view& JSonData)
+{
+	while (!JSonData.empty() && std::isspace(static_cast<unsigned char>(JSonData.front())))
+		JSonData.remove_prefix(1);
+}
+inline bool SkipJSONCharacter(std::string_view& JSonData, const char Character)
+{
+	SkipJSONWhitespace(JSonData);
+	if (JSonData.empty() || (JSonData.front() != Character))
+		return(false);
+	JSonData.remove_prefix(1);
+	return(true);
+}
+// Advances JSonData to just past the colon following "Key"
+bool FindJSONKey(std::string_view& JSonData, const std::string_view Key)
+{
+	for (auto pos = JSonData.find(Key); pos != std::string_view::npos; pos = JSonData.find(Key, pos + Key.length()))
+	{
+		if ((pos > 0) && (JSonData[pos - 1] == '"') && (pos + Key.length() < JSonData.length()) && (JSonData[pos + Key.length()] == '"'))
+		{
+			std::string_view Remainder(JSonData.substr(pos + Key.length() + 1));
+			if (SkipJSONCharacter(Remainder, ':'))
+			{
+				JSonData = Remainder;
+				return(true);
+			}
+		}
+	}
+	return(false);
+}
+// Returns a view of the string value of Key, or an empty view if it's not found or contains escape characters.
+std::string_view GetJSONString(std::string_view JSonData, const std::string_view Key)
+{
+	std::string_view rval;
+	if (FindJSONKey(JSonData, Key) && SkipJSONCharacter(JSonData, '"'))
+	{
+		auto pos = JSonData.find_first_of("\\\"");
+		if ((pos != std::string_view::npos) && (JSonData[pos] == '"'))
+			rval = JSonData.substr(0, pos);
+	}
+	return(rval);
+}
+// Fills Values with exactly Count numbers from the array value of Key. Nested is for the obs_st format where the values are wrapped in a second array.
+// null elements are returned as zero, matching jsoncpp's asDouble().
+bool GetJSONNumberArray(std::string_view JSonData, const std::string_view Key, double* Values, const size_t Count, const bool Nested = false)
+{
+	if (!FindJSONKey(JSonData, Key) || !SkipJSONCharacter(JSonData, '['))
+		return(false);
+	if (Nested && !SkipJSONCharacter(JSonData, '['))
+		return(false);
+	for (size_t index = 0; index < Count; index++)
+	{
+		if ((index > 0) && !SkipJSONCharacter(JSonData, ','))
+			return(false);
+		SkipJSONWhitespace(JSonData);
+		if (JSonData.substr(0, 4) == "null")
+		{
+			Values[index] = 0;
+			JSonData.remove_prefix(4);
+		}
+		else
+		{
+			auto [ptr, ec] = std::from_chars(JSonData.data(), JSonData.data() + JSonData.length(), Values[index]);
+			if (ec != std::errc())
+				return(false);
+			JSonData.remove_prefix(ptr - JSonData.data());
+		}
+	}
+	if (!SkipJSONCharacter(JSonData, ']'))
+		return(false);
+	if (Nested && !SkipJSONCharacter(JSonData, ']'))
+		return(false);
+	return(true);
+}
+// Returns the message type, e.g. "obs_st" or "rapid_wind". Only if the fast scan can't find it is the message handed to jsoncpp.
+std::string_view GetTempestMessageType(const std::string_view JSonData)
+{
+	std::string_view rval(GetJSONString(JSonData, "type"));
+	if (rval.empty())
+	{
+		JSONCPP_STRING err;
+		Json::Value root;
+		Json::CharReaderBuilder builder;
+		const std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+		if (reader->parse(JSonData.data(), JSonData.data() + JSonData.length(), &root, &err))
+		{
+			const std::string msgtype = root["type"].asString();
+			if (!msgtype.compare("obs_st"))
+				rval = "obs_st";
+			else if (!msgtype.compare("rapid_wind"))
+				rval = "rapid_wind";
+		}
+	}
+	return(rval);
+}
+// Serial numbers become part of file names, so only letters, digits and dashes are accepted, like ST-00145757
+bool IsValidSerial(const std::string_view Serial)
+{
+	return(!Serial.empty() && (Serial.size() <= 32) && std::all_of(Serial.begin(), Serial.end(), [](const char c) { return(std::isalnum(static_cast<unsigned char>(c)) || (c == '-')); }));
+}
+// Fills ob with the time, wind speed and direction of a rapid_wind message
+bool ReadRapidWind(const std::string_view JSonData, double(&ob)[3])
+{
+	bool rval = GetJSONNumberArray(JSonData, "ob", ob, 3);
+	if (!rval)
+	{
+		JSONCPP_STRING err;
+		Json::Value root;
+		Json::CharReaderBuilder builder;
+		const std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+		if (reader->parse(JSonData.data(), JSonData.data() + JSonData.length(), &root, &err))
+		{
+			const Json::Value observation = root["ob"];
+			if (observation.size() == 3)
+			{
+				for (Json::ArrayIndex index = 0; index < 3; index++)
+					ob[index] = observation[index].asDouble();
+				rval = true;
+			}
+		}
+	}
+	return(rval);
+}
+/////////////////////////////////////////////////////////////////////////////
+// Local time calculations without calling localtime_r() and mktime() for every sample.
+// The UTC offset only changes at DST transitions, so within each span of constant offset the local time of day is integer arithmetic.
+// The spans are found with localtime_r() the first time a year is used, and kept sorted so that a lookup is a binary search.
+class LocalTimeBoundaries {
+public:
+	long GetUTCOffset(const time_t TheTime);
+	int GetMinuteOfDay(const time_t TheTime);	// local minutes since midnight, matching tm_hour * 60 + tm_min
+	time_t GetLocalMidnight(const time_t TheTime);	// the first instant of the local day containing TheTime
+	void clear(void) { std::lock_guard<std::mutex> lock(SpansMutex); Spans.clear(); };	// call after tzset(), since the spans were found with the time zone in effect before it
+private:
+	struct Span { time_t Start; time_t End; long Offset; };	// Offset applies to [Start, End)
+	static const time_t ChunkSize = 366 * 24 * 60 * 60;	// the range added each time a lookup isn't covered
+	static const time_t ProbeStep = 6 * 60 * 60;	// DST transitions are assumed to be at least this far apart
+	static const time_t SecondsPerDay = 24 * 60 * 60;
+	std::vector<Span> Spans;	// sorted, non overlapping
+	std::mutex SpansMutex;
+	static long GetSystemUTCOffset(const time_t TheTime) { struct tm UTC; if (0 != localtime_r(&TheTime, &UTC)) return(UTC.tm_gmtoff); return(0); };
+	void AddChunk(const time_t TheTime);
+};
+long LocalTimeBoundaries::GetUTCOffset(const time_t TheTime)
+{
+	std::lock_guard<std::mutex> lock(SpansMutex);
+	for (;;)
+	{
+		auto iter = std::upper_bound(Spans.begin(), Spans.end(), TheTime, [](const time_t a, const Span& b) { return(a < b.Start); });
+		if ((iter != Spans.begin()) && (TheTime < (iter - 1)->End))
+			return((iter - 1)->Offset);
+		AddChunk(TheTime);
+	}
+}
+void LocalTimeBoundaries::AddChunk(const time_t TheTime)
+{
+	const time_t ChunkStart = TheTime - (((TheTime % ChunkSize) + ChunkSize) % ChunkSize);
+	const time_t ChunkEnd = ChunkStart + ChunkSize;
+	time_t SpanStart = ChunkStart;
+	long SpanOffset = GetSystemUTCOffset(ChunkStart);
+	for (time_t Previous = ChunkStart; Previous < ChunkEnd;)
+	{
+		const time_t Probe = std::min(Previous + ProbeStep, ChunkEnd);
+		const long ProbeOffset = GetSystemUTCOffset(Probe);
+		if (ProbeOffset != SpanOffset)
+		{
+			// binary search for the first second with the new offset
+			time_t Low = Previous, High = Probe;
+			while (High - Low > 1)
+			{
+				const time_t Middle = Low + (High - Low) / 2;
+				if (GetSystemUTCOffset(Middle) == SpanOffset)
+					Low = Middle;
+				else
+					High = Middle;
+			}
+			Spans.push_back({ SpanStart, High, SpanOffset });
+			SpanStart = High;
+			SpanOffset = ProbeOffset;
+		}
+		Previous = Probe;
+	}
+	Spans.push_back({ SpanStart, ChunkEnd, SpanOffset });
+	std::sort(Spans.begin(), Spans.end(), [](const Span& a, const Span& b) { return(a.Start < b.Start); });
+}
+int LocalTimeBoundaries::GetMinuteOfDay(const time_t TheTime)
+{
+	const time_t LocalTime = TheTime + GetUTCOffset(TheTime);
+	return(int((((LocalTime % SecondsPerDay) + SecondsPerDay) % SecondsPerDay) / 60));
+}
+time_t LocalTimeBoundaries::GetLocalMidnight(const time_t TheTime)
+{
+	const long Offset = GetUTCOffset(TheTime);
+	const time_t LocalTime = TheTime + Offset;
+	const time_t LocalMidnight = LocalTime - (((LocalTime % SecondsPerDay) + SecondsPerDay) % SecondsPerDay);
+	// If the offset changed since midnight, midnight has to be converted using the offset that was in effect then.
+	time_t rval = LocalMidnight - Offset;
+	const long MidnightOffset = GetUTCOffset(rval);
+	if (MidnightOffset != Offset)
+	{
+		rval = LocalMidnight - MidnightOffset;
+		if (GetUTCOffset(rval) != MidnightOffset)	// midnight fell in a DST gap, so the day starts at the transition
+		{
+			time_t Low = LocalMidnight - std::max(Offset, MidnightOffset), High = TheTime;
+			while (High - Low > 1)
+			{
+				const time_t Middle = Low + (High - Low) / 2;
+				if (GetUTCOffset(Middle) == Offset)
+					High = Middle;
+				else
+					Low = Middle;
+			}
+			rval = High;
+		}
+	}
+	// If the clocks went back across midnight, midnight happened twice and the day starts at the first one.
+	const long EarlierOffset = GetUTCOffset(rval - 1);
+	if ((EarlierOffset > GetUTCOffset(rval)) && (GetUTCOffset(LocalMidnight - EarlierOffset) == EarlierOffset))
+		rval = LocalMidnight - EarlierOffset;
+	return(rval);
+}
+LocalTimeBoundaries LocalTime;
+/////////////////////////////////////////////////////////////////////////////
+inline double CelsiusToFahrenheit(const double Celsius) { return((Celsius * 9.0 / 5.0) + 32.0); }
+template <size_t N> class MRTGColumns;
 class  TempestObservation {
 public:
 	time_t Time;
-	std::string WriteCache(void) const;
-	bool ReadCache(const std::string& data);
+	void WriteCache(std::ostream& CacheFile) const;
+	bool ReadCache(std::istream& CacheFile);
 	TempestObservation() : 
 		Time(0), 
 		Temperature(0), 
@@ -65,40 +325,70 @@ public:
 		WindSpeed(0),
 		WindSpeedMin(DBL_MAX),
 		WindSpeedMax(-DBL_MAX),
-		WindDirection(0),
+		WindX(0),
+		WindY(0),
 		WindInterval(0),
 		OutsidePressure(0),
 		OutsidePressureMin(DBL_MAX),
 		OutsidePressureMax(-DBL_MAX),
+		Illuminance(0),
+		UV(0),
+		UVMax(0),
+		SolarRadiation(0),
+		SolarRadiationMax(0),
+		Rain(0),
+		LightningDistance(0),
+		LightningCount(0),
+		PrecipitationType(0),
 		Battery(DBL_MAX),
 		ReportingInterval(0),
 		Averages(0) { };
-	TempestObservation(const std::string& data);
-	double GetTemperature(const bool Fahrenheit = false) const { if (Fahrenheit) return((Temperature * 9.0 / 5.0) + 32.0); return(Temperature); };
-	double GetTemperatureMin(const bool Fahrenheit = false) const { if (Fahrenheit) return(std::min(((Temperature * 9.0 / 5.0) + 32.0), ((TemperatureMin * 9.0 / 5.0) + 32.0))); return(std::min(Temperature, TemperatureMin)); };
-	double GetTemperatureMax(const bool Fahrenheit = false) const { if (Fahrenheit) return(std::max(((Temperature * 9.0 / 5.0) + 32.0), ((TemperatureMax * 9.0 / 5.0) + 32.0))); return(std::max(Temperature, TemperatureMax)); };
+	TempestObservation(const std::string_view data);
+	TempestObservation(const double(&obs)[18]) : TempestObservation() { SetObservation(obs); };
+	bool ReadJSON(const std::string_view JSonData);
+	bool ReadJsonCpp(const std::string_view JSonData);
+	static bool ParseJSON(const std::string_view JSonData, double(&obs)[18]);
+	static bool ParseJsonCpp(const std::string_view JSonData, double(&obs)[18]);
+	static bool ParseObservation(const std::string_view JSonData, double(&obs)[18]) { return(ParseJSON(JSonData, obs) || ParseJsonCpp(JSonData, obs)); };
+	double GetTemperature(const bool Fahrenheit = false) const { if (Fahrenheit) return(CelsiusToFahrenheit(Temperature)); return(Temperature); };
+	double GetTemperatureMin(const bool Fahrenheit = false) const { if (Fahrenheit) return(std::min(CelsiusToFahrenheit(Temperature), CelsiusToFahrenheit(TemperatureMin))); return(std::min(Temperature, TemperatureMin)); };
+	double GetTemperatureMax(const bool Fahrenheit = false) const { if (Fahrenheit) return(std::max(CelsiusToFahrenheit(Temperature), CelsiusToFahrenheit(TemperatureMax))); return(std::max(Temperature, TemperatureMax)); };
 	//void SetMinMax(const Govee_Temp& a);
 	double GetWindSpeed(void) const { return(WindSpeed); };
 	double GetWindSpeedMin(void) const { return(std::min(WindSpeed, WindSpeedMin)); };
 	double GetWindSpeedMax(void) const { return(std::max(WindSpeed, WindSpeedMax)); };
+	int GetWindDirection(void) const { return(GetWindBearing(WindX, WindY)); };
+	static int GetWindBearing(const double X, const double Y);
 	double GetOutsidePressure(void) const { return(OutsidePressure); };
 	double GetOutsidePressureMin(void) const { return(std::min(OutsidePressure, OutsidePressureMin)); };
 	double GetOutsidePressureMax(void) const { return(std::max(OutsidePressure, OutsidePressureMax)); };
 	double GetHumidity(void) const { return(Humidity); };
 	double GetHumidityMin(void) const { return(std::min(Humidity, HumidityMin)); };
 	double GetHumidityMax(void) const { return(std::max(Humidity, HumidityMax)); };
+	double GetIlluminance(void) const { return(Illuminance); };
+	double GetUV(void) const { return(UV); };
+	double GetUVMax(void) const { return(std::max(UV, UVMax)); };
+	double GetSolarRadiation(void) const { return(SolarRadiation); };
+	double GetSolarRadiationMax(void) const { return(std::max(SolarRadiation, SolarRadiationMax)); };
+	double GetRain(void) const { return(Rain); };
+	double GetLightningDistance(void) const { return(LightningDistance); };
+	int GetLightningCount(void) const { return(LightningCount); };
+	int GetPrecipitationType(void) const { return(PrecipitationType); };
 	double GetBattery(void) const { return(Battery); };
 	enum granularity { day, week, month, year };
 	void NormalizeTime(granularity type);
 	granularity GetTimeGranularity(void) const;
 	bool IsValid(void) const { return(Averages > 0); };
 	TempestObservation& operator +=(const TempestObservation& b);
+	template <size_t N> friend class MRTGColumns;
+	friend class TempestColumns;
 protected:
 	int Averages;
 	double WindSpeed;
 	double WindSpeedMin;
 	double WindSpeedMax;
-	int WindDirection;
+	double WindX;	// east and north components of the direction the wind is from, weighted by speed, so they average like every other field
+	double WindY;
 	int WindInterval;
 	double OutsidePressure;
 	double OutsidePressureMin;
@@ -109,25 +399,68 @@ protected:
 	double Humidity;
 	double HumidityMin;
 	double HumidityMax;
-	//auto illuminance = observation[0][5].asInt();
-	//auto UV = observation[0][5].asFloat();
-	//auto solar_radiation = observation[0][5].asInt();
-	//auto rain_accumulation_over_the_previous_minute = observation[0][5].asFloat();
-	//auto precipitation_type = observation[0][5].asInt();
-	//auto lightning_strike_average_distance = observation[0][5].asInt();
-	//auto lightning_strike_count = observation[0][5].asInt();
+	// The light, rain and lightning values are floats since they're only ever drawn, which keeps each ring slot small.
+	float Illuminance;	// lux, averaged
+	float UV;	// index, averaged
+	float UVMax;
+	float SolarRadiation;	// W/m^2, averaged
+	float SolarRadiationMax;
+	float Rain;	// mm, summed over the sample
+	float LightningDistance;	// km, average over the strikes
+	int LightningCount;	// summed over the sample
+	uint8_t PrecipitationType;	// 0 none, 1 rain, 2 hail, 3 rain and hail. The highest seen over the sample.
 	double Battery;
 	int ReportingInterval;
+	bool SetObservation(const double(&obs)[18]);
 };
-TempestObservation::TempestObservation(const std::string& JSonData)
+TempestObservation::TempestObservation(const std::string_view JSonData) : TempestObservation()
+{
+	if (!ReadJSON(JSonData))
+		ReadJsonCpp(JSonData);
+}
+// Sets the values from the 18 element obs array of an obs_st message
+//	{"serial_number":"ST-00145757","type":"obs_st","hub_sn":"HB-00147479","obs":[[1718217086,1.58,2.25,3.22,340,3,1025.33,14.58,60.34,138057,10.17,1150,0.000000,0,0,0,2.805,1]],"firmware_revision":176}
+bool TempestObservation::SetObservation(const double(&obs)[18])
+{
+	Time = time_t(obs[0]);
+	WindSpeedMin = obs[1] * 1.9438445; // data is recorded in m/s and I want it in knots
+	WindSpeed = obs[2] * 1.9438445; // data is recorded in m/s and I want it in knots
+	WindSpeedMax = obs[3] * 1.9438445; // data is recorded in m/s and I want it in knots
+	WindX = WindSpeed * std::sin(obs[4] * M_PI / 180.0);
+	WindY = WindSpeed * std::cos(obs[4] * M_PI / 180.0);
+	WindInterval = int(obs[5]);
+	OutsidePressure = OutsidePressureMin = OutsidePressureMax = obs[6];
+	Temperature = TemperatureMin = TemperatureMax = obs[7];
+	Humidity = HumidityMin = HumidityMax = obs[8];
+	Illuminance = float(obs[9]);
+	UV = UVMax = float(obs[10]);
+	SolarRadiation = SolarRadiationMax = float(obs[11]);
+	Rain = float(obs[12]);	// accumulation over the previous minute
+	PrecipitationType = uint8_t(obs[13]);
+	LightningDistance = float(obs[14]);
+	LightningCount = int(obs[15]);
+	Battery = obs[16];
+	Averages = ReportingInterval = int(obs[17]);
+	return(IsValid());
+}
+// Single pass parse of the obs array of an obs_st message with no allocations
+bool TempestObservation::ParseJSON(const std::string_view JSonData, double(&obs)[18])
+{
+	bool rval = false;
+	if (GetJSONString(JSonData, "type") == "obs_st")
+		rval = GetJSONNumberArray(JSonData, "obs", obs, 18, true);
+	return(rval);
+}
+// Full jsoncpp parse, used when ParseJSON() doesn't recognize the layout of the message.
+bool TempestObservation::ParseJsonCpp(const std::string_view JSonData, double(&obs)[18])
 {
+	bool rval = false;
 	// https://github.com/open-source-parsers/jsoncpp
-	const auto rawJsonLength = static_cast<int>(JSonData.length());
 	JSONCPP_STRING err;
 	Json::Value root;
 	Json::CharReaderBuilder builder;
 	const std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
-	if (!reader->parse(JSonData.c_str(), JSonData.c_str() + rawJsonLength, &root, &err))
+	if (!reader->parse(JSonData.data(), JSonData.data() + JSonData.length(), &root, &err))
 	{
 		if (ConsoleVerbosity > 0)
 			std::cout << "json reader error" << std::endl;
@@ -141,57 +474,96 @@ TempestObservation::TempestObservation(const std::string& JSonData)
 			if (observation.size() == 1)
 				if (observation[0].size() == 18)
 				{
-					//	{"serial_number":"ST-00145757","type":"obs_st","hub_sn":"HB-00147479","obs":[[1718217086,1.58,2.25,3.22,340,3,1025.33,14.58,60.34,138057,10.17,1150,0.000000,0,0,0,2.805,1]],"firmware_revision":176}
-					Time = observation[0][0].asLargestInt();
-					WindSpeedMin = observation[0][1].asDouble() * 1.9438445; // data is recorded in m/s and I want it in knots
-					WindSpeed = observation[0][2].asDouble() * 1.9438445; // data is recorded in m/s and I want it in knots
-					WindSpeedMax = observation[0][3].asDouble() * 1.9438445; // data is recorded in m/s and I want it in knots
-					WindDirection = observation[0][4].asInt();
-					WindInterval = observation[0][5].asInt();
-					OutsidePressure = OutsidePressureMin = OutsidePressureMax = observation[0][6].asDouble();
-					Temperature = TemperatureMin = TemperatureMax = observation[0][7].asDouble();
-					Humidity = HumidityMin = HumidityMax = observation[0][8].asDouble();
-					auto illuminance = observation[0][9].asInt();
-					auto UV = observation[0][10].asDouble();
-					auto solar_radiation = observation[0][11].asInt();
-					auto rain_accumulation_over_the_previous_minute = observation[0][12].asDouble();
-					auto precipitation_type = observation[0][13].asInt();
-					auto lightning_strike_average_distance = observation[0][14].asInt();
-					auto lightning_strike_count = observation[0][15].asInt();
-					Battery = observation[0][16].asDouble();
-					Averages = ReportingInterval = observation[0][17].asInt();
+					for (Json::ArrayIndex index = 0; index < 18; index++)
+						obs[index] = observation[0][index].asDouble();
+					rval = true;
 				}
 		}
 	}
+	return(rval);
 }
-std::string TempestObservation::WriteCache(void) const
+bool TempestObservation::ReadJSON(const std::string_view JSonData)
 {
-	std::ostringstream ssValue;
-	ssValue << Time;
-	ssValue << "\t" << Temperature;
-	ssValue << "\t" << TemperatureMin;
-	ssValue << "\t" << TemperatureMax;
-	ssValue << "\t" << Humidity;
-	ssValue << "\t" << HumidityMin;
-	ssValue << "\t" << HumidityMax;
-	ssValue << "\t" << Battery;
-	ssValue << "\t" << Averages;
-	return(ssValue.str());
+	double obs[18];
+	return(ParseJSON(JSonData, obs) && SetObservation(obs));
 }
-bool TempestObservation::ReadCache(const std::string& data)
+bool TempestObservation::ReadJsonCpp(const std::string_view JSonData)
 {
-	bool rval = false;
-	std::istringstream ssValue(data);
-	ssValue >> Time;
-	ssValue >> Temperature;
-	ssValue >> TemperatureMin;
-	ssValue >> TemperatureMax;
-	ssValue >> Humidity;
-	ssValue >> HumidityMin;
-	ssValue >> HumidityMax;
-	ssValue >> Battery;
-	ssValue >> Averages;
-	return(rval);
+	double obs[18];
+	return(ParseJsonCpp(JSonData, obs) && SetObservation(obs));
+}
+// The cache is a binary snapshot of the fields, written in a fixed order so the layout doesn't depend on the compiler's structure packing.
+template <typename T> inline void WriteBinary(std::ostream& TheStream, const T& TheValue) { TheStream.write(reinterpret_cast<const char*>(&TheValue), sizeof(T)); }
+template <typename T> inline void ReadBinary(std::istream& TheStream, T& TheValue) { TheStream.read(reinterpret_cast<char*>(&TheValue), sizeof(T)); }
+void TempestObservation::WriteCache(std::ostream& CacheFile) const
+{
+	WriteBinary(CacheFile, int64_t(Time));
+	WriteBinary(CacheFile, int32_t(Averages));
+	WriteBinary(CacheFile, WindSpeed);
+	WriteBinary(CacheFile, WindSpeedMin);
+	WriteBinary(CacheFile, WindSpeedMax);
+	WriteBinary(CacheFile, WindX);
+	WriteBinary(CacheFile, WindY);
+	WriteBinary(CacheFile, int32_t(WindInterval));
+	WriteBinary(CacheFile, OutsidePressure);
+	WriteBinary(CacheFile, OutsidePressureMin);
+	WriteBinary(CacheFile, OutsidePressureMax);
+	WriteBinary(CacheFile, Temperature);
+	WriteBinary(CacheFile, TemperatureMin);
+	WriteBinary(CacheFile, TemperatureMax);
+	WriteBinary(CacheFile, Humidity);
+	WriteBinary(CacheFile, HumidityMin);
+	WriteBinary(CacheFile, HumidityMax);
+	WriteBinary(CacheFile, Illuminance);
+	WriteBinary(CacheFile, UV);
+	WriteBinary(CacheFile, UVMax);
+	WriteBinary(CacheFile, SolarRadiation);
+	WriteBinary(CacheFile, SolarRadiationMax);
+	WriteBinary(CacheFile, Rain);
+	WriteBinary(CacheFile, LightningDistance);
+	WriteBinary(CacheFile, int32_t(LightningCount));
+	WriteBinary(CacheFile, PrecipitationType);
+	WriteBinary(CacheFile, Battery);
+	WriteBinary(CacheFile, int32_t(ReportingInterval));
+}
+bool TempestObservation::ReadCache(std::istream& CacheFile)
+{
+	int64_t TempTime(0);
+	int32_t TempAverages(0), TempWindInterval(0), TempLightningCount(0), TempReportingInterval(0);
+	ReadBinary(CacheFile, TempTime);
+	ReadBinary(CacheFile, TempAverages);
+	ReadBinary(CacheFile, WindSpeed);
+	ReadBinary(CacheFile, WindSpeedMin);
+	ReadBinary(CacheFile, WindSpeedMax);
+	ReadBinary(CacheFile, WindX);
+	ReadBinary(CacheFile, WindY);
+	ReadBinary(CacheFile, TempWindInterval);
+	ReadBinary(CacheFile, OutsidePressure);
+	ReadBinary(CacheFile, OutsidePressureMin);
+	ReadBinary(CacheFile, OutsidePressureMax);
+	ReadBinary(CacheFile, Temperature);
+	ReadBinary(CacheFile, TemperatureMin);
+	ReadBinary(CacheFile, TemperatureMax);
+	ReadBinary(CacheFile, Humidity);
+	ReadBinary(CacheFile, HumidityMin);
+	ReadBinary(CacheFile, HumidityMax);
+	ReadBinary(CacheFile, Illuminance);
+	ReadBinary(CacheFile, UV);
+	ReadBinary(CacheFile, UVMax);
+	ReadBinary(CacheFile, SolarRadiation);
+	ReadBinary(CacheFile, SolarRadiationMax);
+	ReadBinary(CacheFile, Rain);
+	ReadBinary(CacheFile, LightningDistance);
+	ReadBinary(CacheFile, TempLightningCount);
+	ReadBinary(CacheFile, PrecipitationType);
+	ReadBinary(CacheFile, Battery);
+	ReadBinary(CacheFile, TempReportingInterval);
+	Time = TempTime;
+	Averages = TempAverages;
+	WindInterval = TempWindInterval;
+	LightningCount = TempLightningCount;
+	ReportingInterval = TempReportingInterval;
+	return(CacheFile.good());
 }
 void TempestObservation::NormalizeTime(granularity type)
 {
@@ -202,33 +574,28 @@ void TempestObservation::NormalizeTime(granularity type)
 	else if (type == month)
 		Time = (Time / MONTH_SAMPLE) * MONTH_SAMPLE;
 	else if (type == year)
-	{
-		struct tm UTC;
-		if (0 != localtime_r(&Time, &UTC))
-		{
-			UTC.tm_hour = 0;
-			UTC.tm_min = 0;
-			UTC.tm_sec = 0;
-			Time = mktime(&UTC);
-		}
-	}
+		Time = LocalTime.GetLocalMidnight(Time);
 }
 TempestObservation::granularity TempestObservation::GetTimeGranularity(void) const
 {
 	granularity rval = granularity::day;
-	struct tm UTC;
-	if (0 != localtime_r(&Time, &UTC))
-	{
-		//if (((UTC.tm_hour == 0) && (UTC.tm_min == 0)) || ((UTC.tm_hour == 23) && (UTC.tm_min == 0) && (UTC.tm_isdst == 1)))
-		if ((UTC.tm_hour == 0) && (UTC.tm_min == 0))
-			rval = granularity::year;
-		else if ((UTC.tm_hour % 2 == 0) && (UTC.tm_min == 0))
-			rval = granularity::month;
-		else if ((UTC.tm_min == 0) || (UTC.tm_min == 30))
-			rval = granularity::week;
-	}
+	const int MinuteOfDay = LocalTime.GetMinuteOfDay(Time);
+	if (MinuteOfDay == 0)
+		rval = granularity::year;
+	else if (MinuteOfDay % 120 == 0)
+		rval = granularity::month;
+	else if (MinuteOfDay % 30 == 0)
+		rval = granularity::week;
 	return(rval);
 }
+// Compass bearing in whole degrees of the direction the wind is from, given its east and north components
+int TempestObservation::GetWindBearing(const double X, const double Y)
+{
+	int rval = int(std::lround(std::atan2(X, Y) * 180.0 / M_PI));
+	if (rval < 0)
+		rval += 360;
+	return(rval % 360);
+}
 TempestObservation& TempestObservation::operator +=(const TempestObservation& b)
 {
 	if (b.IsValid())
@@ -243,9 +610,22 @@ TempestObservation& TempestObservation::operator +=(const TempestObservation& b)
 		WindSpeed = ((WindSpeed * Averages) + (b.WindSpeed * b.Averages)) / (Averages + b.Averages);
 		WindSpeedMin = std::min(std::min(WindSpeed, WindSpeedMin), b.WindSpeedMin);
 		WindSpeedMax = std::max(std::max(WindSpeed, WindSpeedMax), b.WindSpeedMax);
+		WindX = ((WindX * Averages) + (b.WindX * b.Averages)) / (Averages + b.Averages);
+		WindY = ((WindY * Averages) + (b.WindY * b.Averages)) / (Averages + b.Averages);
+		WindInterval = std::max(WindInterval, b.WindInterval);
 		OutsidePressure = ((OutsidePressure * Averages) + (b.OutsidePressure * b.Averages)) / (Averages + b.Averages);
 		OutsidePressureMin = std::min(std::min(OutsidePressure, OutsidePressureMin), b.OutsidePressureMin);
 		OutsidePressureMax = std::max(std::max(OutsidePressure, OutsidePressureMax), b.OutsidePressureMax);
+		Illuminance = ((Illuminance * Averages) + (b.Illuminance * b.Averages)) / (Averages + b.Averages);
+		UV = ((UV * Averages) + (b.UV * b.Averages)) / (Averages + b.Averages);
+		UVMax = std::max(std::max(UV, UVMax), b.UVMax);
+		SolarRadiation = ((SolarRadiation * Averages) + (b.SolarRadiation * b.Averages)) / (Averages + b.Averages);
+		SolarRadiationMax = std::max(std::max(SolarRadiation, SolarRadiationMax), b.SolarRadiationMax);
+		Rain += b.Rain;
+		if (LightningCount + b.LightningCount > 0)
+			LightningDistance = ((LightningDistance * LightningCount) + (b.LightningDistance * b.LightningCount)) / (LightningCount + b.LightningCount);
+		LightningCount += b.LightningCount;
+		PrecipitationType = std::max(PrecipitationType, b.PrecipitationType);
 		Battery = std::min(Battery, b.Battery);
 		Averages += b.Averages; // existing average + new average
 	}
@@ -321,7 +701,69 @@ std::filesystem::path GenerateLogFileName(time_t timer = 0)
 	std::filesystem::path FQFileName(LogDirectory / OutputFilename.str());
 	return(FQFileName);
 }
-bool GenerateLogFile(std::queue<std::string> & Data)
+// Received messages waiting to be appended to the log file, each followed by a newline, in a ring of bytes allocated once.
+// If the log file can't be written for long enough that the ring fills, newer messages are counted and dropped instead of growing without bound.
+const size_t LOG_SPOOL_SIZE = 1 << 20;	// about seven thousand messages
+class LogSpool
+{
+public:
+	LogSpool() : Arena(LOG_SPOOL_SIZE) {};
+	bool push(const std::string_view Line)
+	{
+		bool rval = false;
+		if (End - Begin + Line.size() + 1 <= Arena.size())
+		{
+			Append(Line.data(), Line.size());
+			Append("\n", 1);
+			rval = true;
+		}
+		else
+			Dropped++;
+		return(rval);
+	};
+	bool empty(void) const { return(Begin == End); };
+	void clear(void) { Begin = End = 0; };
+	// Points Vectors at the spooled bytes, which are in two pieces when they wrap around the end of the ring. Returns the number of pieces.
+	int fill(struct iovec(&Vectors)[2])
+	{
+		const size_t Offset = Begin % Arena.size();
+		const size_t Length = End - Begin;
+		const size_t First = std::min(Length, Arena.size() - Offset);
+		Vectors[0].iov_base = Arena.data() + Offset;
+		Vectors[0].iov_len = First;
+		Vectors[1].iov_base = Arena.data();
+		Vectors[1].iov_len = Length - First;
+		return(Length > First ? 2 : 1);
+	};
+	void consume(const size_t Bytes) { Begin += Bytes; };
+	unsigned long long Dropped = 0;	// messages that didn't fit since this was last reset
+private:
+	std::vector<char> Arena;
+	size_t Begin = 0, End = 0;	// running byte offsets, taken modulo the size of the arena
+	void Append(const char* Data, size_t Length)
+	{
+		while (Length > 0)
+		{
+			const size_t Offset = End % Arena.size();
+			const size_t Piece = std::min(Length, Arena.size() - Offset);
+			memcpy(Arena.data() + Offset, Data, Piece);
+			Data += Piece;
+			Length -= Piece;
+			End += Piece;
+		}
+	};
+};
+// The log file stays open between writes, and is only reopened when the month in its name changes or the file has been deleted or renamed.
+int LogFileDescriptor(-1);
+std::filesystem::path LogFileOpenName;
+void CloseLogFile(void)
+{
+	if (LogFileDescriptor != -1)
+		close(LogFileDescriptor);
+	LogFileDescriptor = -1;
+	LogFileOpenName.clear();
+}
+bool GenerateLogFile(LogSpool& Data)
 {
 	bool rval = false;
 	if (!LogDirectory.empty() && !Data.empty())
@@ -331,838 +773,3764 @@ bool GenerateLogFile(std::queue<std::string> & Data)
 			std::cout << "[" << getTimeISO8601() << "] GenerateLogFile: " << filename << std::endl;
 		else
 			std::cerr << "GenerateLogFile: " << filename << std::endl;
-		std::ofstream LogFile(filename, std::ios_base::out | std::ios_base::app | std::ios_base::ate);
-		if (LogFile.is_open())
+		struct stat64 OpenStat({ 0 }), NamedStat({ 0 });
+		if ((filename != LogFileOpenName) ||
+			(-1 == fstat64(LogFileDescriptor, &OpenStat)) ||
+			(-1 == stat64(filename.c_str(), &NamedStat)) ||
+			(OpenStat.st_dev != NamedStat.st_dev) ||
+			(OpenStat.st_ino != NamedStat.st_ino))
+		{
+			CloseLogFile();
+			LogFileDescriptor = open(filename.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0666);
+			if (LogFileDescriptor != -1)
+				LogFileOpenName = filename;
+			else
+				std::cerr << "[" << getTimeISO8601() << "] " << std::strerror(errno) << ": " << filename << std::endl;
+		}
+		if (LogFileDescriptor != -1)
 		{
-			while (!Data.empty())
+			rval = true;
+			while (rval && !Data.empty())
 			{
-				LogFile << Data.front() << std::endl;
-				Data.pop();
+				struct iovec Vectors[2];
+				const ssize_t Written = writev(LogFileDescriptor, Vectors, Data.fill(Vectors));
+				if (Written > 0)
+					Data.consume(Written);
+				else if (!((Written == -1) && (errno == EINTR)))
+				{
+					// whatever wasn't written stays spooled for the next attempt, which reopens the file
+					std::cerr << "[" << getTimeISO8601() << "] " << std::strerror(errno) << ": " << filename << std::endl;
+					CloseLogFile();
+					rval = false;
+				}
 			}
-			LogFile.close();
-			rval = true;
+			if (rval && LogFileSync)
+				if (-1 == fdatasync(LogFileDescriptor))
+					std::cerr << "[" << getTimeISO8601() << "] " << std::strerror(errno) << ": " << filename << std::endl;
+		}
+		if (Data.Dropped > 0)
+		{
+			if (ConsoleVerbosity > 0)
+				std::cout << "[" << getTimeISO8601() << "] Log spool was full, dropped " << Data.Dropped << " messages" << std::endl;
+			else
+				std::cerr << "Log spool was full, dropped " << Data.Dropped << " messages" << std::endl;
+			Data.Dropped = 0;
 		}
 	}
 	else
 	{
 		// clear the queued data if LogDirectory not specified
-		while (!Data.empty())
-			Data.pop();
+		Data.clear();
 	}
 	return(rval);
 }
 /////////////////////////////////////////////////////////////////////////////
-std::vector<TempestObservation> TempestMRTGLogs; // vector structure similar to MRTG Log Files
+// Fixed size circular buffer of samples, indexed newest first like an MRTG log file, stored as one contiguous array per field.
+// Adding a sample moves the head back one slot and overwrites the oldest sample, instead of shifting every sample toward the end.
+// Each column holds every sample twice, at Head + index and Head + index + N, so the newest first run of samples always starts at Head without wrapping.
+// Minimum and maximum columns hold what the getters return, so the SVG writers can scan them without clamping against the average.
+// Non-owning newest first view of the leading values of a column.
+template <class T>
+class MRTGColumnView {
+public:
+	MRTGColumnView(const T* values = nullptr, size_t count = 0) : Values(values), Count(count) {};
+	const T& operator[](size_t index) const { return(Values[index]); };
+	const T* data(void) const { return(Values); };
+	const T* begin(void) const { return(Values); };
+	const T* end(void) const { return(Values + Count); };
+	size_t size(void) const { return(Count); };
+	bool empty(void) const { return(Count == 0); };
+private:
+	const T* Values;
+	size_t Count;
+};
+template <size_t N>
+class MRTGColumns {
+public:
+	template <class T> using Column = std::array<T, N * 2>;
+	Column<time_t> Time;
+	Column<int> Averages;
+	Column<double> WindSpeed;
+	Column<double> WindSpeedMin;
+	Column<double> WindSpeedMax;
+	Column<double> WindX;
+	Column<double> WindY;
+	Column<int> WindInterval;
+	Column<double> OutsidePressure;
+	Column<double> OutsidePressureMin;
+	Column<double> OutsidePressureMax;
+	Column<double> Temperature;
+	Column<double> TemperatureMin;
+	Column<double> TemperatureMax;
+	Column<double> Humidity;
+	Column<double> HumidityMin;
+	Column<double> HumidityMax;
+	Column<float> Illuminance;
+	Column<float> UV;
+	Column<float> UVMax;
+	Column<float> SolarRadiation;
+	Column<float> SolarRadiationMax;
+	Column<float> Rain;
+	Column<float> LightningDistance;
+	Column<int> LightningCount;
+	Column<uint8_t> PrecipitationType;
+	Column<double> Battery;
+	Column<int> ReportingInterval;
+	MRTGColumns() { for (size_t index = 0; index < N; index++) SetSample(index, TempestObservation()); };
+	TempestObservation operator[](size_t index) const;
+	void set(size_t index, const TempestObservation& TheValue);
+	time_t GetTime(size_t index) const { return(Time[Head + index]); };
+	void SetTime(size_t index, const time_t TheTime) { Time[Head + index] = Time[(Head + index + N) % (N * 2)] = TheTime; };
+	void push_front(const TempestObservation& TheValue);
+	constexpr size_t size(void) const { return(N); };
+	// Number of samples from the newest up to the first one that hasn't been filled yet.
+	size_t GetValidCount(void) const { return(ValidCount); };
+	// Newest first view of the valid samples in a column. It stays valid until the ring is next changed.
+	template <class T> MRTGColumnView<T> view(const Column<T>& TheColumn) const { return(MRTGColumnView<T>(TheColumn.data() + Head, ValidCount)); };
+private:
+	size_t Head = 0;
+	size_t ValidCount = 0;
+	void SetSample(size_t index, const TempestObservation& TheValue);
+	template <class T> void SetColumn(Column<T>& TheColumn, size_t index, const T& TheValue) { TheColumn[Head + index] = TheColumn[(Head + index + N) % (N * 2)] = TheValue; };
+};
+template <size_t N>
+TempestObservation MRTGColumns<N>::operator[](size_t index) const
+{
+	TempestObservation rval;
+	index += Head;
+	rval.Time = Time[index];
+	rval.Averages = Averages[index];
+	rval.WindSpeed = WindSpeed[index];
+	rval.WindSpeedMin = WindSpeedMin[index];
+	rval.WindSpeedMax = WindSpeedMax[index];
+	rval.WindX = WindX[index];
+	rval.WindY = WindY[index];
+	rval.WindInterval = WindInterval[index];
+	rval.OutsidePressure = OutsidePressure[index];
+	rval.OutsidePressureMin = OutsidePressureMin[index];
+	rval.OutsidePressureMax = OutsidePressureMax[index];
+	rval.Temperature = Temperature[index];
+	rval.TemperatureMin = TemperatureMin[index];
+	rval.TemperatureMax = TemperatureMax[index];
+	rval.Humidity = Humidity[index];
+	rval.HumidityMin = HumidityMin[index];
+	rval.HumidityMax = HumidityMax[index];
+	rval.Illuminance = Illuminance[index];
+	rval.UV = UV[index];
+	rval.UVMax = UVMax[index];
+	rval.SolarRadiation = SolarRadiation[index];
+	rval.SolarRadiationMax = SolarRadiationMax[index];
+	rval.Rain = Rain[index];
+	rval.LightningDistance = LightningDistance[index];
+	rval.LightningCount = LightningCount[index];
+	rval.PrecipitationType = PrecipitationType[index];
+	rval.Battery = Battery[index];
+	rval.ReportingInterval = ReportingInterval[index];
+	return(rval);
+}
+template <size_t N>
+void MRTGColumns<N>::push_front(const TempestObservation& TheValue)
+{
+	Head = (Head + N - 1) % N;
+	SetSample(0, TheValue);
+	// The new sample either extends the run of valid samples or ends it.
+	if (TheValue.IsValid())
+		ValidCount = std::min(ValidCount + 1, N);
+	else
+		ValidCount = 0;
+}
+// Replacing a sample anywhere in the ring means counting the run of valid samples again.
+template <size_t N>
+void MRTGColumns<N>::set(size_t index, const TempestObservation& TheValue)
+{
+	SetSample(index, TheValue);
+	ValidCount = std::find_if(Averages.begin() + Head, Averages.begin() + Head + N, [](const int Count) { return(Count <= 0); }) - (Averages.begin() + Head);
+}
+template <size_t N>
+void MRTGColumns<N>::SetSample(size_t index, const TempestObservation& TheValue)
+{
+	SetColumn(Time, index, TheValue.Time);
+	SetColumn(Averages, index, TheValue.Averages);
+	SetColumn(WindSpeed, index, TheValue.GetWindSpeed());
+	SetColumn(WindSpeedMin, index, TheValue.GetWindSpeedMin());
+	SetColumn(WindSpeedMax, index, TheValue.GetWindSpeedMax());
+	SetColumn(WindX, index, TheValue.WindX);
+	SetColumn(WindY, index, TheValue.WindY);
+	SetColumn(WindInterval, index, TheValue.WindInterval);
+	SetColumn(OutsidePressure, index, TheValue.GetOutsidePressure());
+	SetColumn(OutsidePressureMin, index, TheValue.GetOutsidePressureMin());
+	SetColumn(OutsidePressureMax, index, TheValue.GetOutsidePressureMax());
+	SetColumn(Temperature, index, TheValue.GetTemperature());
+	SetColumn(TemperatureMin, index, TheValue.GetTemperatureMin());
+	SetColumn(TemperatureMax, index, TheValue.GetTemperatureMax());
+	SetColumn(Humidity, index, TheValue.GetHumidity());
+	SetColumn(HumidityMin, index, TheValue.GetHumidityMin());
+	SetColumn(HumidityMax, index, TheValue.GetHumidityMax());
+	SetColumn(Illuminance, index, TheValue.Illuminance);
+	SetColumn(UV, index, TheValue.UV);
+	SetColumn(UVMax, index, std::max(TheValue.UV, TheValue.UVMax));
+	SetColumn(SolarRadiation, index, TheValue.SolarRadiation);
+	SetColumn(SolarRadiationMax, index, std::max(TheValue.SolarRadiation, TheValue.SolarRadiationMax));
+	SetColumn(Rain, index, TheValue.Rain);
+	SetColumn(LightningDistance, index, TheValue.LightningDistance);
+	SetColumn(LightningCount, index, TheValue.LightningCount);
+	SetColumn(PrecipitationType, index, TheValue.PrecipitationType);
+	SetColumn(Battery, index, TheValue.GetBattery());
+	SetColumn(ReportingInterval, index, TheValue.ReportingInterval);
+}
+// Structure similar to MRTG Log Files. The current value, the accumulator of values toward the next day sample, then a ring for each granularity.
+enum class GraphType { daily, weekly, monthly, yearly };
+class TempestMRTGData {
+public:
+	TempestObservation Current;	// current value
+	TempestObservation Accumulator;	// averaged value up to DAY_SAMPLE size
+	TempestObservation WeekAccumulator;	// day samples since the last week sample
+	TempestObservation MonthAccumulator;	// day samples since the last month sample
+	TempestObservation YearAccumulator;	// day samples since the last year sample
+	MRTGColumns<DAY_COUNT> Day;
+	MRTGColumns<WEEK_COUNT> Week;
+	MRTGColumns<MONTH_COUNT> Month;
+	MRTGColumns<YEAR_COUNT> Year;
+	std::array<uint64_t, 4> Generation = {};	// indexed by GraphType, advanced by UpdateMRTGData() each time the data of that graph changes. Not cached.
+	bool empty(void) const { return(!Current.IsValid()); };
+	void WriteCache(std::ostream& CacheFile) const;
+	bool ReadCache(std::istream& CacheFile);
+};
+// Samples are written newest first, independent of where the head of each ring happens to be.
+void TempestMRTGData::WriteCache(std::ostream& CacheFile) const
+{
+	Current.WriteCache(CacheFile);
+	Accumulator.WriteCache(CacheFile);
+	WeekAccumulator.WriteCache(CacheFile);
+	MonthAccumulator.WriteCache(CacheFile);
+	YearAccumulator.WriteCache(CacheFile);
+	for (size_t index = 0; index < Day.size(); index++)
+		Day[index].WriteCache(CacheFile);
+	for (size_t index = 0; index < Week.size(); index++)
+		Week[index].WriteCache(CacheFile);
+	for (size_t index = 0; index < Month.size(); index++)
+		Month[index].WriteCache(CacheFile);
+	for (size_t index = 0; index < Year.size(); index++)
+		Year[index].WriteCache(CacheFile);
+}
+bool TempestMRTGData::ReadCache(std::istream& CacheFile)
+{
+	bool rval = Current.ReadCache(CacheFile) && Accumulator.ReadCache(CacheFile);
+	rval = rval && WeekAccumulator.ReadCache(CacheFile) && MonthAccumulator.ReadCache(CacheFile) && YearAccumulator.ReadCache(CacheFile);
+	TempestObservation TheValue;
+	for (size_t index = 0; rval && (index < Day.size()); index++)
+		if ((rval = TheValue.ReadCache(CacheFile)))
+			Day.set(index, TheValue);
+	for (size_t index = 0; rval && (index < Week.size()); index++)
+		if ((rval = TheValue.ReadCache(CacheFile)))
+			Week.set(index, TheValue);
+	for (size_t index = 0; rval && (index < Month.size()); index++)
+		if ((rval = TheValue.ReadCache(CacheFile)))
+			Month.set(index, TheValue);
+	for (size_t index = 0; rval && (index < Year.size()); index++)
+		if ((rval = TheValue.ReadCache(CacheFile)))
+			Year.set(index, TheValue);
+	return(rval);
+}
+// The rings of one device as the render threads and the web server see them. A ring is only copied again once its graphs have changed,
+// otherwise it's shared with the previous snapshot, so the yearly ring is copied once a day instead of with every render.
+class TempestMRTGSnapshot {
+public:
+	time_t CurrentTime = 0;	// time of the current value, which labels the daily graph
+	std::array<uint64_t, 4> Generation = {};	// of the TempestMRTGData each ring was copied from
+	std::shared_ptr<const MRTGColumns<DAY_COUNT>> Day;
+	std::shared_ptr<const MRTGColumns<WEEK_COUNT>> Week;
+	std::shared_ptr<const MRTGColumns<MONTH_COUNT>> Month;
+	std::shared_ptr<const MRTGColumns<YEAR_COUNT>> Year;
+	bool empty(void) const { return(Day == nullptr); };
+	void Update(const TempestMRTGData& TheData);
+};
+void TempestMRTGSnapshot::Update(const TempestMRTGData& TheData)
+{
+	if (!TheData.empty())
+	{
+		if ((Day == nullptr) || (Generation[int(GraphType::daily)] != TheData.Generation[int(GraphType::daily)]))
+			Day = std::make_shared<const MRTGColumns<DAY_COUNT>>(TheData.Day);
+		if ((Week == nullptr) || (Generation[int(GraphType::weekly)] != TheData.Generation[int(GraphType::weekly)]))
+			Week = std::make_shared<const MRTGColumns<WEEK_COUNT>>(TheData.Week);
+		if ((Month == nullptr) || (Generation[int(GraphType::monthly)] != TheData.Generation[int(GraphType::monthly)]))
+			Month = std::make_shared<const MRTGColumns<MONTH_COUNT>>(TheData.Month);
+		if ((Year == nullptr) || (Generation[int(GraphType::yearly)] != TheData.Generation[int(GraphType::yearly)]))
+			Year = std::make_shared<const MRTGColumns<YEAR_COUNT>>(TheData.Year);
+		CurrentTime = TheData.Current.Time;
+		Generation = TheData.Generation;
+	}
+}
 /////////////////////////////////////////////////////////////////////////////
-void UpdateMRTGData(TempestObservation& TheValue)
-{
-	if (TempestMRTGLogs.empty())
-	{
-		TempestMRTGLogs.resize(2 + DAY_COUNT + WEEK_COUNT + MONTH_COUNT + YEAR_COUNT);
-		TempestMRTGLogs[0] = TheValue;	// current value
-		TempestMRTGLogs[1] = TheValue;
-		for (auto index = 0; index < DAY_COUNT; index++)
-			TempestMRTGLogs[index + 2].Time = TempestMRTGLogs[index + 1].Time - DAY_SAMPLE;
-		for (auto index = 0; index < WEEK_COUNT; index++)
-			TempestMRTGLogs[index + 2 + DAY_COUNT].Time = TempestMRTGLogs[index + 1 + DAY_COUNT].Time - WEEK_SAMPLE;
-		for (auto index = 0; index < MONTH_COUNT; index++)
-			TempestMRTGLogs[index + 2 + DAY_COUNT + WEEK_COUNT].Time = TempestMRTGLogs[index + 1 + DAY_COUNT + WEEK_COUNT].Time - MONTH_SAMPLE;
-		for (auto index = 0; index < YEAR_COUNT; index++)
-			TempestMRTGLogs[index + 2 + DAY_COUNT + WEEK_COUNT + MONTH_COUNT].Time = TempestMRTGLogs[index + 1 + DAY_COUNT + WEEK_COUNT + MONTH_COUNT].Time - YEAR_SAMPLE;
+// Adds an observation to the rings of one device
+void UpdateMRTGData(TempestMRTGData& TheData, TempestObservation& TheValue)
+{
+	if (TheData.empty())
+	{
+		TheData.Current = TheValue;
+		TheData.Accumulator = TheValue;
+		// Each empty sample gets a time one sample period before the one following it, continuing from day through year.
+		time_t SampleTime = TheData.Accumulator.Time;
+		for (size_t index = 0; index < TheData.Day.size(); index++)
+			TheData.Day.SetTime(index, SampleTime = SampleTime - DAY_SAMPLE);
+		for (size_t index = 0; index < TheData.Week.size(); index++)
+			TheData.Week.SetTime(index, SampleTime = SampleTime - WEEK_SAMPLE);
+		for (size_t index = 0; index < TheData.Month.size(); index++)
+			TheData.Month.SetTime(index, SampleTime = SampleTime - MONTH_SAMPLE);
+		for (size_t index = 0; index < TheData.Year.size(); index++)
+			TheData.Year.SetTime(index, SampleTime = SampleTime - YEAR_SAMPLE);
+		for (auto& Generation : TheData.Generation)
+			Generation++;
 	}
 	else
 	{
-		if (TheValue.Time > TempestMRTGLogs[0].Time)
+		if (TheValue.Time > TheData.Current.Time)
 		{
-			TempestMRTGLogs[0] = TheValue;	// current value
-			TempestMRTGLogs[1] += TheValue; // averaged value up to DAY_SAMPLE size
+			TheData.Current = TheValue;	// current value
+			TheData.Accumulator += TheValue; // averaged value up to DAY_SAMPLE size
+			TheData.Generation[int(GraphType::daily)]++;	// the daily graph is labeled with the time of the current value
 		}
 	}
 	bool ZeroAccumulator = false;
-	auto DaySampleFirst = TempestMRTGLogs.begin() + 2;
-	auto DaySampleLast = TempestMRTGLogs.begin() + 1 + DAY_COUNT;
-	auto WeekSampleFirst = TempestMRTGLogs.begin() + 2 + DAY_COUNT;
-	auto WeekSampleLast = TempestMRTGLogs.begin() + 1 + DAY_COUNT + WEEK_COUNT;
-	auto MonthSampleFirst = TempestMRTGLogs.begin() + 2 + DAY_COUNT + WEEK_COUNT;
-	auto MonthSampleLast = TempestMRTGLogs.begin() + 1 + DAY_COUNT + WEEK_COUNT + MONTH_COUNT;
-	auto YearSampleFirst = TempestMRTGLogs.begin() + 2 + DAY_COUNT + WEEK_COUNT + MONTH_COUNT;
-	auto YearSampleLast = TempestMRTGLogs.begin() + 1 + DAY_COUNT + WEEK_COUNT + MONTH_COUNT + YEAR_COUNT;
-	// For every time difference between FakeMRTGFile[1] and FakeMRTGFile[2] that's greater than DAY_SAMPLE we shift that data towards the back.
-	while (difftime(TempestMRTGLogs[1].Time, DaySampleFirst->Time) > DAY_SAMPLE)
+	auto& Day = TheData.Day;
+	// For every time difference between the accumulator and the newest day sample that's greater than DAY_SAMPLE we add a new day sample.
+	while (difftime(TheData.Accumulator.Time, Day.GetTime(0)) > DAY_SAMPLE)
 	{
 		ZeroAccumulator = true;
-		// shuffle all the day samples toward the end
-		std::copy_backward(DaySampleFirst, DaySampleLast - 1, DaySampleLast);
-		*DaySampleFirst = TempestMRTGLogs[1];
-		DaySampleFirst->NormalizeTime(TempestObservation::granularity::day);
-		if (difftime(DaySampleFirst->Time, (DaySampleFirst + 1)->Time) > DAY_SAMPLE)
-			DaySampleFirst->Time = (DaySampleFirst + 1)->Time + DAY_SAMPLE;
-		if (DaySampleFirst->GetTimeGranularity() == TempestObservation::granularity::year)
+		TempestObservation DaySample(TheData.Accumulator);
+		DaySample.NormalizeTime(TempestObservation::granularity::day);
+		if (difftime(DaySample.Time, Day.GetTime(0)) > DAY_SAMPLE)
+			DaySample.Time = Day.GetTime(0) + DAY_SAMPLE;
+		Day.push_front(DaySample);
+		// Each day sample is added to the week, month, and year accumulators exactly once. They are emitted and restarted when their boundary closes.
+		TheData.WeekAccumulator += DaySample;
+		TheData.MonthAccumulator += DaySample;
+		TheData.YearAccumulator += DaySample;
+		const auto Granularity = DaySample.GetTimeGranularity();
+		if (Granularity == TempestObservation::granularity::year)
 		{
 			if (ConsoleVerbosity > 2)
-				std::cout << "[" << getTimeISO8601() << "] shuffling year " << timeToExcelLocal(DaySampleFirst->Time) << " > " << timeToExcelLocal(YearSampleFirst->Time) << std::endl;
-			// shuffle all the year samples toward the end
-			std::copy_backward(YearSampleFirst, YearSampleLast - 1, YearSampleLast);
-			*YearSampleFirst = TempestObservation();
-			for (auto iter = DaySampleFirst; (iter->IsValid() && ((iter - DaySampleFirst) < (12 * 24))); iter++) // One Day of day samples
-				*YearSampleFirst += *iter;
+				std::cout << "[" << getTimeISO8601() << "] shuffling year " << timeToExcelLocal(DaySample.Time) << " > " << timeToExcelLocal(TheData.Year.GetTime(0)) << std::endl;
+			TheData.Year.push_front(TheData.YearAccumulator);
+			TheData.YearAccumulator = TempestObservation();
+			TheData.Generation[int(GraphType::yearly)]++;
 		}
-		if ((DaySampleFirst->GetTimeGranularity() == TempestObservation::granularity::year) ||
-			(DaySampleFirst->GetTimeGranularity() == TempestObservation::granularity::month))
+		if ((Granularity == TempestObservation::granularity::year) ||
+			(Granularity == TempestObservation::granularity::month))
 		{
 			if (ConsoleVerbosity > 2)
-				std::cout << "[" << getTimeISO8601() << "] shuffling month " << timeToExcelLocal(DaySampleFirst->Time) << std::endl;
-			// shuffle all the month samples toward the end
-			std::copy_backward(MonthSampleFirst, MonthSampleLast - 1, MonthSampleLast);
-			*MonthSampleFirst = TempestObservation();
-			for (auto iter = DaySampleFirst; (iter->IsValid() && ((iter - DaySampleFirst) < (12 * 2))); iter++) // two hours of day samples
-				*MonthSampleFirst += *iter;
+				std::cout << "[" << getTimeISO8601() << "] shuffling month " << timeToExcelLocal(DaySample.Time) << std::endl;
+			TheData.Month.push_front(TheData.MonthAccumulator);
+			TheData.MonthAccumulator = TempestObservation();
+			TheData.Generation[int(GraphType::monthly)]++;
 		}
-		if ((DaySampleFirst->GetTimeGranularity() == TempestObservation::granularity::year) ||
-			(DaySampleFirst->GetTimeGranularity() == TempestObservation::granularity::month) ||
-			(DaySampleFirst->GetTimeGranularity() == TempestObservation::granularity::week))
+		if ((Granularity == TempestObservation::granularity::year) ||
+			(Granularity == TempestObservation::granularity::month) ||
+			(Granularity == TempestObservation::granularity::week))
 		{
 			if (ConsoleVerbosity > 2)
-				std::cout << "[" << getTimeISO8601() << "] shuffling week " << timeToExcelLocal(DaySampleFirst->Time) << std::endl;
-			// shuffle all the month samples toward the end
-			std::copy_backward(WeekSampleFirst, WeekSampleLast - 1, WeekSampleLast);
-			*WeekSampleFirst = TempestObservation();
-			for (auto iter = DaySampleFirst; (iter->IsValid() && ((iter - DaySampleFirst) < 6)); iter++) // Half an hour of day samples
-				*WeekSampleFirst += *iter;
+				std::cout << "[" << getTimeISO8601() << "] shuffling week " << timeToExcelLocal(DaySample.Time) << std::endl;
+			TheData.Week.push_front(TheData.WeekAccumulator);
+			TheData.WeekAccumulator = TempestObservation();
+			TheData.Generation[int(GraphType::weekly)]++;
 		}
 	}
 	if (ZeroAccumulator)
-		TempestMRTGLogs[1] = TempestObservation();
+		TheData.Accumulator = TempestObservation();
 }
-void ReadLoggedData(const std::filesystem::path& filename)
+// Returns the epoch time from the "obs":[[<epoch> field of an obs_st line without parsing the rest of the JSON, or zero if the line isn't an observation.
+time_t GetObservationTime(const std::string_view JSonData)
 {
-	// Only read the file if it's newer than what we may have cached
-	bool bReadFile = true;
-	struct stat64 FileStat;
-	FileStat.st_mtim.tv_sec = 0;
-	if (0 == stat64(filename.c_str(), &FileStat))	// returns 0 if the file-status information is obtained
+	time_t rval = 0;
+	const std::string_view ObsTag("\"obs\":[[");
+	auto pos = JSonData.find(ObsTag);
+	if (pos != std::string_view::npos)
+		std::from_chars(JSonData.data() + pos + ObsTag.length(), JSonData.data() + JSonData.length(), rval);
+	return(rval);
+}
+// Returns the start of the line containing the character before Offset, or the start of the next line, so that a line start is returned unchanged.
+inline size_t GetLineStart(const std::string_view Contents, const size_t Offset)
+{
+	size_t rval = 0;
+	if (Offset > 0)
 	{
-		if (!TempestMRTGLogs.empty())
-			if (FileStat.st_mtim.tv_sec < (TempestMRTGLogs.begin()->Time))	// only read the file if it more recent than existing data
-				bReadFile = false;
+		const size_t NewLine = Contents.find('\n', Offset - 1);
+		rval = (NewLine == std::string_view::npos) ? Contents.size() : NewLine + 1;
 	}
-
-	if (bReadFile)
+	return(rval);
+}
+inline std::string_view GetLine(const std::string_view Contents, const size_t LineStart)
+{
+	const size_t NewLine = Contents.find('\n', LineStart);
+	return(Contents.substr(LineStart, (NewLine == std::string_view::npos ? Contents.size() : NewLine) - LineStart));
+}
+// Binary searches a log file for the first line with an observation newer than NewestTime, relying on observations being logged in time order.
+// Each probe moves to the next line start and then forward past lines without an observation, like rapid_wind, to the first one with a time.
+size_t FindLogOffset(const std::string_view Contents, const time_t NewestTime)
+{
+	size_t Low = 0, High = Contents.size();
+	while (Low < High)
 	{
-		if (ConsoleVerbosity > 0)
-			std::cout << "[" << getTimeISO8601() << "] Reading: " << filename.string() << std::endl;
+		const size_t Middle = Low + (High - Low) / 2;
+		time_t ObservationTime = 0;
+		for (size_t LineStart = GetLineStart(Contents, Middle); (ObservationTime == 0) && (LineStart < Contents.size()); LineStart += GetLine(Contents, LineStart).size() + 1)
+			ObservationTime = GetObservationTime(GetLine(Contents, LineStart));
+		if ((ObservationTime == 0) || (ObservationTime > NewestTime))
+			High = Middle;
 		else
-			std::cerr << "Reading: " << filename.string() << std::endl;
-		std::ifstream TheFile(filename);
-		if (TheFile.is_open())
+			Low = Middle + 1;
+	}
+	return(GetLineStart(Contents, Low));
+}
+/////////////////////////////////////////////////////////////////////////////
+// rapid_wind samples arrive every 3 seconds. The last day of them is kept in a fixed ring of 8 byte samples, and the statistics the wind rose
+// needs are updated as each sample is added or falls out, so nothing ever rescans the ring. Speed is stored in cm/s and direction in degrees.
+// The mean vector winds sum the wind components as integers, so adding and removing samples for days never accumulates rounding error.
+const size_t RAPID_WIND_COUNT = 28800;	// 24 hours at 3 seconds
+const int RAPID_WIND_SECTORS = 16;
+const double RapidWindSpeedBins[] = { 1, 5, 10, 15, 20 };	// upper limits in knots of every speed band but the last, the first is calm
+const int RAPID_WIND_BANDS = sizeof(RapidWindSpeedBins) / sizeof(RapidWindSpeedBins[0]) + 1;
+// What the wind rose is drawn from, small enough to copy for the render thread
+struct RapidWindSummary
+{
+	time_t NewestTime = 0;
+	size_t Count = 0;
+	size_t Generation = 0;	// samples ever added to the ring, which only changes when the rose does
+	double MeanSpeed2 = 0, MeanDirection2 = 0;	// 2 minute mean vector wind, knots and degrees
+	double MeanSpeed10 = 0, MeanDirection10 = 0;	// 10 minute mean vector wind, knots and degrees
+	double Gust10 = 0;	// highest 3 second sample in the last 10 minutes, knots
+	std::array<std::array<unsigned int, RAPID_WIND_BANDS>, RAPID_WIND_SECTORS> Histogram = {};	// samples in the ring by direction sector and speed band
+};
+class RapidWindRing
+{
+public:
+	RapidWindRing() : Samples(RAPID_WIND_COUNT) {};
+	void push_back(const time_t Time, const double Speed, const int Direction);	// Speed in m/s
+	RapidWindSummary GetSummary(void) const;
+	size_t size(void) const { return(std::min(Next, RAPID_WIND_COUNT)); };
+private:
+	struct Sample { uint32_t Time; uint16_t Speed; uint16_t Direction; };
+	struct MeanWindow
+	{
+		time_t Length;
+		size_t Tail = 0;	// running index of the oldest sample in the window
+		int64_t SumX = 0, SumY = 0;
+		double GetSpeed(const size_t Count) const { return(Count > 0 ? std::hypot(double(SumX), double(SumY)) / (Count * 1000000.0) : 0); };
+		double GetDirection(void) const { double Degrees = std::atan2(double(SumX), double(SumY)) * 180.0 / M_PI; return(Degrees < 0 ? Degrees + 360 : Degrees); };
+	};
+	std::vector<Sample> Samples;
+	size_t Next = 0;	// running index of the next sample, its position in the ring is Next % RAPID_WIND_COUNT
+	MeanWindow Mean2{ 2 * 60 }, Mean10{ 10 * 60 };
+	std::deque<size_t> GustCandidates;	// running indexes within the 10 minute window, in order of decreasing speed
+	std::array<std::array<unsigned int, RAPID_WIND_BANDS>, RAPID_WIND_SECTORS> Histogram = {};
+	const Sample& at(const size_t RunningIndex) const { return(Samples[RunningIndex % RAPID_WIND_COUNT]); };
+	static int GetX(const Sample& TheSample);
+	static int GetY(const Sample& TheSample);
+	static int GetSector(const Sample& TheSample) { return(((TheSample.Direction * RAPID_WIND_SECTORS * 2 + 360) / 720) % RAPID_WIND_SECTORS); };
+	static int GetBand(const Sample& TheSample);
+	void Remove(MeanWindow& Window);
+};
+// Wind component of a sample in m/s scaled by 1000000, from a table of whole degrees
+int RapidWindRing::GetX(const Sample& TheSample)
+{
+	static const std::array<int, 360> Sine = []() { std::array<int, 360> Table; for (int degree = 0; degree < 360; degree++) Table[degree] = int(std::lround(std::sin(degree * M_PI / 180.0) * 10000.0)); return(Table); }();
+	return(TheSample.Speed * Sine[TheSample.Direction % 360]);
+}
+int RapidWindRing::GetY(const Sample& TheSample)
+{
+	static const std::array<int, 360> Cosine = []() { std::array<int, 360> Table; for (int degree = 0; degree < 360; degree++) Table[degree] = int(std::lround(std::cos(degree * M_PI / 180.0) * 10000.0)); return(Table); }();
+	return(TheSample.Speed * Cosine[TheSample.Direction % 360]);
+}
+int RapidWindRing::GetBand(const Sample& TheSample)
+{
+	const double Knots = TheSample.Speed * 1.9438445 / 100.0;
+	int Band = 0;
+	while ((Band < RAPID_WIND_BANDS - 1) && (Knots >= RapidWindSpeedBins[Band]))
+		Band++;
+	return(Band);
+}
+void RapidWindRing::Remove(MeanWindow& Window)
+{
+	Window.SumX -= GetX(at(Window.Tail));
+	Window.SumY -= GetY(at(Window.Tail));
+	Window.Tail++;
+}
+void RapidWindRing::push_back(const time_t Time, const double Speed, const int Direction)
+{
+	if ((Next == 0) || (Time >= time_t(at(Next - 1).Time)))	// samples older than the newest are ignored, which keeps the windows in time order
+	{
+		if (Next >= RAPID_WIND_COUNT)	// the oldest sample is about to be overwritten
 		{
-			std::vector<std::string> SortableFile;
-			std::string TheLine;
-			while (std::getline(TheFile, TheLine))
-			{
-				TempestObservation TheValue(TheLine);
-				if (TheValue.IsValid())
-					UpdateMRTGData(TheValue);
-			}
+			const size_t Oldest = Next - RAPID_WIND_COUNT;
+			Histogram[GetSector(at(Oldest))][GetBand(at(Oldest))]--;
+			for (auto Window : { &Mean2, &Mean10 })
+				if (Window->Tail == Oldest)
+					Remove(*Window);
+			if (!GustCandidates.empty() && (GustCandidates.front() == Oldest))
+				GustCandidates.pop_front();
+		}
+		Sample& TheSample(Samples[Next % RAPID_WIND_COUNT]);
+		TheSample.Time = uint32_t(Time);
+		TheSample.Speed = uint16_t(std::clamp(std::lround(Speed * 100.0), 0L, long(UINT16_MAX)));
+		TheSample.Direction = uint16_t(((Direction % 360) + 360) % 360);
+		Histogram[GetSector(TheSample)][GetBand(TheSample)]++;
+		for (auto Window : { &Mean2, &Mean10 })
+		{
+			Window->SumX += GetX(TheSample);
+			Window->SumY += GetY(TheSample);
+			while (time_t(at(Window->Tail).Time) <= Time - Window->Length)
+				Remove(*Window);
 		}
+		while (!GustCandidates.empty() && (at(GustCandidates.back()).Speed <= TheSample.Speed))
+			GustCandidates.pop_back();
+		GustCandidates.push_back(Next);
+		while (time_t(at(GustCandidates.front()).Time) <= Time - Mean10.Length)
+			GustCandidates.pop_front();
+		Next++;
 	}
 }
-// Finds log files specific to this program then reads the contents into the memory mapped structure simulating MRTG log files.
-void ReadLoggedData(void)
+RapidWindSummary RapidWindRing::GetSummary(void) const
 {
-	const std::regex LogFileRegex("weatherflow-[[:digit:]]{4}-[[:digit:]]{2}.txt");
-	if (!LogDirectory.empty())
+	RapidWindSummary rval;
+	if (Next > 0)
 	{
-		if (ConsoleVerbosity > 1)
-			std::cout << "[" << getTimeISO8601() << "] ReadLoggedData: " << LogDirectory << std::endl;
-		std::deque<std::filesystem::path> files;
-		for (auto const& dir_entry : std::filesystem::directory_iterator{ LogDirectory })
-			if (dir_entry.is_regular_file())
-				if (std::regex_match(dir_entry.path().filename().string(), LogFileRegex))
-					files.push_back(dir_entry);
-		if (!files.empty())
+		rval.NewestTime = at(Next - 1).Time;
+		rval.Count = size();
+		rval.Generation = Next;
+		rval.MeanSpeed2 = Mean2.GetSpeed(Next - Mean2.Tail) * 1.9438445;
+		rval.MeanDirection2 = Mean2.GetDirection();
+		rval.MeanSpeed10 = Mean10.GetSpeed(Next - Mean10.Tail) * 1.9438445;
+		rval.MeanDirection10 = Mean10.GetDirection();
+		rval.Gust10 = at(GustCandidates.front()).Speed * 1.9438445 / 100.0;
+		rval.Histogram = Histogram;
+	}
+	return(rval);
+}
+/////////////////////////////////////////////////////////////////////////////
+// Archive files hold the obs_st observations of one device for a month in a compact columnar form, weatherflow-<serial>-YYYY-MM.wfa next to the text log.
+// After a header of ArchiveFileMagic and ArchiveFileVersion, the file is a series of blocks of up to ARCHIVE_BLOCK_SIZE observations.
+// Each block starts with its observation count, first and last observation time, and raw and compressed sizes, which serve as the time index,
+// so a reader can skip blocks it doesn't need without decompressing them. The zlib compressed payload has one column for each of the
+// 18 values of the obs array. A column starts with its number of decimal places, then holds each value as a fixed point integer stored
+// as the zigzag varint difference from the value before it. The decimal places start at what the Tempest sends for that value and are
+// raised for the block if a value wouldn't come back as exactly the same double. Anything that still doesn't fit is stored as raw doubles.
+const char ArchiveFileMagic[4] = { 'W', 'F', 'T', 'A' };
+const uint32_t ArchiveFileVersion(1);
+const size_t ARCHIVE_BLOCK_SIZE = 256;
+const uint8_t ARCHIVE_RAW_COLUMN = 0xff;
+const uint8_t ArchiveDecimals[18] = { 0, 2, 2, 2, 0, 0, 2, 2, 2, 0, 2, 0, 6, 0, 0, 0, 3, 0 };
+using ArchiveRow = std::array<double, 18>;
+std::filesystem::path GenerateArchiveFileName(const std::filesystem::path& LogFileName, const std::string& Serial)
+{
+	const std::string Month(LogFileName.stem().string().substr(std::string("weatherflow-").length()));
+	return(LogFileName.parent_path() / ("weatherflow-" + Serial + "-" + Month + ".wfa"));
+}
+// The serial number of the device an archive file belongs to, which is between the prefix and the month of its name
+std::string GetArchiveSerial(const std::filesystem::path& ArchiveFileName)
+{
+	const std::string Stem(ArchiveFileName.stem().string());
+	const size_t Prefix(std::string("weatherflow-").length());
+	const size_t Month(std::string("-YYYY-MM").length());
+	return(Stem.length() > Prefix + Month ? Stem.substr(Prefix, Stem.length() - Prefix - Month) : std::string());
+}
+struct ArchiveBlockHeader
+{
+	uint32_t Count = 0;
+	int64_t FirstTime = 0;
+	int64_t LastTime = 0;
+	uint32_t RawSize = 0;
+	uint32_t CompressedSize = 0;
+	static const size_t Size = sizeof(Count) + sizeof(FirstTime) + sizeof(LastTime) + sizeof(RawSize) + sizeof(CompressedSize);
+};
+template <typename T> inline void AppendBinary(std::string& Buffer, const T& TheValue) { Buffer.append(reinterpret_cast<const char*>(&TheValue), sizeof(T)); }
+template <typename T> inline void TakeBinary(std::string_view& Buffer, T& TheValue) { memcpy(&TheValue, Buffer.data(), sizeof(T)); Buffer.remove_prefix(sizeof(T)); }
+inline void AppendVarint(std::string& Buffer, const int64_t TheValue)
+{
+	uint64_t ZigZag = (uint64_t(TheValue) << 1) ^ uint64_t(TheValue >> 63);
+	while (ZigZag >= 0x80)
+	{
+		Buffer.push_back(char(ZigZag | 0x80));
+		ZigZag >>= 7;
+	}
+	Buffer.push_back(char(ZigZag));
+}
+inline bool TakeVarint(std::string_view& Buffer, int64_t& TheValue)
+{
+	uint64_t ZigZag = 0;
+	for (int shift = 0; (shift < 64) && !Buffer.empty(); shift += 7)
+	{
+		const uint8_t Byte = Buffer.front();
+		Buffer.remove_prefix(1);
+		ZigZag |= uint64_t(Byte & 0x7f) << shift;
+		if (!(Byte & 0x80))
 		{
-			sort(files.begin(), files.end());
-			while (!files.empty())
+			TheValue = int64_t(ZigZag >> 1) ^ -int64_t(ZigZag & 1);
+			return(true);
+		}
+	}
+	return(false);
+}
+const double ArchivePowersOfTen[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9 };
+// Returns the fewest decimal places, starting at Decimals, that store every value of the column exactly, or ARCHIVE_RAW_COLUMN.
+uint8_t GetArchiveDecimals(const std::vector<ArchiveRow>& Rows, const size_t Column, uint8_t Decimals)
+{
+	for (; Decimals < sizeof(ArchivePowersOfTen) / sizeof(ArchivePowersOfTen[0]); Decimals++)
+		if (std::all_of(Rows.begin(), Rows.end(), [Column, Decimals](const ArchiveRow& Row)
 			{
-				ReadLoggedData(*files.begin());
-				files.pop_front();
+				const double Scaled = Row[Column] * ArchivePowersOfTen[Decimals];
+				const double Stored = double(std::llround(Scaled)) / ArchivePowersOfTen[Decimals];
+				return((std::fabs(Scaled) < 1e15) && (0 == memcmp(&Stored, &Row[Column], sizeof(Stored))));	// bitwise, so -0.0 is kept as it was
+			}))
+			return(Decimals);
+	return(ARCHIVE_RAW_COLUMN);
+}
+std::string EncodeArchiveBlock(const std::vector<ArchiveRow>& Rows)
+{
+	std::string Payload;
+	for (size_t Column = 0; Column < 18; Column++)
+	{
+		const uint8_t Decimals = GetArchiveDecimals(Rows, Column, ArchiveDecimals[Column]);
+		Payload.push_back(char(Decimals));
+		int64_t Previous = 0;
+		for (auto const& Row : Rows)
+			if (Decimals == ARCHIVE_RAW_COLUMN)
+				AppendBinary(Payload, Row[Column]);
+			else
+			{
+				const int64_t Value = std::llround(Row[Column] * ArchivePowersOfTen[Decimals]);
+				AppendVarint(Payload, Value - Previous);
+				Previous = Value;
 			}
-		}
 	}
+	uLongf CompressedSize = compressBound(Payload.size());
+	std::string Compressed(CompressedSize, '\0');
+	compress2(reinterpret_cast<Bytef*>(Compressed.data()), &CompressedSize, reinterpret_cast<const Bytef*>(Payload.data()), Payload.size(), Z_BEST_COMPRESSION);
+	Compressed.resize(CompressedSize);
+	ArchiveBlockHeader Header;
+	Header.Count = Rows.size();
+	Header.FirstTime = int64_t(Rows.front()[0]);
+	Header.LastTime = int64_t(Rows.back()[0]);
+	Header.RawSize = Payload.size();
+	Header.CompressedSize = Compressed.size();
+	std::string Block;
+	AppendBinary(Block, Header.Count);
+	AppendBinary(Block, Header.FirstTime);
+	AppendBinary(Block, Header.LastTime);
+	AppendBinary(Block, Header.RawSize);
+	AppendBinary(Block, Header.CompressedSize);
+	Block.append(Compressed);
+	return(Block);
 }
-void ReadCacheDirectory(void)
+bool ReadArchiveBlockHeader(std::string_view& Buffer, ArchiveBlockHeader& Header)
 {
-	const std::regex CacheFileRegex("^gvh-[[:xdigit:]]{12}-cache.txt");
-	if (!CacheDirectory.empty())
+	bool rval = false;
+	if (Buffer.size() >= ArchiveBlockHeader::Size)
 	{
-		if (ConsoleVerbosity > 1)
-			std::cout << "[" << getTimeISO8601() << "] ReadCacheDirectory: " << CacheDirectory << std::endl;
-		std::deque<std::filesystem::path> files;
-		for (auto const& dir_entry : std::filesystem::directory_iterator{ CacheDirectory })
-			if (dir_entry.is_regular_file())
-				if (std::regex_match(dir_entry.path().filename().string(), CacheFileRegex))
-					files.push_back(dir_entry);
-		if (!files.empty())
+		TakeBinary(Buffer, Header.Count);
+		TakeBinary(Buffer, Header.FirstTime);
+		TakeBinary(Buffer, Header.LastTime);
+		TakeBinary(Buffer, Header.RawSize);
+		TakeBinary(Buffer, Header.CompressedSize);
+		rval = (Buffer.size() >= Header.CompressedSize);
+	}
+	return(rval);
+}
+bool DecodeArchiveBlock(const ArchiveBlockHeader& Header, const std::string_view Compressed, std::vector<ArchiveRow>& Rows)
+{
+	std::string Payload(Header.RawSize, '\0');
+	uLongf RawSize = Header.RawSize;
+	if ((Z_OK != uncompress(reinterpret_cast<Bytef*>(Payload.data()), &RawSize, reinterpret_cast<const Bytef*>(Compressed.data()), Compressed.size())) || (RawSize != Header.RawSize))
+		return(false);
+	const size_t FirstRow = Rows.size();
+	Rows.resize(FirstRow + Header.Count);
+	std::string_view Buffer(Payload);
+	for (size_t Column = 0; Column < 18; Column++)
+	{
+		if (Buffer.empty())
+			return(false);
+		const uint8_t Decimals = Buffer.front();
+		Buffer.remove_prefix(1);
+		int64_t Value = 0;
+		for (size_t index = FirstRow; index < Rows.size(); index++)
+			if (Decimals == ARCHIVE_RAW_COLUMN)
+			{
+				if (Buffer.size() < sizeof(double))
+					return(false);
+				TakeBinary(Buffer, Rows[index][Column]);
+			}
+			else
+			{
+				int64_t Delta;
+				if ((Decimals >= sizeof(ArchivePowersOfTen) / sizeof(ArchivePowersOfTen[0])) || !TakeVarint(Buffer, Delta))
+					return(false);
+				Value += Delta;
+				Rows[index][Column] = double(Value) / ArchivePowersOfTen[Decimals];
+			}
+	}
+	return(true);
+}
+// Reads the observations of an archive file newer than NewestTime. Blocks that end at or before NewestTime are skipped without decompressing them.
+std::vector<ArchiveRow> ReadArchiveFile(const std::filesystem::path& filename, const time_t NewestTime = 0)
+{
+	std::vector<ArchiveRow> Rows;
+	std::ifstream TheFile(filename, std::ios_base::in | std::ios_base::binary);
+	if (TheFile.is_open())
+	{
+		std::ostringstream Contents;
+		Contents << TheFile.rdbuf();
+		const std::string FileContents(Contents.str());
+		std::string_view Buffer(FileContents);
+		uint32_t Version(0);
+		if ((Buffer.size() >= sizeof(ArchiveFileMagic) + sizeof(Version)) && (0 == memcmp(Buffer.data(), ArchiveFileMagic, sizeof(ArchiveFileMagic))))
 		{
-			sort(files.begin(), files.end());
-			while (!files.empty())
+			Buffer.remove_prefix(sizeof(ArchiveFileMagic));
+			TakeBinary(Buffer, Version);
+			ArchiveBlockHeader Header;
+			while ((Version == ArchiveFileVersion) && ReadArchiveBlockHeader(Buffer, Header))
 			{
-				std::ifstream TheFile(*files.begin());
-				if (TheFile.is_open())
+				if (Header.LastTime > NewestTime)
 				{
-					if (ConsoleVerbosity > 0)
-						std::cout << "[" << getTimeISO8601(true) << "] Reading: " << files.begin()->string() << std::endl;
-					else
-						std::cerr << "Reading: " << files.begin()->string() << std::endl;
-					std::string TheLine;
-					if (std::getline(TheFile, TheLine))
+					const size_t FirstRow = Rows.size();
+					if (!DecodeArchiveBlock(Header, Buffer.substr(0, Header.CompressedSize), Rows))
 					{
-						const std::regex CacheFirstLineRegex("^Cache: ((([[:xdigit:]]{2}:){5}))[[:xdigit:]]{2}.*");
-						// every Cache File should have a start line with the name Cache, the Bluetooth Address, and the creator version. 
-						// TODO: check to make sure the version is compatible
-						if (std::regex_match(TheLine, CacheFirstLineRegex))
-						{
-							const std::regex BluetoothAddressRegex("((([[:xdigit:]]{2}:){5}))[[:xdigit:]]{2}");
-							std::smatch BluetoothAddress;
-							if (std::regex_search(TheLine, BluetoothAddress, BluetoothAddressRegex))
-							{
-								//bdaddr_t TheBlueToothAddress({ 0 });
-								//str2ba(BluetoothAddress.str().c_str(), &TheBlueToothAddress);
-								//std::vector<Govee_Temp> FakeMRTGFile;
-								//FakeMRTGFile.reserve(2 + DAY_COUNT + WEEK_COUNT + MONTH_COUNT + YEAR_COUNT); // this might speed things up slightly
-								//while (std::getline(TheFile, TheLine))
-								//{
-								//	Govee_Temp value;
-								//	value.ReadCache(TheLine);
-								//	FakeMRTGFile.push_back(value);
-								//}
-								//if (FakeMRTGFile.size() == (2 + DAY_COUNT + WEEK_COUNT + MONTH_COUNT + YEAR_COUNT)) // simple check to see if we are the right size
-								//	GoveeMRTGLogs.insert(std::pair<bdaddr_t, std::vector<Govee_Temp>>(TheBlueToothAddress, FakeMRTGFile));
-							}
-						}
+						Rows.resize(FirstRow);
+						std::cerr << "[" << getTimeISO8601() << "] Corrupt block in: " << filename << std::endl;
+						break;
+					}
+					Rows.erase(std::remove_if(Rows.begin() + FirstRow, Rows.end(), [NewestTime](const ArchiveRow& Row) { return(time_t(Row[0]) <= NewestTime); }), Rows.end());
+				}
+				Buffer.remove_prefix(Header.CompressedSize);
+			}
+		}
+		else
+			std::cerr << "[" << getTimeISO8601() << "] Not an archive file: " << filename << std::endl;
+	}
+	return(Rows);
+}
+// The observations of a text log file by device serial number, each in file order
+std::map<std::string, std::vector<ArchiveRow>> ReadLogFileRows(const std::filesystem::path& filename)
+{
+	std::map<std::string, std::vector<ArchiveRow>> Rows;
+	std::ifstream TheFile(filename);
+	if (TheFile.is_open())
+	{
+		std::string TheLine;
+		while (std::getline(TheFile, TheLine))
+			if (GetObservationTime(TheLine) > 0)	// skips the other message types before parsing
+			{
+				const std::string_view Serial(GetJSONString(TheLine, "serial_number"));
+				double obs[18];
+				if (IsValidSerial(Serial) && TempestObservation::ParseObservation(TheLine, obs))
+				{
+					auto& DeviceRows = Rows[std::string(Serial)];
+					DeviceRows.emplace_back();
+					std::copy(std::begin(obs), std::end(obs), DeviceRows.back().begin());
+				}
+			}
+	}
+	return(Rows);
+}
+std::string EncodeArchiveFile(const std::vector<ArchiveRow>& Rows)
+{
+	std::string Contents(ArchiveFileMagic, sizeof(ArchiveFileMagic));
+	AppendBinary(Contents, ArchiveFileVersion);
+	for (size_t index = 0; index < Rows.size(); index += ARCHIVE_BLOCK_SIZE)
+		Contents.append(EncodeArchiveBlock(std::vector<ArchiveRow>(Rows.begin() + index, Rows.begin() + std::min(Rows.size(), index + ARCHIVE_BLOCK_SIZE))));
+	return(Contents);
+}
+// Where the archive file of one device has got to
+struct ArchiveWriter
+{
+	std::filesystem::path OpenName;
+	std::vector<ArchiveRow> OpenBlock;	// observations in the last block of the file
+	off_t OpenBlockOffset = 0;
+	time_t NewestTime = 0;
+	std::vector<ArchiveRow> ToBeArchived;	// obs_st values received since the archive file was last written
+};
+// Appends the observations of a device received since the last call to its archive file for the current month, when archiving is turned on.
+// The last block of the file is rewritten in place with each call until it's full, so the file is never more than one log interval behind.
+// The first time a month's archive is created, anything already in that month's text log is converted into it, so the archive is complete.
+bool GenerateArchiveFile(const std::string& Serial, ArchiveWriter& Writer)
+{
+	bool rval = false;
+	std::vector<ArchiveRow>& Rows(Writer.ToBeArchived);
+	if (!LogDirectory.empty() && LogArchive && !Rows.empty())
+	{
+		const std::filesystem::path LogFileName(GenerateLogFileName());
+		const std::filesystem::path filename(GenerateArchiveFileName(LogFileName, Serial));
+		const int ArchiveFile = open(filename.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0666);
+		if (ArchiveFile != -1)
+		{
+			struct stat64 ArchiveStat({ 0 });
+			fstat64(ArchiveFile, &ArchiveStat);
+			rval = true;
+			if ((filename != Writer.OpenName) || (ArchiveStat.st_size < Writer.OpenBlockOffset))
+			{
+				Writer.OpenBlock.clear();
+				Writer.NewestTime = 0;
+				if (ArchiveStat.st_size == 0)
+				{
+					const std::string Contents(EncodeArchiveFile(ReadLogFileRows(LogFileName)[Serial]));
+					rval = (ssize_t(Contents.size()) == pwrite(ArchiveFile, Contents.data(), Contents.size(), 0));
+					ArchiveStat.st_size = Contents.size();
+				}
+				const std::vector<ArchiveRow> Existing(ReadArchiveFile(filename));
+				if (!Existing.empty())
+					Writer.NewestTime = time_t(Existing.back()[0]);
+				Writer.OpenBlockOffset = ArchiveStat.st_size;	// a block left partly filled by an earlier run is kept as it is
+				Writer.OpenName = filename;
+				if (ConsoleVerbosity > 0)
+					std::cout << "[" << getTimeISO8601() << "] GenerateArchiveFile: " << filename << " (" << Existing.size() << " observations)" << std::endl;
+				else
+					std::cerr << "GenerateArchiveFile: " << filename << std::endl;
+			}
+			for (auto const& Row : Rows)
+				if (time_t(Row[0]) > Writer.NewestTime)
+				{
+					Writer.OpenBlock.push_back(Row);
+					Writer.NewestTime = time_t(Row[0]);
+				}
+			while (rval && !Writer.OpenBlock.empty())
+			{
+				const size_t Count = std::min(Writer.OpenBlock.size(), ARCHIVE_BLOCK_SIZE);
+				const std::string Block(EncodeArchiveBlock(std::vector<ArchiveRow>(Writer.OpenBlock.begin(), Writer.OpenBlock.begin() + Count)));
+				rval = (ssize_t(Block.size()) == pwrite(ArchiveFile, Block.data(), Block.size(), Writer.OpenBlockOffset)) && (0 == ftruncate(ArchiveFile, Writer.OpenBlockOffset + Block.size()));
+				if (Count < ARCHIVE_BLOCK_SIZE)
+					break;
+				Writer.OpenBlockOffset += Block.size();	// the block is full, so it won't be written again
+				Writer.OpenBlock.erase(Writer.OpenBlock.begin(), Writer.OpenBlock.begin() + Count);
+			}
+			if (rval && LogFileSync)
+				fdatasync(ArchiveFile);
+			if (!rval)
+			{
+				std::cerr << "[" << getTimeISO8601() << "] " << std::strerror(errno) << ": " << filename << std::endl;
+				Writer.OpenName.clear();	// start over from what's in the file next time
+			}
+			close(ArchiveFile);
+		}
+		else
+			std::cerr << "[" << getTimeISO8601() << "] " << std::strerror(errno) << ": " << filename << std::endl;
+	}
+	Rows.clear();
+	return(rval);
+}
+// Writes an archive file for each device in a text log file, reads it back, and checks every observation against the text log.
+bool ConvertLogFile(const std::filesystem::path& filename)
+{
+	bool rval = true;
+	const auto ReadStart = std::chrono::steady_clock::now();
+	const std::map<std::string, std::vector<ArchiveRow>> DeviceRows(ReadLogFileRows(filename));
+	const std::chrono::duration<double, std::milli> TextTime(std::chrono::steady_clock::now() - ReadStart);
+	std::cout << "[" << getTimeISO8601() << "] Convert: " << filename.string() << " " << std::filesystem::file_size(filename) << " bytes, read in " << std::fixed << std::setprecision(1) << TextTime.count() << " ms" << std::endl;
+	for (auto const& [Serial, Rows] : DeviceRows)
+	{
+		const std::filesystem::path ArchiveFileName(GenerateArchiveFileName(filename, Serial));
+		std::filesystem::path TempFileName(ArchiveFileName);
+		TempFileName += ".tmp";
+		const std::string Contents(EncodeArchiveFile(Rows));
+		std::ofstream ArchiveFile(TempFileName, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+		if (ArchiveFile.is_open())
+		{
+			ArchiveFile.write(Contents.data(), Contents.size());
+			ArchiveFile.close();
+			const auto ArchiveStart = std::chrono::steady_clock::now();
+			const std::vector<ArchiveRow> Replayed(ReadArchiveFile(TempFileName));
+			const std::chrono::duration<double, std::milli> ArchiveTime(std::chrono::steady_clock::now() - ArchiveStart);
+			// The values must come back as exactly the same doubles, and make the same observations as parsing the JSON does.
+			bool Identical = (Replayed.size() == Rows.size()) && (0 == memcmp(Replayed.data(), Rows.data(), Rows.size() * sizeof(ArchiveRow)));
+			std::ostringstream FromText, FromArchive;
+			for (size_t index = 0; Identical && (index < Rows.size()); index++)
+			{
+				double obs[18];
+				std::copy(Rows[index].begin(), Rows[index].end(), obs);
+				TempestObservation(obs).WriteCache(FromText);
+				std::copy(Replayed[index].begin(), Replayed[index].end(), obs);
+				TempestObservation(obs).WriteCache(FromArchive);
+			}
+			Identical = Identical && (FromText.str() == FromArchive.str());
+			if (Identical)
+				std::filesystem::rename(TempFileName, ArchiveFileName);
+			else
+				std::filesystem::remove(TempFileName);
+			std::cout << "[                   ]  " << ArchiveFileName.filename().string() << " " << Rows.size() << " observations, " << Contents.size() << " bytes, read in " << std::fixed << std::setprecision(1) << ArchiveTime.count() << " ms, round trip " << (Identical ? "identical" : "DIFFERENT, archive not written") << std::endl;
+			rval = rval && Identical;
+		}
+		else
+		{
+			std::cerr << "Unable to open: " << TempFileName << std::endl;
+			rval = false;
+		}
+	}
+	return(rval);
+}
+void ConvertLogFiles(const std::filesystem::path& name)
+{
+	const std::regex LogFileRegex("weatherflow-[[:digit:]]{4}-[[:digit:]]{2}.txt");
+	if (std::filesystem::is_directory(name))
+	{
+		std::vector<std::filesystem::path> files;
+		for (auto const& dir_entry : std::filesystem::directory_iterator{ name })
+			if (dir_entry.is_regular_file())
+				if (std::regex_match(dir_entry.path().filename().string(), LogFileRegex))
+					files.push_back(dir_entry);
+		sort(files.begin(), files.end());
+		for (auto const& filename : files)
+			ConvertLogFile(filename);
+	}
+	else
+		ConvertLogFile(name);
+}
+/////////////////////////////////////////////////////////////////////////////
+// A vertical line or a label on the time axis of a graph, in the column of the sample it belongs to.
+class TimeAxisMark {
+public:
+	enum class MarkType { separator, division, label };	// solid red line, dashed line, text below the graph
+	size_t Index;
+	MarkType Type;
+	std::string Text;
+};
+// Time axis marks for one GraphType of one device, shared by the graphs of that period, which are drawn from the same sample times.
+// The layout is kept between renders. When the samples have only moved over by one new sample, the marks are shifted one column instead of converting every sample time again.
+class TimeAxisLayout {
+public:
+	std::vector<TimeAxisMark> GetMarks(const MRTGColumnView<time_t>& SampleTimes, const GraphType graph);
+private:
+	std::mutex LayoutMutex;
+	std::vector<time_t> Times;	// sample times the marks were laid out for
+	std::vector<TimeAxisMark> Marks;
+	static void AddMarks(std::vector<TimeAxisMark>& TheMarks, const size_t index, const time_t TheTime, const GraphType graph);
+};
+typedef std::array<TimeAxisLayout, 4> TimeAxisLayouts;	// indexed by GraphType
+/////////////////////////////////////////////////////////////////////////////
+// Everything kept for one Tempest, keyed by its serial number in TempestDevices. Each device has its own rings, cache file, archive files
+// and SVG files, so two stations on the same network never average into each other. Elements of an unordered_map don't move as others are added.
+class TempestDevice {
+public:
+	TempestMRTGData MRTG;
+	RapidWindRing RapidWind;
+	ArchiveWriter Archive;
+	TempestMRTGSnapshot Snapshot;	// the newest snapshot of MRTG, shared by the SVG renders and the web server
+	std::future<void> SVGRendering;	// the render started by the most recent WriteAllSVG()
+	bool SVGFilesChecked = false;	// set once the first render has compared every graph against its file
+	std::array<uint64_t, 4> SVGGeneration = {};	// of the snapshot each graph type was last rendered from
+	size_t SVGRapidWindGeneration = 0;	// of the rapid wind summary the wind rose was last rendered from
+	TimeAxisLayouts SVGTimeAxis;	// of the SVG file renders, which only ever draw this device's samples
+};
+std::unordered_map<std::string, TempestDevice> TempestDevices;
+// The newest observation of each device, which is where reading its logs can start from. A device without data, like one whose cache file
+// was rejected, is 0, so its logs are read from the start.
+std::map<std::string, time_t> GetNewestTimes(void)
+{
+	std::map<std::string, time_t> rval;
+	for (auto const& [Serial, Device] : TempestDevices)
+		rval[Serial] = Device.MRTG.empty() ? 0 : Device.MRTG.Current.Time;
+	return(rval);
+}
+inline time_t GetNewestTime(const std::map<std::string, time_t>& NewestTimes, const std::string& Serial)
+{
+	const auto Newest = NewestTimes.find(Serial);
+	return(Newest == NewestTimes.end() ? 0 : Newest->second);
+}
+// A text log holds every device, so only what's older than all of them can be skipped, and nothing while any device has no data
+inline time_t GetLogStartTime(const std::map<std::string, time_t>& NewestTimes)
+{
+	time_t rval = NewestTimes.empty() ? 0 : std::numeric_limits<time_t>::max();
+	for (auto const& [Serial, NewestTime] : NewestTimes)
+		rval = std::min(rval, NewestTime);
+	return(rval);
+}
+void GenerateArchiveFiles(void)
+{
+	for (auto& [Serial, Device] : TempestDevices)
+		GenerateArchiveFile(Serial, Device.Archive);
+}
+/////////////////////////////////////////////////////////////////////////////
+// Only read the file if it's newer than what we may have cached
+bool LogFileNeedsReading(const std::filesystem::path& filename, const std::map<std::string, time_t>& NewestTimes)
+{
+	bool bReadFile = true;
+	struct stat64 FileStat;
+	FileStat.st_mtim.tv_sec = 0;
+	if (0 == stat64(filename.c_str(), &FileStat))	// returns 0 if the file-status information is obtained
+	{
+		const time_t NewestTime = (filename.extension() == ".wfa") ? GetNewestTime(NewestTimes, GetArchiveSerial(filename)) : GetLogStartTime(NewestTimes);
+		if (FileStat.st_mtim.tv_sec < NewestTime)	// only read the file if it more recent than existing data
+			bReadFile = false;
+	}
+	return(bReadFile);
+}
+// Calls ContentsFunction with the whole of a non-empty text log file, which is mapped rather than read. Advice is passed to madvise().
+void MapLogFile(const std::filesystem::path& filename, const std::function<void(const std::string_view)>& ContentsFunction, const int Advice = MADV_SEQUENTIAL)
+{
+	const int LogFile = open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+	if (LogFile != -1)
+	{
+		struct stat64 LogStat({ 0 });
+		if ((0 == fstat64(LogFile, &LogStat)) && (LogStat.st_size > 0))
+		{
+			void* Mapping = mmap(NULL, LogStat.st_size, PROT_READ, MAP_PRIVATE, LogFile, 0);
+			if (Mapping != MAP_FAILED)
+			{
+				madvise(Mapping, LogStat.st_size, Advice);
+				ContentsFunction(std::string_view(static_cast<const char*>(Mapping), LogStat.st_size));
+				munmap(Mapping, LogStat.st_size);
+			}
+			else
+				std::cerr << "[" << getTimeISO8601() << "] " << std::strerror(errno) << ": " << filename << std::endl;
+		}
+		close(LogFile);
+	}
+}
+// Calls LineFunction with each line of a text log file, starting from the first observation newer than NewestTime.
+// Everything before that line is skipped with a binary search, so replaying a month the cache already mostly covers only touches the end of the file.
+void ForEachLogLine(const std::filesystem::path& filename, const time_t NewestTime, const std::function<void(const std::string_view)>& LineFunction)
+{
+	MapLogFile(filename, [NewestTime, &LineFunction](const std::string_view Contents)
+		{
+			for (size_t LineStart = NewestTime > 0 ? FindLogOffset(Contents, NewestTime) : 0; LineStart < Contents.size();)
+			{
+				const std::string_view TheLine(GetLine(Contents, LineStart));
+				LineStart += TheLine.size() + 1;
+				LineFunction(TheLine);
+			}
+		});
+}
+// Parses a log file into the valid observations of each device newer than that device's newest time, in file order.
+// This doesn't touch TempestDevices, so several files can be parsed at the same time.
+using DeviceObservations = std::map<std::string, std::vector<TempestObservation>>;
+DeviceObservations ParseLoggedData(const std::filesystem::path& filename, const std::map<std::string, time_t> NewestTimes)
+{
+	DeviceObservations TheValues;
+	if (filename.extension() == ".wfa")
+	{
+		const std::string Serial(GetArchiveSerial(filename));
+		std::vector<TempestObservation>& DeviceValues(TheValues[Serial]);
+		for (auto const& Row : ReadArchiveFile(filename, GetNewestTime(NewestTimes, Serial)))
+		{
+			double obs[18];
+			std::copy(Row.begin(), Row.end(), obs);
+			TempestObservation TheValue(obs);
+			if (TheValue.IsValid())
+				DeviceValues.push_back(TheValue);
+		}
+	}
+	else
+		ForEachLogLine(filename, GetLogStartTime(NewestTimes), [&TheValues, &NewestTimes](const std::string_view TheLine)
+			{
+				// Anything at or before the newest time already in memory for its device (usually loaded from the cache) can't change the MRTG data, so skip it before parsing.
+				const time_t ObservationTime = GetObservationTime(TheLine);
+				if (ObservationTime > 0)
+				{
+					const std::string Serial(GetJSONString(TheLine, "serial_number"));
+					if (IsValidSerial(Serial) && (ObservationTime > GetNewestTime(NewestTimes, Serial)))
+					{
+						TempestObservation TheValue(TheLine);
+						if (TheValue.IsValid())
+							TheValues[Serial].push_back(TheValue);
 					}
-					TheFile.close();
 				}
+			});
+	return(TheValues);
+}
+// Merges parsed observations into TempestDevices. Anything at or before the newest time of its device when the merge starts is skipped,
+// since a file parsed in parallel may have been parsed before an archive of the same month was merged.
+void ReadLoggedData(const std::filesystem::path& filename, const DeviceObservations& TheValues, const std::map<std::string, time_t>& NewestTimes)
+{
+	if (ConsoleVerbosity > 0)
+		std::cout << "[" << getTimeISO8601() << "] Reading: " << filename.string() << std::endl;
+	else
+		std::cerr << "Reading: " << filename.string() << std::endl;
+	for (auto const& [Serial, DeviceValues] : TheValues)
+	{
+		TempestMRTGData& TheData(TempestDevices[Serial].MRTG);
+		const time_t NewestTime = GetNewestTime(NewestTimes, Serial);
+		for (auto TheValue : DeviceValues)
+			if (TheValue.Time > NewestTime)
+				UpdateMRTGData(TheData, TheValue);
+	}
+}
+void ReadLoggedData(const std::filesystem::path& filename)
+{
+	const std::map<std::string, time_t> NewestTimes(GetNewestTimes());
+	if (LogFileNeedsReading(filename, NewestTimes))
+		ReadLoggedData(filename, ParseLoggedData(filename, NewestTimes), NewestTimes);
+}
+// Reads log and archive files into TempestDevices in the order given.
+// With more than one LogReadThreads, the files are parsed concurrently but merged into TempestDevices one at a time in order,
+// so the result is exactly what reading them serially would produce. At most LogReadThreads files are held in memory at once.
+void ReadLoggedData(std::deque<std::filesystem::path> files)
+{
+	if (LogReadThreads > 1)
+	{
+		const std::map<std::string, time_t> NewestTimes(GetNewestTimes());
+		std::deque<std::pair<std::filesystem::path, std::future<DeviceObservations>>> Workers;
+		while (!files.empty() || !Workers.empty())
+		{
+			while (!files.empty() && (Workers.size() < LogReadThreads))
+			{
+				Workers.push_back(std::make_pair(*files.begin(), std::async(std::launch::async, ParseLoggedData, *files.begin(), NewestTimes)));
 				files.pop_front();
 			}
+			auto TheValues = Workers.begin()->second.get();
+			const std::map<std::string, time_t> MergeNewestTimes(GetNewestTimes());	// at merge time to match the serial order of evaluation
+			if (LogFileNeedsReading(Workers.begin()->first, MergeNewestTimes))
+				ReadLoggedData(Workers.begin()->first, TheValues, MergeNewestTimes);
+			Workers.pop_front();
+		}
+	}
+	else
+	{
+		while (!files.empty())
+		{
+			ReadLoggedData(*files.begin());
+			files.pop_front();
+		}
+	}
+}
+// Finds log files specific to this program then reads the contents into the memory mapped structure simulating MRTG log files.
+void ReadLoggedData(void)
+{
+	const std::regex LogFileRegex("weatherflow-[[:digit:]]{4}-[[:digit:]]{2}.txt");
+	const std::regex ArchiveFileRegex("weatherflow-[[:alnum:]-]+-[[:digit:]]{4}-[[:digit:]]{2}.wfa");
+	if (!LogDirectory.empty())
+	{
+		if (ConsoleVerbosity > 1)
+			std::cout << "[" << getTimeISO8601() << "] ReadLoggedData: " << LogDirectory << std::endl;
+		std::map<std::string, std::vector<std::filesystem::path>> Months;	// text logs and archive files by the YYYY-MM at the end of their names
+		for (auto const& dir_entry : std::filesystem::directory_iterator{ LogDirectory })
+			if (dir_entry.is_regular_file())
+			{
+				const std::string filename(dir_entry.path().filename().string());
+				if (std::regex_match(filename, LogFileRegex) || std::regex_match(filename, ArchiveFileRegex))
+				{
+					const std::string Stem(dir_entry.path().stem().string());
+					Months[Stem.substr(Stem.length() - std::string("YYYY-MM").length())].push_back(dir_entry);
+				}
+			}
+		// The archive files of a month are read before its text log, which then only adds what each device has newer than its archive.
+		// That covers a month where --archive was turned on or off partway, a failed archive write, and stations without an archive.
+		std::deque<std::filesystem::path> files;
+		for (auto& [Month, MonthFiles] : Months)
+		{
+			sort(MonthFiles.begin(), MonthFiles.end(), [](const std::filesystem::path& a, const std::filesystem::path& b) { return((a.extension() == ".wfa") != (b.extension() == ".wfa") ? (a.extension() == ".wfa") : (a < b)); });
+			files.insert(files.end(), MonthFiles.begin(), MonthFiles.end());
+		}
+		const std::map<std::string, time_t> NewestTimes(GetNewestTimes());
+		ReadLoggedData(files);
+		// A device first found while reading may have older observations in what was skipped because every other device already had it,
+		// so its data is dropped and the files are read again. This time every other device skips everything and the new ones are read from the start.
+		if (GetLogStartTime(NewestTimes) > 0)
+		{
+			bool Found = false;
+			for (auto& [Serial, Device] : TempestDevices)
+				if (NewestTimes.find(Serial) == NewestTimes.end())
+				{
+					Device.MRTG = *std::make_unique<TempestMRTGData>();
+					Found = true;
+				}
+			if (Found)
+				ReadLoggedData(files);
+		}
+		// Devices that never had data, like one with a rejected cache file and nothing in the logs, aren't kept
+		for (auto Device = TempestDevices.begin(); Device != TempestDevices.end();)
+			if (Device->second.MRTG.empty())
+				Device = TempestDevices.erase(Device);
+			else
+				++Device;
+	}
+}
+// Fills the rapid wind ring of each device with the last day of rapid_wind messages from the newest text log files
+void ReadRapidWindLogs(void)
+{
+	const std::regex LogFileRegex("weatherflow-[[:digit:]]{4}-[[:digit:]]{2}.txt");
+	if (!LogDirectory.empty())
+	{
+		std::vector<std::filesystem::path> files;
+		for (auto const& dir_entry : std::filesystem::directory_iterator{ LogDirectory })
+			if (dir_entry.is_regular_file())
+				if (std::regex_match(dir_entry.path().filename().string(), LogFileRegex))
+					files.push_back(dir_entry);
+		sort(files.begin(), files.end());
+		if (files.size() > 2)	// a day always falls within the last two months
+			files.erase(files.begin(), files.end() - 2);
+		const time_t Start = time(nullptr) - RAPID_WIND_COUNT * 3;
+		for (auto const& filename : files)
+			ForEachLogLine(filename, Start - 60, [Start](const std::string_view TheLine)	// the seek is by obs_st time, which is sent once a minute
+				{
+					double ob[3];
+					if ((GetJSONString(TheLine, "type") == "rapid_wind") && ReadRapidWind(TheLine, ob) && (time_t(ob[0]) > Start))
+					{
+						const std::string Serial(GetJSONString(TheLine, "serial_number"));
+						if (IsValidSerial(Serial))
+							TempestDevices[Serial].RapidWind.push_back(time_t(ob[0]), ob[1], int(ob[2]));
+					}
+				});
+		if (ConsoleVerbosity > 0)
+			for (auto const& [Serial, Device] : TempestDevices)
+				std::cout << "[" << getTimeISO8601() << "] Rapid wind samples: " << Serial << " " << Device.RapidWind.size() << std::endl;
+	}
+}
+/////////////////////////////////////////////////////////////////////////////
+// Each device has its own cache file, a versioned binary snapshot of its entire TempestMRTGData structure, current value and accumulator included.
+// If the layout of TempestObservation::WriteCache changes, CacheFileVersion must be incremented so that old caches are ignored and the logs are replayed.
+const char CacheFileMagic[4] = { 'W', 'F', 'T', 'C' };
+const uint32_t CacheFileVersion(4);
+const time_t CACHE_SAMPLE(60 * 60);		/* Write the cache file every hour */
+std::filesystem::path GenerateCacheFileName(const std::string& Serial)
+{
+	return(CacheDirectory / ("weatherflow-" + Serial + "-cache.dat"));
+}
+bool GenerateCacheFile(const std::string& Serial, const TempestMRTGData& TheData)
+{
+	bool rval = false;
+	if (!CacheDirectory.empty() && !TheData.empty())
+	{
+		std::filesystem::path CacheFileName(GenerateCacheFileName(Serial));
+		std::filesystem::path TempFileName(CacheFileName);
+		TempFileName += ".tmp";
+		if (ConsoleVerbosity > 0)
+			std::cout << "[" << getTimeISO8601() << "] Writing: " << CacheFileName.string() << std::endl;
+		else
+			std::cerr << "Writing: " << CacheFileName.string() << std::endl;
+		std::ofstream CacheFile(TempFileName, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+		if (CacheFile.is_open())
+		{
+			CacheFile.write(CacheFileMagic, sizeof(CacheFileMagic));
+			WriteBinary(CacheFile, CacheFileVersion);
+			WriteBinary(CacheFile, uint32_t(DAY_COUNT));
+			WriteBinary(CacheFile, uint32_t(WEEK_COUNT));
+			WriteBinary(CacheFile, uint32_t(MONTH_COUNT));
+			WriteBinary(CacheFile, uint32_t(YEAR_COUNT));
+			TheData.WriteCache(CacheFile);
+			CacheFile.close();
+			// Write to a temporary file and rename it so that a crash while writing never leaves a truncated cache behind.
+			if (!CacheFile.fail())
+			{
+				std::error_code ec;
+				std::filesystem::rename(TempFileName, CacheFileName, ec);
+				if (ec)
+					std::cerr << CacheFileName << " " << ec.message() << std::endl;
+				else
+					rval = true;
+			}
+		}
+	}
+	return(rval);
+}
+bool GenerateCacheFile(void)
+{
+	bool rval = false;
+	for (auto const& [Serial, Device] : TempestDevices)
+		rval = GenerateCacheFile(Serial, Device.MRTG) || rval;
+	return(rval);
+}
+// If a cache file exists and matches this version of the program, it's loaded directly into the rings of its device. ReadLoggedData() then only has to replay log entries newer than the cache.
+void ReadCacheFile(const std::string& Serial)
+{
+	std::filesystem::path CacheFileName(GenerateCacheFileName(Serial));
+	std::ifstream CacheFile(CacheFileName, std::ios_base::in | std::ios_base::binary);
+	if (CacheFile.is_open())
+	{
+		if (ConsoleVerbosity > 0)
+			std::cout << "[" << getTimeISO8601() << "] Reading: " << CacheFileName.string() << std::endl;
+		else
+			std::cerr << "Reading: " << CacheFileName.string() << std::endl;
+		char Magic[sizeof(CacheFileMagic)] = { 0 };
+		uint32_t Version(0), DayCount(0), WeekCount(0), MonthCount(0), YearCount(0);
+		CacheFile.read(Magic, sizeof(Magic));
+		ReadBinary(CacheFile, Version);
+		ReadBinary(CacheFile, DayCount);
+		ReadBinary(CacheFile, WeekCount);
+		ReadBinary(CacheFile, MonthCount);
+		ReadBinary(CacheFile, YearCount);
+		if (CacheFile.good() &&
+			(0 == std::memcmp(Magic, CacheFileMagic, sizeof(Magic))) &&
+			(Version == CacheFileVersion) &&
+			(DayCount == DAY_COUNT) &&
+			(WeekCount == WEEK_COUNT) &&
+			(MonthCount == MONTH_COUNT) &&
+			(YearCount == YEAR_COUNT))
+		{
+			auto FakeMRTGFile = std::make_unique<TempestMRTGData>();
+			if (FakeMRTGFile->ReadCache(CacheFile) && (CacheFile.peek() == std::char_traits<char>::eof())) // simple check to see if we are the right size
+			{
+				TempestDevices[Serial].MRTG = *FakeMRTGFile;
+				if (ConsoleVerbosity > 1)
+					std::cout << "[" << getTimeISO8601() << "] Cache loaded through: " << Serial << " " << timeToExcelLocal(FakeMRTGFile->Current.Time) << std::endl;
+			}
+			else
+			{
+				TempestDevices[Serial];	// known without data, so its logs are read from the start
+				std::cerr << CacheFileName << " is truncated or corrupt, ignoring it." << std::endl;
+			}
+		}
+		else
+		{
+			TempestDevices[Serial];
+			std::cerr << CacheFileName << " is from an incompatible version, ignoring it." << std::endl;
+		}
+		CacheFile.close();
+	}
+}
+// Reads the cache file of every device found in the cache directory. The cache file of versions before there was more than one device is ignored, and the logs are replayed instead.
+void ReadCacheDirectory(void)
+{
+	const std::regex CacheFileRegex("weatherflow-([[:alnum:]-]+)-cache.dat");
+	if (!CacheDirectory.empty())
+	{
+		if (ConsoleVerbosity > 1)
+			std::cout << "[" << getTimeISO8601() << "] ReadCacheDirectory: " << CacheDirectory << std::endl;
+		for (auto const& dir_entry : std::filesystem::directory_iterator{ CacheDirectory })
+		{
+			std::smatch CacheFileMatch;
+			const std::string filename(dir_entry.path().filename().string());
+			if (dir_entry.is_regular_file() && std::regex_match(filename, CacheFileMatch, CacheFileRegex) && IsValidSerial(CacheFileMatch.str(1)))
+				ReadCacheFile(CacheFileMatch.str(1));
+		}
+	}
+}
+// Newest first samples of one graph, as views of the columns the SVG writers draw. Nothing is copied out of the rings.
+class TempestSeries {
+public:
+	time_t NewestTime = 0;	// time of the newest data, which can be later than the first sample
+	MRTGColumnView<time_t> Time;
+	MRTGColumnView<double> WindSpeed;
+	MRTGColumnView<double> WindSpeedMin;
+	MRTGColumnView<double> WindSpeedMax;
+	MRTGColumnView<double> WindX;
+	MRTGColumnView<double> WindY;
+	MRTGColumnView<double> OutsidePressure;
+	MRTGColumnView<double> OutsidePressureMin;
+	MRTGColumnView<double> OutsidePressureMax;
+	MRTGColumnView<double> Temperature;
+	MRTGColumnView<double> TemperatureMin;
+	MRTGColumnView<double> TemperatureMax;
+	MRTGColumnView<double> Humidity;
+	MRTGColumnView<double> HumidityMin;
+	MRTGColumnView<double> HumidityMax;
+	MRTGColumnView<float> Illuminance;
+	MRTGColumnView<float> UV;
+	MRTGColumnView<float> UVMax;
+	MRTGColumnView<float> SolarRadiation;
+	MRTGColumnView<float> SolarRadiationMax;
+	MRTGColumnView<float> Rain;
+	MRTGColumnView<int> LightningCount;
+	MRTGColumnView<double> Battery;
+	size_t size(void) const { return(Time.size()); };
+	bool empty(void) const { return(Time.empty()); };
+};
+template <size_t N>
+TempestSeries ReadMRTGData(const MRTGColumns<N>& TheRing)
+{
+	TempestSeries rval;
+	rval.Time = TheRing.view(TheRing.Time);
+	rval.WindSpeed = TheRing.view(TheRing.WindSpeed);
+	rval.WindSpeedMin = TheRing.view(TheRing.WindSpeedMin);
+	rval.WindSpeedMax = TheRing.view(TheRing.WindSpeedMax);
+	rval.WindX = TheRing.view(TheRing.WindX);
+	rval.WindY = TheRing.view(TheRing.WindY);
+	rval.OutsidePressure = TheRing.view(TheRing.OutsidePressure);
+	rval.OutsidePressureMin = TheRing.view(TheRing.OutsidePressureMin);
+	rval.OutsidePressureMax = TheRing.view(TheRing.OutsidePressureMax);
+	rval.Temperature = TheRing.view(TheRing.Temperature);
+	rval.TemperatureMin = TheRing.view(TheRing.TemperatureMin);
+	rval.TemperatureMax = TheRing.view(TheRing.TemperatureMax);
+	rval.Humidity = TheRing.view(TheRing.Humidity);
+	rval.HumidityMin = TheRing.view(TheRing.HumidityMin);
+	rval.HumidityMax = TheRing.view(TheRing.HumidityMax);
+	rval.Illuminance = TheRing.view(TheRing.Illuminance);
+	rval.UV = TheRing.view(TheRing.UV);
+	rval.UVMax = TheRing.view(TheRing.UVMax);
+	rval.SolarRadiation = TheRing.view(TheRing.SolarRadiation);
+	rval.SolarRadiationMax = TheRing.view(TheRing.SolarRadiationMax);
+	rval.Rain = TheRing.view(TheRing.Rain);
+	rval.LightningCount = TheRing.view(TheRing.LightningCount);
+	rval.Battery = TheRing.view(TheRing.Battery);
+	if (!rval.empty())
+		rval.NewestTime = rval.Time[0];
+	return(rval);
+}
+// Returns a curated set of data columns specific to the requested graph type from the memory structure, usually a snapshot of the rings of one device.
+TempestSeries ReadMRTGData(const TempestMRTGData& TheData, const GraphType graph = GraphType::daily)
+{
+	TempestSeries rval;
+	if (!TheData.empty())
+	{
+		if (graph == GraphType::daily)
+		{
+			rval = ReadMRTGData(TheData.Day);
+			if (!rval.empty())
+				rval.NewestTime = TheData.Current.Time; // the daily graph is labeled with the most recent observation, not the most recent 5 minute sample
+		}
+		else if (graph == GraphType::weekly)
+			rval = ReadMRTGData(TheData.Week);
+		else if (graph == GraphType::monthly)
+			rval = ReadMRTGData(TheData.Month);
+		else if (graph == GraphType::yearly)
+			rval = ReadMRTGData(TheData.Year);
+	}
+	return(rval);
+}
+TempestSeries ReadMRTGData(const TempestMRTGSnapshot& TheData, const GraphType graph = GraphType::daily)
+{
+	TempestSeries rval;
+	if (!TheData.empty())
+	{
+		if (graph == GraphType::daily)
+		{
+			rval = ReadMRTGData(*TheData.Day);
+			if (!rval.empty())
+				rval.NewestTime = TheData.CurrentTime;
+		}
+		else if (graph == GraphType::weekly)
+			rval = ReadMRTGData(*TheData.Week);
+		else if (graph == GraphType::monthly)
+			rval = ReadMRTGData(*TheData.Month);
+		else if (graph == GraphType::yearly)
+			rval = ReadMRTGData(*TheData.Year);
+	}
+	return(rval);
+}
+// Newest first columns of any number of samples that aren't in a ring, like the answer to a query, laid out the way MRTGColumns holds them.
+class TempestColumns {
+public:
+	TempestColumns() = default;
+	explicit TempestColumns(const std::vector<TempestObservation>& TheValues);
+	TempestColumns(const TempestSeries& TheValues, const size_t Columns);
+	TempestSeries GetSeries(void) const;
+private:
+	std::vector<time_t> Time;
+	std::vector<double> WindSpeed, WindSpeedMin, WindSpeedMax, WindX, WindY;
+	std::vector<double> OutsidePressure, OutsidePressureMin, OutsidePressureMax;
+	std::vector<double> Temperature, TemperatureMin, TemperatureMax;
+	std::vector<double> Humidity, HumidityMin, HumidityMax;
+	std::vector<float> Illuminance, UV, UVMax, SolarRadiation, SolarRadiationMax, Rain;
+	std::vector<int> LightningCount;
+	std::vector<double> Battery;
+};
+TempestColumns::TempestColumns(const std::vector<TempestObservation>& TheValues)
+{
+	for (auto const& TheValue : TheValues)
+	{
+		Time.push_back(TheValue.Time);
+		WindSpeed.push_back(TheValue.GetWindSpeed());
+		WindSpeedMin.push_back(TheValue.GetWindSpeedMin());
+		WindSpeedMax.push_back(TheValue.GetWindSpeedMax());
+		WindX.push_back(TheValue.WindX);
+		WindY.push_back(TheValue.WindY);
+		OutsidePressure.push_back(TheValue.GetOutsidePressure());
+		OutsidePressureMin.push_back(TheValue.GetOutsidePressureMin());
+		OutsidePressureMax.push_back(TheValue.GetOutsidePressureMax());
+		Temperature.push_back(TheValue.GetTemperature());
+		TemperatureMin.push_back(TheValue.GetTemperatureMin());
+		TemperatureMax.push_back(TheValue.GetTemperatureMax());
+		Humidity.push_back(TheValue.GetHumidity());
+		HumidityMin.push_back(TheValue.GetHumidityMin());
+		HumidityMax.push_back(TheValue.GetHumidityMax());
+		Illuminance.push_back(TheValue.Illuminance);
+		UV.push_back(TheValue.UV);
+		UVMax.push_back(std::max(TheValue.UV, TheValue.UVMax));
+		SolarRadiation.push_back(TheValue.SolarRadiation);
+		SolarRadiationMax.push_back(std::max(TheValue.SolarRadiation, TheValue.SolarRadiationMax));
+		Rain.push_back(TheValue.Rain);
+		LightningCount.push_back(TheValue.LightningCount);
+		Battery.push_back(TheValue.GetBattery());
+	}
+}
+// Folds a series into at most Columns columns of neighbouring samples. Sample index goes into column index * Columns / size(), so every column gets at least one.
+// A column has the time of its newest sample, the average of the averages, the lowest of the minimums and the highest of the maximums.
+// Rain and lightning keep their largest sample, so a shower stands out at the same height it would have on its own.
+TempestColumns::TempestColumns(const TempestSeries& TheValues, const size_t Columns)
+{
+	const size_t Count = TheValues.size();
+	const size_t ColumnCount = std::min(Columns, Count);
+	for (size_t Column = 0, Start = 0; Column < ColumnCount; Column++)
+	{
+		size_t End = Start;
+		while ((End < Count) && (End * ColumnCount / Count == Column))
+			End++;
+		auto Mean = [Start, End](const auto& Values) { return(std::accumulate(Values.begin() + Start, Values.begin() + End, 0.0) / (End - Start)); };
+		auto Lowest = [Start, End](const auto& Values) { return(*std::min_element(Values.begin() + Start, Values.begin() + End)); };
+		auto Highest = [Start, End](const auto& Values) { return(*std::max_element(Values.begin() + Start, Values.begin() + End)); };
+		Time.push_back(TheValues.Time[Start]);
+		WindSpeed.push_back(Mean(TheValues.WindSpeed));
+		WindSpeedMin.push_back(Lowest(TheValues.WindSpeedMin));
+		WindSpeedMax.push_back(Highest(TheValues.WindSpeedMax));
+		WindX.push_back(Mean(TheValues.WindX));
+		WindY.push_back(Mean(TheValues.WindY));
+		OutsidePressure.push_back(Mean(TheValues.OutsidePressure));
+		OutsidePressureMin.push_back(Lowest(TheValues.OutsidePressureMin));
+		OutsidePressureMax.push_back(Highest(TheValues.OutsidePressureMax));
+		Temperature.push_back(Mean(TheValues.Temperature));
+		TemperatureMin.push_back(Lowest(TheValues.TemperatureMin));
+		TemperatureMax.push_back(Highest(TheValues.TemperatureMax));
+		Humidity.push_back(Mean(TheValues.Humidity));
+		HumidityMin.push_back(Lowest(TheValues.HumidityMin));
+		HumidityMax.push_back(Highest(TheValues.HumidityMax));
+		Illuminance.push_back(float(Mean(TheValues.Illuminance)));
+		UV.push_back(float(Mean(TheValues.UV)));
+		UVMax.push_back(Highest(TheValues.UVMax));
+		SolarRadiation.push_back(float(Mean(TheValues.SolarRadiation)));
+		SolarRadiationMax.push_back(Highest(TheValues.SolarRadiationMax));
+		Rain.push_back(Highest(TheValues.Rain));
+		LightningCount.push_back(Highest(TheValues.LightningCount));
+		Battery.push_back(Mean(TheValues.Battery));
+		Start = End;
+	}
+}
+// The series stays valid as long as the columns do
+TempestSeries TempestColumns::GetSeries(void) const
+{
+	auto view = [](const auto& TheColumn) { return(MRTGColumnView<typename std::decay_t<decltype(TheColumn)>::value_type>(TheColumn.data(), TheColumn.size())); };
+	TempestSeries rval;
+	rval.Time = view(Time);
+	rval.WindSpeed = view(WindSpeed);
+	rval.WindSpeedMin = view(WindSpeedMin);
+	rval.WindSpeedMax = view(WindSpeedMax);
+	rval.WindX = view(WindX);
+	rval.WindY = view(WindY);
+	rval.OutsidePressure = view(OutsidePressure);
+	rval.OutsidePressureMin = view(OutsidePressureMin);
+	rval.OutsidePressureMax = view(OutsidePressureMax);
+	rval.Temperature = view(Temperature);
+	rval.TemperatureMin = view(TemperatureMin);
+	rval.TemperatureMax = view(TemperatureMax);
+	rval.Humidity = view(Humidity);
+	rval.HumidityMin = view(HumidityMin);
+	rval.HumidityMax = view(HumidityMax);
+	rval.Illuminance = view(Illuminance);
+	rval.UV = view(UV);
+	rval.UVMax = view(UVMax);
+	rval.SolarRadiation = view(SolarRadiation);
+	rval.SolarRadiationMax = view(SolarRadiationMax);
+	rval.Rain = view(Rain);
+	rval.LightningCount = view(LightningCount);
+	rval.Battery = view(Battery);
+	if (!rval.empty())
+		rval.NewestTime = rval.Time[0];
+	return(rval);
+}
+// The samples a graph GraphWidth columns wide draws, one to a column. Normally that's the newest GraphWidth samples and the rest are left off.
+// With Envelope, when there are more samples than columns, every sample is folded into a column that keeps the lowest and highest values of the samples in it.
+class GraphColumns {
+private:
+	const TempestColumns Folded;	// declared before Series, which points into it
+public:
+	GraphColumns(const TempestSeries& Samples, const int GraphWidth, const bool Envelope);
+	GraphColumns(const GraphColumns&) = delete;
+	TempestSeries Series;	// one sample per column, newest first
+	size_t SampleCount;	// how many samples the columns cover, which the time axis marks are spread over
+};
+GraphColumns::GraphColumns(const TempestSeries& Samples, const int GraphWidth, const bool Envelope) :
+	Folded(Envelope && (Samples.size() > size_t(GraphWidth)) ? TempestColumns(Samples, GraphWidth) : TempestColumns()),
+	Series(Folded.GetSeries()),
+	SampleCount(Samples.size())
+{
+	if (Series.empty())
+	{
+		Series = Samples;
+		SampleCount = std::min(size_t(GraphWidth), Samples.size());
+	}
+	else
+		Series.NewestTime = Samples.NewestTime;
+}
+// Smallest and largest of the first Count values of a column. GCC vector extensions compare four lanes at a time, which maps onto SSE2/AVX or NEON min and max instructions.
+#ifdef __GNUC__
+typedef double ColumnLanes __attribute__((vector_size(4 * sizeof(double))));
+#endif
+double GetColumnMin(const double* Values, const size_t Count)
+{
+	double rval = DBL_MAX;
+	size_t index = 0;
+#ifdef __GNUC__
+	if (Count >= 4)
+	{
+		ColumnLanes Lanes;
+		std::memcpy(&Lanes, Values, sizeof(Lanes));
+		for (index = 4; index + 4 <= Count; index += 4)
+		{
+			ColumnLanes Next;
+			std::memcpy(&Next, Values + index, sizeof(Next));
+			Lanes = Next < Lanes ? Next : Lanes;
+		}
+		for (auto Lane = 0; Lane < 4; Lane++)
+			rval = std::min(rval, Lanes[Lane]);
+	}
+#endif
+	for (; index < Count; index++)
+		rval = std::min(rval, Values[index]);
+	return(rval);
+}
+double GetColumnMax(const double* Values, const size_t Count)
+{
+	double rval = -DBL_MAX;
+	size_t index = 0;
+#ifdef __GNUC__
+	if (Count >= 4)
+	{
+		ColumnLanes Lanes;
+		std::memcpy(&Lanes, Values, sizeof(Lanes));
+		for (index = 4; index + 4 <= Count; index += 4)
+		{
+			ColumnLanes Next;
+			std::memcpy(&Next, Values + index, sizeof(Next));
+			Lanes = Next > Lanes ? Next : Lanes;
+		}
+		for (auto Lane = 0; Lane < 4; Lane++)
+			rval = std::max(rval, Lanes[Lane]);
+	}
+#endif
+	for (; index < Count; index++)
+		rval = std::max(rval, Values[index]);
+	return(rval);
+}
+// The float and int columns are only ever scanned for a graph's scale, so they don't need the vector version.
+template <class T> double GetColumnMax(const T* Values, const size_t Count) { return(Count > 0 ? double(*std::max_element(Values, Values + Count)) : -DBL_MAX); }
+/////////////////////////////////////////////////////////////////////////////
+void TimeAxisLayout::AddMarks(std::vector<TimeAxisMark>& TheMarks, const size_t index, const time_t TheTime, const GraphType graph)
+{
+	struct tm UTC;
+	if (0 != localtime_r(&TheTime, &UTC))
+	{
+		if (graph == GraphType::daily)
+		{
+			if (UTC.tm_min == 0)
+			{
+				if (UTC.tm_hour == 0)
+					TheMarks.push_back({ index, TimeAxisMark::MarkType::separator, "" });
+				else
+					TheMarks.push_back({ index, TimeAxisMark::MarkType::division, "" });
+				if (UTC.tm_hour % 2 == 0)
+					TheMarks.push_back({ index, TimeAxisMark::MarkType::label, std::to_string(UTC.tm_hour) });
+			}
+		}
+		else if (graph == GraphType::weekly)
+		{
+			const std::string Weekday[] = { "Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat" };
+			if ((UTC.tm_hour == 0) && (UTC.tm_min == 0))
+			{
+				if (UTC.tm_wday == 0)
+					TheMarks.push_back({ index, TimeAxisMark::MarkType::separator, "" });
+				else
+					TheMarks.push_back({ index, TimeAxisMark::MarkType::division, "" });
+			}
+			else if ((UTC.tm_hour == 12) && (UTC.tm_min == 0))
+				TheMarks.push_back({ index, TimeAxisMark::MarkType::label, Weekday[UTC.tm_wday] });
+		}
+		else if (graph == GraphType::monthly)
+		{
+			if ((UTC.tm_mday == 1) && (UTC.tm_hour == 0) && (UTC.tm_min == 0))
+				TheMarks.push_back({ index, TimeAxisMark::MarkType::separator, "" });
+			if ((UTC.tm_wday == 0) && (UTC.tm_hour == 0) && (UTC.tm_min == 0))
+				TheMarks.push_back({ index, TimeAxisMark::MarkType::division, "" });
+			else if ((UTC.tm_wday == 3) && (UTC.tm_hour == 12) && (UTC.tm_min == 0))
+				TheMarks.push_back({ index, TimeAxisMark::MarkType::label, "Week " + std::to_string(UTC.tm_yday / 7 + 1) });
+		}
+		else if (graph == GraphType::yearly)
+		{
+			const std::string Month[] = { "Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec" };
+			if ((UTC.tm_yday == 0) && (UTC.tm_mday == 1) && (UTC.tm_hour == 0) && (UTC.tm_min == 0))
+				TheMarks.push_back({ index, TimeAxisMark::MarkType::separator, "" });
+			else if ((UTC.tm_mday == 1) && (UTC.tm_hour == 0) && (UTC.tm_min == 0))
+				TheMarks.push_back({ index, TimeAxisMark::MarkType::division, "" });
+			else if ((UTC.tm_mday == 15) && (UTC.tm_hour == 0) && (UTC.tm_min == 0))
+				TheMarks.push_back({ index, TimeAxisMark::MarkType::label, Month[UTC.tm_mon] });
+		}
+	}
+}
+std::vector<TimeAxisMark> TimeAxisLayout::GetMarks(const MRTGColumnView<time_t>& SampleTimes, const GraphType graph)
+{
+	std::lock_guard<std::mutex> LayoutLock(LayoutMutex);
+	const bool Unchanged = (SampleTimes.size() == Times.size()) && std::equal(SampleTimes.begin(), SampleTimes.end(), Times.begin());
+	if (!Unchanged)
+	{
+		std::vector<TimeAxisMark> NewMarks;
+		const bool Shifted = !SampleTimes.empty() && (SampleTimes.size() - 1 <= Times.size()) && std::equal(SampleTimes.begin() + 1, SampleTimes.end(), Times.begin());
+		if (Shifted)
+		{
+			AddMarks(NewMarks, 0, SampleTimes[0], graph);
+			for (auto const& Mark : Marks)
+				if (Mark.Index + 1 < SampleTimes.size())
+					NewMarks.push_back({ Mark.Index + 1, Mark.Type, Mark.Text });
+		}
+		else
+			for (size_t index = 0; index < SampleTimes.size(); index++)
+				AddMarks(NewMarks, index, SampleTimes[index], graph);
+		Marks.swap(NewMarks);
+		Times.assign(SampleTimes.begin(), SampleTimes.end());
+	}
+	return(Marks);
+}
+// Draws the marks of the first Samples samples, spread over Count columns of a graph. Unless the samples were folded into the columns, each has its own.
+template <class SVGStream>
+void WriteTimeAxis(SVGStream& SVGFile, const std::vector<TimeAxisMark>& Marks, const size_t Samples, const size_t Count, const int GraphLeft, const int GraphTop, const int LineBottom, const int TextBaseline)
+{
+	for (auto const& Mark : Marks)
+		if (Mark.Index < Samples)
+		{
+			const size_t x = GraphLeft + Mark.Index * Count / Samples;
+			if (Mark.Type == TimeAxisMark::MarkType::separator)
+				SVGFile << "\t<line style=\"stroke:red\" x1=\"" << x << "\" y1=\"" << GraphTop << "\" x2=\"" << x << "\" y2=\"" << LineBottom << "\" />\n";
+			else if (Mark.Type == TimeAxisMark::MarkType::division)
+				SVGFile << "\t<line style=\"stroke-dasharray:1\" x1=\"" << x << "\" y1=\"" << GraphTop << "\" x2=\"" << x << "\" y2=\"" << LineBottom << "\" />\n";
+			else
+				SVGFile << "\t<text style=\"text-anchor:middle\" x=\"" << x << "\" y=\"" << TextBaseline << "\">" << Mark.Text << "</text>\n";
+		}
+}
+/////////////////////////////////////////////////////////////////////////////
+// A double written with a fixed number of decimal places, the same as std::fixed << std::setprecision(Precision)
+struct FixedPoint
+{
+	double Value;
+	int Precision;
+	FixedPoint(const double value, const int precision) : Value(value), Precision(precision) {};
+};
+std::ostream& operator<<(std::ostream& os, const FixedPoint& fp)
+{
+	const std::ios_base::fmtflags OldFlags(os.flags());
+	const std::streamsize OldPrecision(os.precision());
+	os << std::fixed << std::setprecision(fp.Precision) << fp.Value;
+	os.flags(OldFlags);
+	os.precision(OldPrecision);
+	return(os);
+}
+// Append only text buffer for building SVG files. Numbers are formatted with std::to_chars, which skips the locale and
+// stream state handling of operator<<, and clear() keeps the allocation so a buffer that's reused never grows again.
+// The output matches what a default std::ostream writes for the same values.
+class SVGBuffer
+{
+public:
+	void clear(void) { Buffer.clear(); };
+	std::string_view view(void) const { return(std::string_view(Buffer)); };
+	size_t size(void) const { return(Buffer.size()); };
+	SVGBuffer& operator<<(const char* Text) { Buffer.append(Text); return(*this); };
+	SVGBuffer& operator<<(const std::string& Text) { Buffer.append(Text); return(*this); };
+	SVGBuffer& operator<<(const std::string_view Text) { Buffer.append(Text); return(*this); };
+	SVGBuffer& operator<<(const char Character) { Buffer.push_back(Character); return(*this); };
+	template <class T, typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, char>::value && !std::is_same<T, bool>::value, int>::type = 0>
+	SVGBuffer& operator<<(const T Value) { return(Append(std::to_chars(Digits.data(), Digits.data() + Digits.size(), Value))); };
+	SVGBuffer& operator<<(const double Value) { return(Append(std::to_chars(Digits.data(), Digits.data() + Digits.size(), Value, std::chars_format::general, 6))); };
+	SVGBuffer& operator<<(const FixedPoint& Value) { return(Append(std::to_chars(Digits.data(), Digits.data() + Digits.size(), Value.Value, std::chars_format::fixed, Value.Precision))); };
+	SVGBuffer& operator<<(std::ostream& (*)(std::ostream&)) { Buffer.push_back('\n'); return(*this); };	// only std::endl is used, and there's nothing to flush
+private:
+	std::string Buffer;
+	std::array<char, 512> Digits;	// large enough for any double in fixed notation
+	SVGBuffer& Append(const std::to_chars_result Result) { Buffer.append(Digits.data(), Result.ptr); return(*this); };
+};
+/////////////////////////////////////////////////////////////////////////////
+// Writes the points of an SVG polyline or polygon. With Simplify, a point that lies on the straight line between its neighbours is left out,
+// so a flat or steady stretch of a graph becomes a single segment. A run is only merged while it continues in the same direction,
+// so every peak and trough is still drawn exactly where it was. flush() writes the last point held back and starts a new shape.
+template <class SVGStream>
+class SVGPoints
+{
+public:
+	SVGPoints(SVGStream& svgfile, const bool simplify) : SVGFile(svgfile), Simplify(simplify) {};
+	void push_back(const int x, const int y)
+	{
+		if (!Simplify)
+			Write(x, y);
+		else if (Held == 0)
+		{
+			Write(x, y);
+			AnchorX = x; AnchorY = y;
+			Held = 1;
+		}
+		else if (Held == 1)
+		{
+			PendingX = x; PendingY = y;
+			Held = 2;
+		}
+		else if ((x != PendingX) || (y != PendingY))
+		{
+			const long dx1 = PendingX - AnchorX, dy1 = PendingY - AnchorY;
+			const long dx2 = x - PendingX, dy2 = y - PendingY;
+			if (!((dx1 * dy2 == dy1 * dx2) && (dx1 * dx2 + dy1 * dy2 > 0)))	// not a continuation of the same straight line
+			{
+				Write(PendingX, PendingY);
+				AnchorX = PendingX; AnchorY = PendingY;
+			}
+			PendingX = x; PendingY = y;
+		}
+	};
+	void flush(void)
+	{
+		if (Held == 2)
+			Write(PendingX, PendingY);
+		Held = 0;
+	};
+private:
+	SVGStream& SVGFile;
+	const bool Simplify;
+	int Held = 0;	// number of points seen since the last one written, up to 2
+	int AnchorX = 0, AnchorY = 0, PendingX = 0, PendingY = 0;
+	void Write(const int x, const int y) { SVGFile << x << "," << y << " "; };
+};
+/////////////////////////////////////////////////////////////////////////////
+std::mutex SVGContentMutex;
+std::map<std::filesystem::path, size_t> SVGContentHash;	// hash of the contents of each published SVG file
+// Publishes an SVG file rendered in memory. It's written to a temporary file in the same directory, flushed to disk and renamed over the target, so a web server never serves a partial file.
+// If the contents are the same as the published file, nothing is written and only the file time is updated, which saves wear on an SD card.
+bool PublishSVG(const std::filesystem::path& SVGFileName, const std::string_view SVGContents, const time_t SVGTime)
+{
+	bool rval = false;
+	const size_t ContentHash = std::hash<std::string_view>()(SVGContents);
+	std::unique_lock<std::mutex> SVGContentLock(SVGContentMutex);
+	auto Published = SVGContentHash.find(SVGFileName);
+	if (Published == SVGContentHash.end())
+	{
+		// The first time a file is published after starting, compare against whatever is already on disk.
+		std::ifstream ExistingFile(SVGFileName, std::ios_base::in | std::ios_base::binary);
+		if (ExistingFile.is_open())
+		{
+			std::ostringstream ExistingContents;
+			ExistingContents << ExistingFile.rdbuf();
+			Published = SVGContentHash.insert(std::make_pair(SVGFileName, std::hash<std::string_view>()(ExistingContents.str()))).first;
+		}
+	}
+	const bool Unchanged = (Published != SVGContentHash.end()) && (Published->second == ContentHash);
+	SVGContentLock.unlock();
+	if (Unchanged)
+	{
+		if (ConsoleVerbosity > 1)
+			std::cout << "[" << getTimeISO8601() << "] Unchanged: " << SVGFileName.string() << std::endl;
+		rval = true;
+	}
+	else
+	{
+		const std::filesystem::path SVGTempName(SVGFileName.string() + ".tmp");
+		const int SVGFile = open(SVGTempName.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+		if (SVGFile != -1)
+		{
+			const char* Data = SVGContents.data();
+			size_t Remaining = SVGContents.size();
+			while (Remaining > 0)
+			{
+				const ssize_t Written = write(SVGFile, Data, Remaining);
+				if (Written < 0)
+				{
+					if (errno == EINTR)
+						continue;
+					break;
+				}
+				Data += Written;
+				Remaining -= Written;
+			}
+			rval = (Remaining == 0) && (0 == fsync(SVGFile));
+			rval = (0 == close(SVGFile)) && rval;
+			rval = rval && (0 == rename(SVGTempName.c_str(), SVGFileName.c_str()));
+			if (!rval)
+				unlink(SVGTempName.c_str());
+		}
+		if (rval)
+		{
+			SVGContentLock.lock();
+			SVGContentHash[SVGFileName] = ContentHash;
+			SVGContentLock.unlock();
+		}
+		else
+			std::cerr << "[" << getTimeISO8601() << "] " << std::strerror(errno) << ": " << SVGFileName << std::endl;
+	}
+	if (rval)
+	{
+		struct utimbuf SVGut({ SVGTime, SVGTime });
+		utime(SVGFileName.c_str(), &SVGut);
+	}
+	return(rval);
+}
+/////////////////////////////////////////////////////////////////////////////
+// Draws the temperature and humidity graph of a non-empty series into an SVGBuffer, or into any std::ostream.
+template <class SVGStream>
+void RenderTemperatureSVG(SVGStream& SVGFile, const TempestSeries& Samples, const std::string& Title, const GraphType graph, TimeAxisLayout& TimeAxis, const bool Fahrenheit, const bool DrawBattery, const bool MinMax, const bool Simplify = false, const bool Envelope = false)
+{
+	// By declaring these items here, I'm then basing all my other dimensions on these
+	const int SVGWidth(500);
+	const int SVGHeight(135);
+	const int FontSize(12);
+	const int TickSize(2);
+	int GraphWidth = SVGWidth - (FontSize * 5);
+	const bool DrawHumidity = Samples.Humidity[0] != 0; // HACK: I should really check the entire data set
+	auto TemperatureUnits = [Fahrenheit](const double Celsius) { return(Fahrenheit ? CelsiusToFahrenheit(Celsius) : Celsius); };
+	std::ostringstream tempOString;
+	tempOString << "Temperature (" << std::fixed << std::setprecision(1) << TemperatureUnits(Samples.Temperature[0]) << (Fahrenheit ? "°F)" : "°C)");
+	std::string YLegendTemperature(tempOString.str());
+	tempOString = std::ostringstream();
+	tempOString << "Humidity (" << std::fixed << std::setprecision(1) << Samples.Humidity[0] << "%)";
+	std::string YLegendHumidity(tempOString.str());
+	tempOString = std::ostringstream();
+	tempOString << "Battery (" << Samples.Battery[0] << "%)";
+	std::string YLegendBattery(tempOString.str());
+	int GraphTop = FontSize + TickSize;
+	int GraphBottom = SVGHeight - GraphTop;
+	int GraphRight = SVGWidth - GraphTop;
+	if (DrawHumidity)
+	{
+		GraphWidth -= FontSize * 2;
+		GraphRight -= FontSize + TickSize * 2;
+	}
+	if (DrawBattery)
+		GraphWidth -= FontSize;
+	const GraphColumns Columns(Samples, GraphWidth, Envelope);
+	const TempestSeries& TheValues(Columns.Series);
+	int GraphLeft = GraphRight - GraphWidth;
+	int GraphVerticalDivision = (GraphBottom - GraphTop) / 4;
+	// The Fahrenheit conversion is monotonic, so it's applied to the range after the scan instead of to every value.
+	const size_t ValueCount = std::min(size_t(GraphWidth), TheValues.size());
+	double TempMin = TemperatureUnits(GetColumnMin(MinMax ? TheValues.TemperatureMin.data() : TheValues.Temperature.data(), ValueCount));
+	double TempMax = TemperatureUnits(GetColumnMax(MinMax ? TheValues.TemperatureMax.data() : TheValues.Temperature.data(), ValueCount));
+	double HumiMin = GetColumnMin(MinMax ? TheValues.HumidityMin.data() : TheValues.Humidity.data(), ValueCount);
+	double HumiMax = GetColumnMax(MinMax ? TheValues.HumidityMax.data() : TheValues.Humidity.data(), ValueCount);
+
+	double TempVerticalDivision = (TempMax - TempMin) / 4;
+	double TempVerticalFactor = (GraphBottom - GraphTop) / (TempMax - TempMin);
+	double HumiVerticalDivision = (HumiMax - HumiMin) / 4;
+	double HumiVerticalFactor = (GraphBottom - GraphTop) / (HumiMax - HumiMin);
+	int FreezingLine = 0; // outside the range of the graph
+	if (Fahrenheit)
+	{
+		if ((TempMin < 32) && (32 < TempMax))
+			FreezingLine = ((TempMax - 32.0) * TempVerticalFactor) + GraphTop;
+	}
+	else
+	{
+		if ((TempMin < 0) && (0 < TempMax))
+			FreezingLine = (TempMax * TempVerticalFactor) + GraphTop;
+	}
+
+	SVGPoints<SVGStream> Points(SVGFile, Simplify);
+	SVGFile << "<?xml version=\"1.0\" encoding=\"utf-8\" standalone=\"no\"?>\n";
+	SVGFile << "<svg xmlns=\"http://www.w3.org/2000/svg\" xmlns:xlink=\"http://www.w3.org/1999/xlink\" width=\"" << SVGWidth << "\" height=\"" << SVGHeight << "\">\n";
+	SVGFile << "\t<!-- Created by: " << ProgramVersionString << " -->\n";
+	SVGFile << "\t<clipPath id=\"GraphRegion\"><polygon points=\"" << GraphLeft << "," << GraphTop << " " << GraphRight << "," << GraphTop << " " << GraphRight << "," << GraphBottom << " " << GraphLeft << "," << GraphBottom << "\" /></clipPath>\n";
+	SVGFile << "\t<style>\n";
+	SVGFile << "\t\ttext { font-family: sans-serif; font-size: " << FontSize << "px; fill: dimgrey; }\n";
+	SVGFile << "\t\tline { stroke: dimgrey; }\n";
+	SVGFile << "\t\tpolygon { fill-opacity: 0.5; }\n";
+#ifdef _DARK_STYLE_
+	SVGFile << "\t@media only screen and (prefers-color-scheme: dark) {\n";
+	SVGFile << "\t\ttext { fill: grey; }\n";
+	SVGFile << "\t\tline { stroke: grey; }\n";
+	SVGFile << "\t}\n";
+#endif // _DARK_STYLE_
+	SVGFile << "\t</style>\n";
+#ifdef DEBUG
+	SVGFile << "<!-- HumiMax: " << HumiMax << " -->\n";
+	SVGFile << "<!-- HumiMin: " << HumiMin << " -->\n";
+	SVGFile << "<!-- HumiVerticalFactor: " << HumiVerticalFactor << " -->\n";
+#endif // DEBUG
+	SVGFile << "\t<rect style=\"fill-opacity:0;stroke:grey;stroke-width:2\" width=\"" << SVGWidth << "\" height=\"" << SVGHeight << "\" />\n";
+
+	// Legend Text
+	int LegendIndex = 1;
+	SVGFile << "\t<text x=\"" << GraphLeft << "\" y=\"" << GraphTop - 2 << "\">" << Title << " Temperature &amp; Humidity</text>\n";
+	SVGFile << "\t<text style=\"text-anchor:end\" x=\"" << GraphRight << "\" y=\"" << GraphTop - 2 << "\">" << timeToExcelLocal(TheValues.NewestTime) << "</text>\n";
+	SVGFile << "\t<text style=\"fill:blue;text-anchor:middle\" x=\"" << FontSize * LegendIndex << "\" y=\"50%\" transform=\"rotate(270 " << FontSize * LegendIndex << "," << (GraphTop + GraphBottom) / 2 << ")\">" << YLegendTemperature << "</text>\n";
+	if (DrawHumidity)
+	{
+		LegendIndex++;
+		SVGFile << "\t<text style=\"fill:green;text-anchor:middle\" x=\"" << FontSize * LegendIndex << "\" y=\"50%\" transform=\"rotate(270 " << FontSize * LegendIndex << "," << (GraphTop + GraphBottom) / 2 << ")\">" << YLegendHumidity << "</text>\n";
+	}
+	if (DrawBattery)
+	{
+		LegendIndex++;
+		SVGFile << "\t<text style=\"fill:OrangeRed\" text-anchor=\"middle\" x=\"" << FontSize * LegendIndex << "\" y=\"50%\" transform=\"rotate(270 " << FontSize * LegendIndex << "," << (GraphTop + GraphBottom) / 2 << ")\">" << YLegendBattery << "</text>\n";
+	}
+	if (DrawHumidity)
+	{
+		if (MinMax)
+		{
+			SVGFile << "\t<!-- Humidity Max -->\n";
+			SVGFile << "\t<polygon style=\"fill:lime;stroke:green;clip-path:url(#GraphRegion)\" points=\"";
+			SVGFile << GraphLeft + 1 << "," << GraphBottom - 1 << " ";
+			for (auto index = 0; index < (GraphWidth < TheValues.size() ? GraphWidth : TheValues.size()); index++)
+				Points.push_back(index + GraphLeft, int(((HumiMax - TheValues.HumidityMax[index]) * HumiVerticalFactor) + GraphTop));
+			Points.flush();
+			if (GraphWidth < TheValues.size())
+				SVGFile << GraphRight - 1 << "," << GraphBottom - 1;
+			else
+				SVGFile << GraphRight - (GraphWidth - TheValues.size()) << "," << GraphBottom - 1;
+			SVGFile << "\" />\n";
+			SVGFile << "\t<!-- Humidity Min -->\n";
+			SVGFile << "\t<polygon style=\"fill:lime;stroke:green;clip-path:url(#GraphRegion)\" points=\"";
+			SVGFile << GraphLeft + 1 << "," << GraphBottom - 1 << " ";
+			for (auto index = 0; index < (GraphWidth < TheValues.size() ? GraphWidth : TheValues.size()); index++)
+				Points.push_back(index + GraphLeft, int(((HumiMax - TheValues.HumidityMin[index]) * HumiVerticalFactor) + GraphTop));
+			Points.flush();
+			if (GraphWidth < TheValues.size())
+				SVGFile << GraphRight - 1 << "," << GraphBottom - 1;
+			else
+				SVGFile << GraphRight - (GraphWidth - TheValues.size()) << "," << GraphBottom - 1;
+			SVGFile << "\" />\n";
+		}
+		else
+		{
+			// Humidity Graphic as a Filled polygon
+			SVGFile << "\t<!-- Humidity -->\n";
+			SVGFile << "\t<polygon style=\"fill:lime;stroke:green;clip-path:url(#GraphRegion)\" points=\"";
+			SVGFile << GraphLeft + 1 << "," << GraphBottom - 1 << " ";
+			for (auto index = 0; index < (GraphWidth < TheValues.size() ? GraphWidth : TheValues.size()); index++)
+				Points.push_back(index + GraphLeft, int(((HumiMax - TheValues.Humidity[index]) * HumiVerticalFactor) + GraphTop));
+			Points.flush();
+			if (GraphWidth < TheValues.size())
+				SVGFile << GraphRight - 1 << "," << GraphBottom - 1;
+			else
+				SVGFile << GraphRight - (GraphWidth - TheValues.size()) << "," << GraphBottom - 1;
+			SVGFile << "\" />\n";
+		}
+	}
+
+	// Top Line
+	SVGFile << "\t<line x1=\"" << GraphLeft - TickSize << "\" y1=\"" << GraphTop << "\" x2=\"" << GraphRight + TickSize << "\" y2=\"" << GraphTop << "\"/>\n";
+	SVGFile << "\t<text style=\"fill:blue;text-anchor:end;dominant-baseline:middle\" x=\"" << GraphLeft - TickSize << "\" y=\"" << GraphTop << "\">" << FixedPoint(TempMax, 1) << "</text>\n";
+	if (DrawHumidity)
+		SVGFile << "\t<text style=\"fill:green;dominant-baseline:middle\" x=\"" << GraphRight + TickSize << "\" y=\"" << GraphTop << "\">" << FixedPoint(HumiMax, 1) << "</text>\n";
+
+	// Bottom Line
+	SVGFile << "\t<line x1=\"" << GraphLeft - TickSize << "\" y1=\"" << GraphBottom << "\" x2=\"" << GraphRight + TickSize << "\" y2=\"" << GraphBottom << "\"/>\n";
+	SVGFile << "\t<text style=\"fill:blue;text-anchor:end;dominant-baseline:middle\" x=\"" << GraphLeft - TickSize << "\" y=\"" << GraphBottom << "\">" << FixedPoint(TempMin, 1) << "</text>\n";
+	if (DrawHumidity)
+		SVGFile << "\t<text style=\"fill:green;dominant-baseline:middle\" x=\"" << GraphRight + TickSize << "\" y=\"" << GraphBottom << "\">" << FixedPoint(HumiMin, 1) << "</text>\n";
+
+	// Left Line
+	SVGFile << "\t<line x1=\"" << GraphLeft << "\" y1=\"" << GraphTop << "\" x2=\"" << GraphLeft << "\" y2=\"" << GraphBottom << "\"/>\n";
+
+	// Right Line
+	SVGFile << "\t<line x1=\"" << GraphRight << "\" y1=\"" << GraphTop << "\" x2=\"" << GraphRight << "\" y2=\"" << GraphBottom << "\"/>\n";
+
+	// Vertical Division Dashed Lines
+	for (auto index = 1; index < 4; index++)
+	{
+		SVGFile << "\t<line style=\"stroke-dasharray:1\" x1=\"" << GraphLeft - TickSize << "\" y1=\"" << GraphTop + (GraphVerticalDivision * index) << "\" x2=\"" << GraphRight + TickSize << "\" y2=\"" << GraphTop + (GraphVerticalDivision * index) << "\" />\n";
+		SVGFile << "\t<text style=\"fill:blue;text-anchor:end;dominant-baseline:middle\" x=\"" << GraphLeft - TickSize << "\" y=\"" << GraphTop + (GraphVerticalDivision * index) << "\">" << FixedPoint(TempMax - (TempVerticalDivision * index), 1) << "</text>\n";
+		if (DrawHumidity)
+			SVGFile << "\t<text style=\"fill:green;dominant-baseline:middle\" x=\"" << GraphRight + TickSize << "\" y=\"" << GraphTop + (GraphVerticalDivision * index) << "\">" << FixedPoint(HumiMax - (HumiVerticalDivision * index), 1) << "</text>\n";
+	}
+
+	// Horizontal Line drawn at the freezing point
+	if ((GraphTop < FreezingLine) && (FreezingLine < GraphBottom))
+	{
+		SVGFile << "\t<!-- FreezingLine = " << FreezingLine << " -->\n";
+		SVGFile << "\t<line style=\"fill:red;stroke:red;stroke-dasharray:1\" x1=\"" << GraphLeft - TickSize << "\" y1=\"" << FreezingLine << "\" x2=\"" << GraphRight + TickSize << "\" y2=\"" << FreezingLine << "\" />\n";
+	}
+
+	// Horizontal Division Dashed Lines
+	WriteTimeAxis(SVGFile, TimeAxis.GetMarks(Samples.Time, graph), Columns.SampleCount, std::min(size_t(GraphWidth), TheValues.size()), GraphLeft, GraphTop, GraphBottom + TickSize, SVGHeight - 2);
+
+	// Directional Arrow
+	SVGFile << "\t<polygon style=\"fill:red;stroke:red;fill-opacity:1;\" points=\"" << GraphLeft - 3 << "," << GraphBottom << " " << GraphLeft + 3 << "," << GraphBottom - 3 << " " << GraphLeft + 3 << "," << GraphBottom + 3 << "\" />\n";
+
+	if (MinMax)
+	{
+		// Temperature Values as a filled polygon showing the minimum and maximum
+		SVGFile << "\t<!-- Temperature MinMax -->\n";
+		SVGFile << "\t<polygon style=\"fill:blue;stroke:blue;clip-path:url(#GraphRegion)\" points=\"";
+		for (auto index = 1; index < (GraphWidth < TheValues.size() ? GraphWidth : TheValues.size()); index++)
+			Points.push_back(index + GraphLeft, int(((TempMax - TemperatureUnits(TheValues.TemperatureMax[index])) * TempVerticalFactor) + GraphTop));
+		for (auto index = (GraphWidth < TheValues.size() ? GraphWidth : TheValues.size()) - 1; index > 0; index--)
+			Points.push_back(index + GraphLeft, int(((TempMax - TemperatureUnits(TheValues.TemperatureMin[index])) * TempVerticalFactor) + GraphTop));
+		Points.flush();
+		SVGFile << "\" />\n";
+	}
+	else
+	{
+		// Temperature Values as a continuous line
+		SVGFile << "\t<!-- Temperature -->\n";
+		SVGFile << "\t<polyline style=\"fill:none;stroke:blue;clip-path:url(#GraphRegion)\" points=\"";
+		for (auto index = 1; index < (GraphWidth < TheValues.size() ? GraphWidth : TheValues.size()); index++)
+			Points.push_back(index + GraphLeft, int(((TempMax - TemperatureUnits(TheValues.Temperature[index])) * TempVerticalFactor) + GraphTop));
+		Points.flush();
+		SVGFile << "\" />\n";
+	}
+
+	// Battery Values as a continuous line
+	if (DrawBattery)
+	{
+		SVGFile << "\t<!-- Battery -->\n";
+		double BatteryVerticalFactor = (GraphBottom - GraphTop) / 100.0;
+		SVGFile << "\t<polyline style=\"fill:none;stroke:OrangeRed;clip-path:url(#GraphRegion)\" points=\"";
+		for (auto index = 1; index < (GraphWidth < TheValues.size() ? GraphWidth : TheValues.size()); index++)
+			Points.push_back(index + GraphLeft, int(((100 - TheValues.Battery[index]) * BatteryVerticalFactor) + GraphTop));
+		Points.flush();
+		SVGFile << "\" />\n";
+	}
+
+	SVGFile << "</svg>\n";
+}
+/////////////////////////////////////////////////////////////////////////////
+// Draws the wind and pressure graph of a non-empty series into an SVGBuffer, or into any std::ostream.
+template <class SVGStream>
+void RenderWindSVG(SVGStream& SVGFile, const TempestSeries& Samples, const std::string& Title, const GraphType graph, TimeAxisLayout& TimeAxis, const bool MinMax, const double MinPressureDifferential, const bool Simplify = false, const bool Envelope = false)
+{
+	// this overloaded function should allow both wind and pressue on same graph, with wind as left (primary) and pressure as right (secondary) scales.
+	// By declaring these items here, I'm then basing all my other dimensions on these
+	const int SVGWidth(500);
+	const int SVGHeight(135);
+	const int FontSize(12);
+	const int TickSize(2);
+	int GraphWidth = SVGWidth - (FontSize * 6);
+	std::ostringstream tempOString;
+	tempOString << "Wind Speed (" << std::fixed << std::setprecision(1) << Samples.WindSpeed[0] << " kn)";
+	const std::string YLegendWindSpeed(tempOString.str());
+	tempOString.str("");
+	tempOString << "Wind Gust (" << std::fixed << std::setprecision(1) << Samples.WindSpeedMax[0] << " kn)";
+	const std::string YLegendWindGust(tempOString.str());
+	tempOString.str("");
+	tempOString << "Pressure (" << std::fixed << std::setprecision(1) << Samples.OutsidePressure[0] + AltitudeAdjustment << " hPa)";
+	const std::string YLegendPressure(tempOString.str());
+	// The scales are found before the width of the graph is known, so with Envelope they cover every sample that will be folded into it.
+	const size_t ValueCount = Envelope ? Samples.size() : std::min(size_t(GraphWidth), Samples.size());
+	const double WindMin = GetColumnMin(MinMax ? Samples.WindSpeedMin.data() : Samples.WindSpeed.data(), ValueCount);
+	const double WindMax = GetColumnMax(MinMax ? Samples.WindSpeedMax.data() : Samples.WindSpeed.data(), ValueCount);
+	const double PressureMin = GetColumnMin(MinMax ? Samples.OutsidePressureMin.data() : Samples.OutsidePressure.data(), ValueCount);
+	const double PressureMax = GetColumnMax(MinMax ? Samples.OutsidePressureMax.data() : Samples.OutsidePressure.data(), ValueCount);
+	const int GraphTop = FontSize + TickSize;
+	const int GraphBottom = SVGHeight - GraphTop;
+	int GraphRight = SVGWidth - GraphTop;
+	const bool DrawPressure = PressureMax - PressureMin > MinPressureDifferential;
+	if (DrawPressure)
+	{
+		// Space for legend to be drawn on the right of the graph plus space for one more legend line on the left.
+		GraphWidth -= FontSize * 2;
+		GraphRight -= FontSize + TickSize * 2;
+	}
+	else
+	{
+		// Space to add the Pressure Legend on the left
+		GraphWidth -= FontSize;
+	}
+	int GraphLeft = GraphRight - GraphWidth;
+	const GraphColumns Columns(Samples, GraphWidth, Envelope);
+	const TempestSeries& TheValues(Columns.Series);
+	const int GraphVerticalDivision = (GraphBottom - GraphTop) / 4;
+	const double WindVerticalDivision = (WindMax - WindMin) / 4;
+	const double WindVerticalFactor = (GraphBottom - GraphTop) / (WindMax - WindMin);
+	const double PressureVerticalDivision = (PressureMax - PressureMin) / 4;
+	const double PressureVerticalFactor = (GraphBottom - GraphTop) / (PressureMax - PressureMin);
+
+	SVGPoints<SVGStream> Points(SVGFile, Simplify);
+	SVGFile << "<?xml version=\"1.0\" encoding=\"utf-8\" standalone=\"no\"?>\n";
+	SVGFile << "<svg xmlns=\"http://www.w3.org/2000/svg\" xmlns:xlink=\"http://www.w3.org/1999/xlink\" width=\"" << SVGWidth << "\" height=\"" << SVGHeight << "\">\n";
+	SVGFile << "\t<!-- Created by: " << ProgramVersionString << " -->\n";
+	SVGFile << "\t<clipPath id=\"GraphRegion\"><polygon points=\"" << GraphLeft << "," << GraphTop << " " << GraphRight << "," << GraphTop << " " << GraphRight << "," << GraphBottom << " " << GraphLeft << "," << GraphBottom << "\" /></clipPath>\n";
+	SVGFile << "\t<marker id=\"WindArrow\" markerWidth=\"4\" markerHeight=\"4\" refX=\"2\" refY=\"2\" orient=\"auto\" markerUnits=\"userSpaceOnUse\"><polygon style=\"fill:blue;fill-opacity:1\" points=\"0,0 4,2 0,4\" /></marker>\n";
+	SVGFile << "\t<style>\n";
+	SVGFile << "\t\ttext { font-family: sans-serif; font-size: " << FontSize << "px; fill: dimgrey; }\n";
+	SVGFile << "\t\tline { stroke: dimgrey; }\n";
+	SVGFile << "\t\tpolygon { fill-opacity: 0.5; }\n";
+	SVGFile << "\t\t.barometer-label { font-family: Georgia, serif; font-style: italic; font-size: " << int(PressureVerticalFactor * 10) << "px; opacity: 0.5; clip-path: url(#GraphRegion); text-anchor: middle; dominant-baseline: middle; }\n";
+	SVGFile << "\t\t.wind-direction { stroke: blue; opacity: 0.6; marker-end: url(#WindArrow); }\n";
+#ifdef _DARK_STYLE_
+	SVGFile << "\t@media only screen and (prefers-color-scheme: dark) {\n";
+	SVGFile << "\t\ttext { fill: grey; }\n";
+	SVGFile << "\t\tline { stroke: grey; }\n";
+	SVGFile << "\t}\n";
+#endif // _DARK_STYLE_
+	SVGFile << "\t</style>\n";
+	SVGFile << "\t<rect style=\"fill-opacity:0;stroke:grey;stroke-width:2\" width=\"" << SVGWidth << "\" height=\"" << SVGHeight << "\" />\n";
+
+	// Legend Text
+	int LegendIndex = 1;
+	SVGFile << "\t<text x=\"" << GraphLeft << "\" y=\"" << GraphTop - 2 << "\">" << Title << " Wind &amp; Pressure</text>\n";
+	SVGFile << "\t<text style=\"text-anchor:end\" x=\"" << GraphRight << "\" y=\"" << GraphTop - 2 << "\">" << timeToExcelLocal(TheValues.NewestTime) << "</text>\n";
+	SVGFile << "\t<text style=\"fill:blue;text-anchor:middle\" x=\"" << FontSize * LegendIndex << "\" y=\"50%\" transform=\"rotate(270 " << FontSize * LegendIndex << "," << (GraphTop + GraphBottom) / 2 << ")\">" << YLegendWindSpeed << "</text>\n";
+	LegendIndex++;
+	SVGFile << "\t<text style=\"fill:blue;text-anchor:middle\" x=\"" << FontSize * LegendIndex << "\" y=\"50%\" transform=\"rotate(270 " << FontSize * LegendIndex << "," << (GraphTop + GraphBottom) / 2 << ")\">" << YLegendWindGust << "</text>\n";
+	LegendIndex++;
+	SVGFile << "\t<text style=\"fill:green;text-anchor:middle\" x=\"" << FontSize * LegendIndex << "\" y=\"50%\" transform=\"rotate(270 " << FontSize * LegendIndex << "," << (GraphTop + GraphBottom) / 2 << ")\">" << YLegendPressure << "</text>\n";
+
+	// Top Line
+	SVGFile << "\t<line x1=\"" << GraphLeft - TickSize << "\" y1=\"" << GraphTop << "\" x2=\"" << GraphRight + TickSize << "\" y2=\"" << GraphTop << "\"/>\n";
+	SVGFile << "\t<text style=\"fill:blue;text-anchor:end;dominant-baseline:middle\" x=\"" << GraphLeft - TickSize << "\" y=\"" << GraphTop << "\">" << FixedPoint(WindMax, 1) << "</text>\n";
+	if (DrawPressure)
+		SVGFile << "\t<text style=\"fill:green;dominant-baseline:middle\" x=\"" << GraphRight + TickSize << "\" y=\"" << GraphTop << "\">" << FixedPoint(PressureMax + AltitudeAdjustment, 1) << "</text>\n";
+
+	// Vertical Division Dashed Lines
+	for (auto index = 1; index < 4; index++)
+	{
+		SVGFile << "\t<line style=\"stroke-dasharray:1\" x1=\"" << GraphLeft - TickSize << "\" y1=\"" << GraphTop + (GraphVerticalDivision * index) << "\" x2=\"" << GraphRight + TickSize << "\" y2=\"" << GraphTop + (GraphVerticalDivision * index) << "\" />\n";
+		SVGFile << "\t<text style=\"fill:blue;text-anchor:end;dominant-baseline:middle\" x=\"" << GraphLeft - TickSize << "\" y=\"" << GraphTop + (GraphVerticalDivision * index) << "\">" << FixedPoint(WindMax - (WindVerticalDivision * index), 1) << "</text>\n";
+		if (DrawPressure)
+			SVGFile << "\t<text style=\"fill:green;dominant-baseline:middle\" x=\"" << GraphRight + TickSize << "\" y=\"" << GraphTop + (GraphVerticalDivision * index) << "\">" << FixedPoint(PressureMax - (PressureVerticalDivision * index) + AltitudeAdjustment, 1) << "</text>\n";
+	}
+
+	// Bottom Line
+	SVGFile << "\t<line x1=\"" << GraphLeft - TickSize << "\" y1=\"" << GraphBottom << "\" x2=\"" << GraphRight + TickSize << "\" y2=\"" << GraphBottom << "\"/>\n";
+	SVGFile << "\t<text style=\"fill:blue;text-anchor:end;dominant-baseline:middle\" x=\"" << GraphLeft - TickSize << "\" y=\"" << GraphBottom << "\">" << FixedPoint(WindMin, 1) << "</text>\n";
+	if (DrawPressure)
+		SVGFile << "\t<text style=\"fill:green;dominant-baseline:middle\" x=\"" << GraphRight + TickSize << "\" y=\"" << GraphBottom << "\">" << FixedPoint(PressureMin + AltitudeAdjustment, 1) << "</text>\n";
+
+	// Left Line
+	SVGFile << "\t<line x1=\"" << GraphLeft << "\" y1=\"" << GraphTop << "\" x2=\"" << GraphLeft << "\" y2=\"" << GraphBottom << "\"/>\n";
+
+	// Horizontal Division Dashed Lines
+	WriteTimeAxis(SVGFile, TimeAxis.GetMarks(Samples.Time, graph), Columns.SampleCount, std::min(size_t(GraphWidth), TheValues.size()), GraphLeft, GraphTop, GraphBottom + TickSize, SVGHeight - 2);
+
+	// Right Line
+	SVGFile << "\t<line x1=\"" << GraphRight << "\" y1=\"" << GraphTop << "\" x2=\"" << GraphRight << "\" y2=\"" << GraphBottom << "\"/>\n";
+
+	// Directional Arrow
+	SVGFile << "\t<polygon style=\"fill:red;stroke:red;fill-opacity:1;\" points=\"" << GraphLeft - 3 << "," << GraphBottom << " " << GraphLeft + 3 << "," << GraphBottom - 3 << " " << GraphLeft + 3 << "," << GraphBottom + 3 << "\" />\n";
+
+	if (MinMax)
+	{
+		// OutsidePressure Values as a filled polygon showing the minimum and maximum
+		if (DrawPressure)
+		{
+			SVGFile << "\t<!-- OutsidePressure MinMax -->\n";
+			SVGFile << "\t<polygon style=\"fill:green;stroke:green;clip-path:url(#GraphRegion)\" points=\"";
+			for (auto index = 1; index < (GraphWidth < TheValues.size() ? GraphWidth : TheValues.size()); index++)
+				Points.push_back(index + GraphLeft, int(((PressureMax - TheValues.OutsidePressureMax[index]) * PressureVerticalFactor) + GraphTop));
+			for (auto index = (GraphWidth < TheValues.size() ? GraphWidth : TheValues.size()) - 1; index > 0; index--)
+				Points.push_back(index + GraphLeft, int(((PressureMax - TheValues.OutsidePressureMin[index]) * PressureVerticalFactor) + GraphTop));
+			Points.flush();
+			SVGFile << "\" />\n";
+		}
+		// ApparentWindSpeed Values as a filled polygon showing the minimum and maximum
+		SVGFile << "\t<!-- ApparentWindSpeed MinMax -->\n";
+		SVGFile << "\t<polygon style=\"fill:blue;stroke:blue;clip-path:url(#GraphRegion)\" points=\"";
+		for (auto index = 1; index < (GraphWidth < TheValues.size() ? GraphWidth : TheValues.size()); index++)
+			Points.push_back(index + GraphLeft, int(((WindMax - TheValues.WindSpeedMax[index]) * WindVerticalFactor) + GraphTop));
+		for (auto index = (GraphWidth < TheValues.size() ? GraphWidth : TheValues.size()) - 1; index > 0; index--)
+			Points.push_back(index + GraphLeft, int(((WindMax - TheValues.WindSpeed[index]) * WindVerticalFactor) + GraphTop));
+		Points.flush();
+		SVGFile << "\" />\n";
+	}
+	// OutsidePressure Values as a continuous line
+	if (DrawPressure)
+	{
+		SVGFile << "\t<!-- OutsidePressure -->\n";
+		SVGFile << "\t<polyline style=\"fill:none;stroke:green;clip-path:url(#GraphRegion)\" points=\"";
+		for (auto index = 1; index < (GraphWidth < TheValues.size() ? GraphWidth : TheValues.size()); index++)
+			Points.push_back(index + GraphLeft, int(((PressureMax - TheValues.OutsidePressure[index]) * PressureVerticalFactor) + GraphTop));
+		Points.flush();
+		SVGFile << "\" />\n";
+	}
+	// ApparentWindSpeed Values as a continuous line
+	SVGFile << "\t<!-- ApparentWindSpeed -->\n";
+	SVGFile << "\t<polyline style=\"fill:none;stroke:blue;clip-path:url(#GraphRegion)\" points=\"";
+	for (auto index = 1; index < (GraphWidth < TheValues.size() ? GraphWidth : TheValues.size()); index++)
+		Points.push_back(index + GraphLeft, int(((WindMax - TheValues.WindSpeed[index]) * WindVerticalFactor) + GraphTop));
+	Points.flush();
+	SVGFile << "\" />\n";
+
+	// Prevailing wind direction as arrows pointing downwind along the top of the graph. Each arrow is the vector mean of the samples under it.
+	SVGFile << "\t<!-- WindDirection -->\n";
+	const int DirectionSpacing(10);
+	const size_t DirectionCount = std::min<size_t>(GraphWidth, TheValues.size());	// ValueCount was found before the pressure legend narrowed the graph
+	for (size_t index = 1; index + DirectionSpacing <= DirectionCount; index += DirectionSpacing)
+	{
+		double SumX = 0, SumY = 0;
+		for (auto sample = index; sample < index + DirectionSpacing; sample++)
+		{
+			SumX += TheValues.WindX[sample];
+			SumY += TheValues.WindY[sample];
+		}
+		const double Magnitude = std::hypot(SumX, SumY);
+		if (Magnitude > 0.5 * DirectionSpacing)	// no direction is drawn for a calm of less than half a knot
+		{
+			const double Length = (DirectionSpacing / 2) - 1;
+			const double CenterX = GraphLeft + index + (DirectionSpacing / 2);
+			const double CenterY = GraphTop + (DirectionSpacing / 2) + 1;
+			const double DownwindX = -SumX / Magnitude * Length;	// y increases down the page, so north is -y and downwind of a northerly is +y
+			const double DownwindY = SumY / Magnitude * Length;
+			SVGFile << "\t<line class=\"wind-direction\" x1=\"" << FixedPoint(CenterX - DownwindX, 1) << "\" y1=\"" << FixedPoint(CenterY - DownwindY, 1) << "\" x2=\"" << FixedPoint(CenterX + DownwindX, 1) << "\" y2=\"" << FixedPoint(CenterY + DownwindY, 1) << "\" />\n";
+		}
+	}
+
+	if (DrawPressure)
+		if (graph != GraphType::daily) // this text was way too busy on the daily graph
+		{
+			SVGFile << "\t<text class=\"barometer-label\" x=\"50%\" y=\"" << int(((PressureMax - 974) * PressureVerticalFactor) + GraphTop) << "\">Rain</text>\n";
+			SVGFile << "\t<text class=\"barometer-label\" x=\"50%\" y=\"" << int(((PressureMax - 999) * PressureVerticalFactor) + GraphTop) << "\">Change</text>\n";
+			SVGFile << "\t<text class=\"barometer-label\" x=\"50%\" y=\"" << int(((PressureMax - 1024) * PressureVerticalFactor) + GraphTop) << "\">Fair</text>\n";
+		}
+
+	SVGFile << "</svg>\n";
+}
+/////////////////////////////////////////////////////////////////////////////
+// Draws the rain and lightning graph of a non-empty series into an SVGBuffer, or into any std::ostream.
+// Both are totals over each sample, so they are drawn as bars up from the bottom of the graph. Lightning gets the right hand scale, only when there has been some.
+template <class SVGStream>
+void RenderRainSVG(SVGStream& SVGFile, const TempestSeries& Samples, const std::string& Title, const GraphType graph, TimeAxisLayout& TimeAxis, const bool Simplify = false, const bool Envelope = false)
+{
+	const int SVGWidth(500);
+	const int SVGHeight(135);
+	const int FontSize(12);
+	const int TickSize(2);
+	int GraphWidth = SVGWidth - (FontSize * 5);
+	// The totals and scales are found before the width of the graph is known, so with Envelope they cover every sample that will be folded into it.
+	const size_t ValueCount = Envelope ? Samples.size() : std::min(size_t(GraphWidth), Samples.size());
+	const double RainTotal = std::accumulate(Samples.Rain.begin(), Samples.Rain.begin() + ValueCount, 0.0);
+	const int LightningTotal = std::accumulate(Samples.LightningCount.begin(), Samples.LightningCount.begin() + ValueCount, 0);
+	std::ostringstream tempOString;
+	tempOString << "Rain (" << std::fixed << std::setprecision(1) << RainTotal << " mm)";
+	const std::string YLegendRain(tempOString.str());
+	tempOString.str("");
+	tempOString << "Lightning (" << LightningTotal << " strikes)";
+	const std::string YLegendLightning(tempOString.str());
+	const double RainMax = std::max(GetColumnMax(Samples.Rain.data(), ValueCount), 0.5);	// the scale never gets so small that a trace of rain fills the graph
+	const double LightningMax = std::max(GetColumnMax(Samples.LightningCount.data(), ValueCount), 4.0);
+	const bool DrawLightning = LightningTotal > 0;
+	const int GraphTop = FontSize + TickSize;
+	const int GraphBottom = SVGHeight - GraphTop;
+	int GraphRight = SVGWidth - GraphTop;
+	if (DrawLightning)
+	{
+		GraphWidth -= FontSize * 2;
+		GraphRight -= FontSize + TickSize * 2;
+	}
+	const int GraphLeft = GraphRight - GraphWidth;
+	const GraphColumns Columns(Samples, GraphWidth, Envelope);
+	const TempestSeries& TheValues(Columns.Series);
+	const size_t GraphCount = std::min(size_t(GraphWidth), TheValues.size());
+	const int GraphVerticalDivision = (GraphBottom - GraphTop) / 4;
+	const double RainVerticalDivision = RainMax / 4;
+	const double RainVerticalFactor = (GraphBottom - GraphTop) / RainMax;
+	const double LightningVerticalDivision = LightningMax / 4;
+	const double LightningVerticalFactor = (GraphBottom - GraphTop) / LightningMax;
+
+	SVGPoints<SVGStream> Points(SVGFile, Simplify);
+	SVGFile << "<?xml version=\"1.0\" encoding=\"utf-8\" standalone=\"no\"?>\n";
+	SVGFile << "<svg xmlns=\"http://www.w3.org/2000/svg\" xmlns:xlink=\"http://www.w3.org/1999/xlink\" width=\"" << SVGWidth << "\" height=\"" << SVGHeight << "\">\n";
+	SVGFile << "\t<!-- Created by: " << ProgramVersionString << " -->\n";
+	SVGFile << "\t<clipPath id=\"GraphRegion\"><polygon points=\"" << GraphLeft << "," << GraphTop << " " << GraphRight << "," << GraphTop << " " << GraphRight << "," << GraphBottom << " " << GraphLeft << "," << GraphBottom << "\" /></clipPath>\n";
+	SVGFile << "\t<style>\n";
+	SVGFile << "\t\ttext { font-family: sans-serif; font-size: " << FontSize << "px; fill: dimgrey; }\n";
+	SVGFile << "\t\tline { stroke: dimgrey; }\n";
+	SVGFile << "\t\tpolygon { fill-opacity: 0.5; }\n";
+#ifdef _DARK_STYLE_
+	SVGFile << "\t@media only screen and (prefers-color-scheme: dark) {\n";
+	SVGFile << "\t\ttext { fill: grey; }\n";
+	SVGFile << "\t\tline { stroke: grey; }\n";
+	SVGFile << "\t}\n";
+#endif // _DARK_STYLE_
+	SVGFile << "\t</style>\n";
+	SVGFile << "\t<rect style=\"fill-opacity:0;stroke:grey;stroke-width:2\" width=\"" << SVGWidth << "\" height=\"" << SVGHeight << "\" />\n";
+
+	// Legend Text
+	int LegendIndex = 1;
+	SVGFile << "\t<text x=\"" << GraphLeft << "\" y=\"" << GraphTop - 2 << "\">" << Title << " Rain &amp; Lightning</text>\n";
+	SVGFile << "\t<text style=\"text-anchor:end\" x=\"" << GraphRight << "\" y=\"" << GraphTop - 2 << "\">" << timeToExcelLocal(TheValues.NewestTime) << "</text>\n";
+	SVGFile << "\t<text style=\"fill:blue;text-anchor:middle\" x=\"" << FontSize * LegendIndex << "\" y=\"50%\" transform=\"rotate(270 " << FontSize * LegendIndex << "," << (GraphTop + GraphBottom) / 2 << ")\">" << YLegendRain << "</text>\n";
+	if (DrawLightning)
+	{
+		LegendIndex++;
+		SVGFile << "\t<text style=\"fill:darkorange;text-anchor:middle\" x=\"" << FontSize * LegendIndex << "\" y=\"50%\" transform=\"rotate(270 " << FontSize * LegendIndex << "," << (GraphTop + GraphBottom) / 2 << ")\">" << YLegendLightning << "</text>\n";
+	}
+
+	// Rain Values as a filled polygon up from the bottom of the graph
+	SVGFile << "\t<!-- Rain -->\n";
+	SVGFile << "\t<polygon style=\"fill:blue;stroke:blue;clip-path:url(#GraphRegion)\" points=\"";
+	SVGFile << GraphLeft + 1 << "," << GraphBottom << " ";
+	for (size_t index = 1; index < GraphCount; index++)
+		Points.push_back(index + GraphLeft, int(((RainMax - TheValues.Rain[index]) * RainVerticalFactor) + GraphTop));
+	Points.flush();
+	SVGFile << GraphLeft + int(GraphCount) - 1 << "," << GraphBottom;
+	SVGFile << "\" />\n";
+
+	// Lightning Strikes as a filled polygon up from the bottom of the graph
+	if (DrawLightning)
+	{
+		SVGFile << "\t<!-- Lightning -->\n";
+		SVGFile << "\t<polygon style=\"fill:darkorange;stroke:darkorange;clip-path:url(#GraphRegion)\" points=\"";
+		SVGFile << GraphLeft + 1 << "," << GraphBottom << " ";
+		for (size_t index = 1; index < GraphCount; index++)
+			Points.push_back(index + GraphLeft, int(((LightningMax - TheValues.LightningCount[index]) * LightningVerticalFactor) + GraphTop));
+		Points.flush();
+		SVGFile << GraphLeft + int(GraphCount) - 1 << "," << GraphBottom;
+		SVGFile << "\" />\n";
+	}
+
+	// Top Line
+	SVGFile << "\t<line x1=\"" << GraphLeft - TickSize << "\" y1=\"" << GraphTop << "\" x2=\"" << GraphRight + TickSize << "\" y2=\"" << GraphTop << "\"/>\n";
+	SVGFile << "\t<text style=\"fill:blue;text-anchor:end;dominant-baseline:middle\" x=\"" << GraphLeft - TickSize << "\" y=\"" << GraphTop << "\">" << FixedPoint(RainMax, 2) << "</text>\n";
+	if (DrawLightning)
+		SVGFile << "\t<text style=\"fill:darkorange;dominant-baseline:middle\" x=\"" << GraphRight + TickSize << "\" y=\"" << GraphTop << "\">" << FixedPoint(LightningMax, 0) << "</text>\n";
+
+	// Bottom Line
+	SVGFile << "\t<line x1=\"" << GraphLeft - TickSize << "\" y1=\"" << GraphBottom << "\" x2=\"" << GraphRight + TickSize << "\" y2=\"" << GraphBottom << "\"/>\n";
+	SVGFile << "\t<text style=\"fill:blue;text-anchor:end;dominant-baseline:middle\" x=\"" << GraphLeft - TickSize << "\" y=\"" << GraphBottom << "\">" << FixedPoint(0, 2) << "</text>\n";
+	if (DrawLightning)
+		SVGFile << "\t<text style=\"fill:darkorange;dominant-baseline:middle\" x=\"" << GraphRight + TickSize << "\" y=\"" << GraphBottom << "\">" << FixedPoint(0, 0) << "</text>\n";
+
+	// Left Line
+	SVGFile << "\t<line x1=\"" << GraphLeft << "\" y1=\"" << GraphTop << "\" x2=\"" << GraphLeft << "\" y2=\"" << GraphBottom << "\"/>\n";
+
+	// Right Line
+	SVGFile << "\t<line x1=\"" << GraphRight << "\" y1=\"" << GraphTop << "\" x2=\"" << GraphRight << "\" y2=\"" << GraphBottom << "\"/>\n";
+
+	// Vertical Division Dashed Lines
+	for (auto index = 1; index < 4; index++)
+	{
+		SVGFile << "\t<line style=\"stroke-dasharray:1\" x1=\"" << GraphLeft - TickSize << "\" y1=\"" << GraphTop + (GraphVerticalDivision * index) << "\" x2=\"" << GraphRight + TickSize << "\" y2=\"" << GraphTop + (GraphVerticalDivision * index) << "\" />\n";
+		SVGFile << "\t<text style=\"fill:blue;text-anchor:end;dominant-baseline:middle\" x=\"" << GraphLeft - TickSize << "\" y=\"" << GraphTop + (GraphVerticalDivision * index) << "\">" << FixedPoint(RainMax - (RainVerticalDivision * index), 2) << "</text>\n";
+		if (DrawLightning)
+			SVGFile << "\t<text style=\"fill:darkorange;dominant-baseline:middle\" x=\"" << GraphRight + TickSize << "\" y=\"" << GraphTop + (GraphVerticalDivision * index) << "\">" << FixedPoint(LightningMax - (LightningVerticalDivision * index), 0) << "</text>\n";
+	}
+
+	// Horizontal Division Dashed Lines
+	WriteTimeAxis(SVGFile, TimeAxis.GetMarks(Samples.Time, graph), Columns.SampleCount, GraphCount, GraphLeft, GraphTop, GraphBottom + TickSize, SVGHeight - 2);
+
+	// Directional Arrow
+	SVGFile << "\t<polygon style=\"fill:red;stroke:red;fill-opacity:1;\" points=\"" << GraphLeft - 3 << "," << GraphBottom << " " << GraphLeft + 3 << "," << GraphBottom - 3 << " " << GraphLeft + 3 << "," << GraphBottom + 3 << "\" />\n";
+
+	SVGFile << "</svg>\n";
+}
+/////////////////////////////////////////////////////////////////////////////
+// Draws the solar radiation and UV graph of a non-empty series into an SVGBuffer, or into any std::ostream.
+// With MinMax the highest value of each sample is drawn instead of its average, which keeps the noon peaks on the longer graphs.
+template <class SVGStream>
+void RenderSolarSVG(SVGStream& SVGFile, const TempestSeries& Samples, const std::string& Title, const GraphType graph, TimeAxisLayout& TimeAxis, const bool MinMax, const bool Simplify = false, const bool Envelope = false)
+{
+	const int SVGWidth(500);
+	const int SVGHeight(135);
+	const int FontSize(12);
+	const int TickSize(2);
+	int GraphWidth = SVGWidth - (FontSize * 7);
+	std::ostringstream tempOString;
+	tempOString << "Solar (" << std::fixed << std::setprecision(0) << Samples.SolarRadiation[0] << " W/m&#178;)";
+	const std::string YLegendSolar(tempOString.str());
+	tempOString.str("");
+	tempOString << "Illuminance (" << std::fixed << std::setprecision(0) << Samples.Illuminance[0] << " lux)";
+	const std::string YLegendIlluminance(tempOString.str());
+	tempOString.str("");
+	tempOString << "UV Index (" << std::fixed << std::setprecision(1) << Samples.UV[0] << ")";
+	const std::string YLegendUV(tempOString.str());
+	const GraphColumns Columns(Samples, GraphWidth, Envelope);
+	const TempestSeries& TheValues(Columns.Series);
+	const size_t ValueCount = std::min(size_t(GraphWidth), TheValues.size());
+	const auto& Solar = MinMax ? TheValues.SolarRadiationMax : TheValues.SolarRadiation;
+	const auto& UV = MinMax ? TheValues.UVMax : TheValues.UV;
+	const double SolarMax = std::max(GetColumnMax(Solar.data(), ValueCount), 100.0);	// the night is drawn as a flat line instead of an empty scale
+	const double UVMax = std::max(GetColumnMax(UV.data(), ValueCount), 1.0);
+	const int GraphTop = FontSize + TickSize;
+	const int GraphBottom = SVGHeight - GraphTop;
+	const int GraphRight = SVGWidth - GraphTop - FontSize - TickSize * 2;
+	const int GraphLeft = GraphRight - GraphWidth;
+	const size_t GraphCount = std::min(size_t(GraphWidth), TheValues.size());
+	const int GraphVerticalDivision = (GraphBottom - GraphTop) / 4;
+	const double SolarVerticalDivision = SolarMax / 4;
+	const double SolarVerticalFactor = (GraphBottom - GraphTop) / SolarMax;
+	const double UVVerticalDivision = UVMax / 4;
+	const double UVVerticalFactor = (GraphBottom - GraphTop) / UVMax;
+
+	SVGPoints<SVGStream> Points(SVGFile, Simplify);
+	SVGFile << "<?xml version=\"1.0\" encoding=\"utf-8\" standalone=\"no\"?>\n";
+	SVGFile << "<svg xmlns=\"http://www.w3.org/2000/svg\" xmlns:xlink=\"http://www.w3.org/1999/xlink\" width=\"" << SVGWidth << "\" height=\"" << SVGHeight << "\">\n";
+	SVGFile << "\t<!-- Created by: " << ProgramVersionString << " -->\n";
+	SVGFile << "\t<clipPath id=\"GraphRegion\"><polygon points=\"" << GraphLeft << "," << GraphTop << " " << GraphRight << "," << GraphTop << " " << GraphRight << "," << GraphBottom << " " << GraphLeft << "," << GraphBottom << "\" /></clipPath>\n";
+	SVGFile << "\t<style>\n";
+	SVGFile << "\t\ttext { font-family: sans-serif; font-size: " << FontSize << "px; fill: dimgrey; }\n";
+	SVGFile << "\t\tline { stroke: dimgrey; }\n";
+	SVGFile << "\t\tpolygon { fill-opacity: 0.5; }\n";
+#ifdef _DARK_STYLE_
+	SVGFile << "\t@media only screen and (prefers-color-scheme: dark) {\n";
+	SVGFile << "\t\ttext { fill: grey; }\n";
+	SVGFile << "\t\tline { stroke: grey; }\n";
+	SVGFile << "\t}\n";
+#endif // _DARK_STYLE_
+	SVGFile << "\t</style>\n";
+	SVGFile << "\t<rect style=\"fill-opacity:0;stroke:grey;stroke-width:2\" width=\"" << SVGWidth << "\" height=\"" << SVGHeight << "\" />\n";
+
+	// Legend Text
+	int LegendIndex = 1;
+	SVGFile << "\t<text x=\"" << GraphLeft << "\" y=\"" << GraphTop - 2 << "\">" << Title << " Solar &amp; UV</text>\n";
+	SVGFile << "\t<text style=\"text-anchor:end\" x=\"" << GraphRight << "\" y=\"" << GraphTop - 2 << "\">" << timeToExcelLocal(TheValues.NewestTime) << "</text>\n";
+	SVGFile << "\t<text style=\"fill:darkgoldenrod;text-anchor:middle\" x=\"" << FontSize * LegendIndex << "\" y=\"50%\" transform=\"rotate(270 " << FontSize * LegendIndex << "," << (GraphTop + GraphBottom) / 2 << ")\">" << YLegendSolar << "</text>\n";
+	LegendIndex++;
+	SVGFile << "\t<text style=\"fill:darkgoldenrod;text-anchor:middle\" x=\"" << FontSize * LegendIndex << "\" y=\"50%\" transform=\"rotate(270 " << FontSize * LegendIndex << "," << (GraphTop + GraphBottom) / 2 << ")\">" << YLegendIlluminance << "</text>\n";
+	LegendIndex++;
+	SVGFile << "\t<text style=\"fill:purple;text-anchor:middle\" x=\"" << FontSize * LegendIndex << "\" y=\"50%\" transform=\"rotate(270 " << FontSize * LegendIndex << "," << (GraphTop + GraphBottom) / 2 << ")\">" << YLegendUV << "</text>\n";
+
+	// Solar Radiation Values as a filled polygon up from the bottom of the graph
+	SVGFile << "\t<!-- SolarRadiation -->\n";
+	SVGFile << "\t<polygon style=\"fill:gold;stroke:darkgoldenrod;clip-path:url(#GraphRegion)\" points=\"";
+	SVGFile << GraphLeft + 1 << "," << GraphBottom << " ";
+	for (size_t index = 1; index < GraphCount; index++)
+		Points.push_back(index + GraphLeft, int(((SolarMax - Solar[index]) * SolarVerticalFactor) + GraphTop));
+	Points.flush();
+	SVGFile << GraphLeft + int(GraphCount) - 1 << "," << GraphBottom;
+	SVGFile << "\" />\n";
+
+	// Top Line
+	SVGFile << "\t<line x1=\"" << GraphLeft - TickSize << "\" y1=\"" << GraphTop << "\" x2=\"" << GraphRight + TickSize << "\" y2=\"" << GraphTop << "\"/>\n";
+	SVGFile << "\t<text style=\"fill:darkgoldenrod;text-anchor:end;dominant-baseline:middle\" x=\"" << GraphLeft - TickSize << "\" y=\"" << GraphTop << "\">" << FixedPoint(SolarMax, 0) << "</text>\n";
+	SVGFile << "\t<text style=\"fill:purple;dominant-baseline:middle\" x=\"" << GraphRight + TickSize << "\" y=\"" << GraphTop << "\">" << FixedPoint(UVMax, 1) << "</text>\n";
+
+	// Bottom Line
+	SVGFile << "\t<line x1=\"" << GraphLeft - TickSize << "\" y1=\"" << GraphBottom << "\" x2=\"" << GraphRight + TickSize << "\" y2=\"" << GraphBottom << "\"/>\n";
+	SVGFile << "\t<text style=\"fill:darkgoldenrod;text-anchor:end;dominant-baseline:middle\" x=\"" << GraphLeft - TickSize << "\" y=\"" << GraphBottom << "\">" << FixedPoint(0, 0) << "</text>\n";
+	SVGFile << "\t<text style=\"fill:purple;dominant-baseline:middle\" x=\"" << GraphRight + TickSize << "\" y=\"" << GraphBottom << "\">" << FixedPoint(0, 1) << "</text>\n";
+
+	// Left Line
+	SVGFile << "\t<line x1=\"" << GraphLeft << "\" y1=\"" << GraphTop << "\" x2=\"" << GraphLeft << "\" y2=\"" << GraphBottom << "\"/>\n";
+
+	// Right Line
+	SVGFile << "\t<line x1=\"" << GraphRight << "\" y1=\"" << GraphTop << "\" x2=\"" << GraphRight << "\" y2=\"" << GraphBottom << "\"/>\n";
+
+	// Vertical Division Dashed Lines
+	for (auto index = 1; index < 4; index++)
+	{
+		SVGFile << "\t<line style=\"stroke-dasharray:1\" x1=\"" << GraphLeft - TickSize << "\" y1=\"" << GraphTop + (GraphVerticalDivision * index) << "\" x2=\"" << GraphRight + TickSize << "\" y2=\"" << GraphTop + (GraphVerticalDivision * index) << "\" />\n";
+		SVGFile << "\t<text style=\"fill:darkgoldenrod;text-anchor:end;dominant-baseline:middle\" x=\"" << GraphLeft - TickSize << "\" y=\"" << GraphTop + (GraphVerticalDivision * index) << "\">" << FixedPoint(SolarMax - (SolarVerticalDivision * index), 0) << "</text>\n";
+		SVGFile << "\t<text style=\"fill:purple;dominant-baseline:middle\" x=\"" << GraphRight + TickSize << "\" y=\"" << GraphTop + (GraphVerticalDivision * index) << "\">" << FixedPoint(UVMax - (UVVerticalDivision * index), 1) << "</text>\n";
+	}
+
+	// Horizontal Division Dashed Lines
+	WriteTimeAxis(SVGFile, TimeAxis.GetMarks(Samples.Time, graph), Columns.SampleCount, GraphCount, GraphLeft, GraphTop, GraphBottom + TickSize, SVGHeight - 2);
+
+	// Directional Arrow
+	SVGFile << "\t<polygon style=\"fill:red;stroke:red;fill-opacity:1;\" points=\"" << GraphLeft - 3 << "," << GraphBottom << " " << GraphLeft + 3 << "," << GraphBottom - 3 << " " << GraphLeft + 3 << "," << GraphBottom + 3 << "\" />\n";
+
+	// UV Index Values as a continuous line
+	SVGFile << "\t<!-- UV -->\n";
+	SVGFile << "\t<polyline style=\"fill:none;stroke:purple;clip-path:url(#GraphRegion)\" points=\"";
+	for (size_t index = 1; index < GraphCount; index++)
+		Points.push_back(index + GraphLeft, int(((UVMax - UV[index]) * UVVerticalFactor) + GraphTop));
+	Points.flush();
+	SVGFile << "\" />\n";
+
+	SVGFile << "</svg>\n";
+}
+/////////////////////////////////////////////////////////////////////////////
+// Draws the wind rose of the last day of rapid wind samples, with the 2 and 10 minute mean vector winds and the 10 minute gust.
+// Each direction sector is a stack of petals, one per speed band, with the length of each petal being the fraction of samples at or below that band.
+template <class SVGStream>
+void RenderWindRoseSVG(SVGStream& SVGFile, const RapidWindSummary& TheSummary, const std::string& Title)
+{
+	const int SVGWidth(500);
+	const int SVGHeight(270);
+	const int FontSize(12);
+	const int RoseRadius((SVGHeight / 2) - (FontSize * 2));
+	const int RoseX(FontSize * 2 + RoseRadius);
+	const int RoseY(SVGHeight / 2 + FontSize / 2);
+	const int LegendLeft(RoseX + RoseRadius + FontSize * 3);
+	const char* BandColors[RAPID_WIND_BANDS] = { "none", "lightskyblue", "deepskyblue", "blue", "orange", "red" };
+	const std::string BandNames[RAPID_WIND_BANDS] = { "Calm", "1-5 kn", "5-10 kn", "10-15 kn", "15-20 kn", "20+ kn" };
+	std::array<std::array<double, RAPID_WIND_BANDS>, RAPID_WIND_SECTORS> Percent = {};	// cumulative by band, so the last band is the whole sector
+	double Calm = 0;
+	double MaxPercent = 0;
+	for (auto sector = 0; sector < RAPID_WIND_SECTORS; sector++)
+	{
+		Calm += TheSummary.Histogram[sector][0] * 100.0 / TheSummary.Count;
+		for (auto band = 1; band < RAPID_WIND_BANDS; band++)
+			Percent[sector][band] = Percent[sector][band - 1] + TheSummary.Histogram[sector][band] * 100.0 / TheSummary.Count;
+		MaxPercent = std::max(MaxPercent, Percent[sector][RAPID_WIND_BANDS - 1]);
+	}
+	const int CircleStep = MaxPercent > 20 ? 10 : 5;
+	const int CircleCount = std::max(1, int(std::ceil(MaxPercent / CircleStep)));
+	const double RadiusFactor = double(RoseRadius) / (CircleCount * CircleStep);
+	// x and y of a point at a compass bearing and distance from the center of the rose
+	auto RoseX2 = [RoseX](const double Degrees, const double Radius) { return(RoseX + int(std::lround(Radius * std::sin(Degrees * M_PI / 180.0)))); };
+	auto RoseY2 = [RoseY](const double Degrees, const double Radius) { return(RoseY - int(std::lround(Radius * std::cos(Degrees * M_PI / 180.0)))); };
+
+	SVGFile << "<?xml version=\"1.0\" encoding=\"utf-8\" standalone=\"no\"?>\n";
+	SVGFile << "<svg xmlns=\"http://www.w3.org/2000/svg\" xmlns:xlink=\"http://www.w3.org/1999/xlink\" width=\"" << SVGWidth << "\" height=\"" << SVGHeight << "\">\n";
+	SVGFile << "\t<!-- Created by: " << ProgramVersionString << " -->\n";
+	SVGFile << "\t<style>\n";
+	SVGFile << "\t\ttext { font-family: sans-serif; font-size: " << FontSize << "px; fill: dimgrey; }\n";
+	SVGFile << "\t\tline { stroke: dimgrey; }\n";
+	SVGFile << "\t\tcircle { fill: none; stroke: dimgrey; stroke-dasharray: 1; }\n";
+	SVGFile << "\t\tpolygon { stroke: white; stroke-width: 0.5; }\n";
+#ifdef _DARK_STYLE_
+	SVGFile << "\t@media only screen and (prefers-color-scheme: dark) {\n";
+	SVGFile << "\t\ttext { fill: grey; }\n";
+	SVGFile << "\t\tline { stroke: grey; }\n";
+	SVGFile << "\t\tcircle { stroke: grey; }\n";
+	SVGFile << "\t\tpolygon { stroke: black; }\n";
+	SVGFile << "\t}\n";
+#endif // _DARK_STYLE_
+	SVGFile << "\t</style>\n";
+	SVGFile << "\t<rect style=\"fill-opacity:0;stroke:grey;stroke-width:2\" width=\"" << SVGWidth << "\" height=\"" << SVGHeight << "\" />\n";
+
+	// Legend Text
+	SVGFile << "\t<text x=\"" << FontSize << "\" y=\"" << FontSize + 2 << "\">" << Title << " Wind Rose (24 hours)</text>\n";
+	SVGFile << "\t<text style=\"text-anchor:end\" x=\"" << SVGWidth - FontSize << "\" y=\"" << FontSize + 2 << "\">" << timeToExcelLocal(TheSummary.NewestTime) << "</text>\n";
+
+	// Petals, widest band first so the slower bands are drawn over them
+	SVGFile << "\t<!-- Petals -->\n";
+	for (auto band = RAPID_WIND_BANDS - 1; band > 0; band--)
+		for (auto sector = 0; sector < RAPID_WIND_SECTORS; sector++)
+			if (TheSummary.Histogram[sector][band] > 0)	// an empty band would be hidden under the next slower one
+			{
+				const double Center = sector * 360.0 / RAPID_WIND_SECTORS;
+				const double HalfWidth = 360.0 / RAPID_WIND_SECTORS / 2 * 0.8;
+				const double Radius = Percent[sector][band] * RadiusFactor;
+				SVGFile << "\t<polygon style=\"fill:" << BandColors[band] << "\" points=\"" << RoseX << "," << RoseY << " " << RoseX2(Center - HalfWidth, Radius) << "," << RoseY2(Center - HalfWidth, Radius) << " " << RoseX2(Center + HalfWidth, Radius) << "," << RoseY2(Center + HalfWidth, Radius) << "\" />\n";
+			}
+
+	// Frequency circles and compass points
+	for (auto circle = 1; circle <= CircleCount; circle++)
+	{
+		SVGFile << "\t<circle cx=\"" << RoseX << "\" cy=\"" << RoseY << "\" r=\"" << int(circle * CircleStep * RadiusFactor) << "\" />\n";
+		SVGFile << "\t<text style=\"font-size:" << FontSize - 2 << "px\" x=\"" << RoseX2(22.5, circle * CircleStep * RadiusFactor) + 2 << "\" y=\"" << RoseY2(22.5, circle * CircleStep * RadiusFactor) << "\">" << circle * CircleStep << "%</text>\n";
+	}
+	SVGFile << "\t<line x1=\"" << RoseX << "\" y1=\"" << RoseY - RoseRadius << "\" x2=\"" << RoseX << "\" y2=\"" << RoseY + RoseRadius << "\" />\n";
+	SVGFile << "\t<line x1=\"" << RoseX - RoseRadius << "\" y1=\"" << RoseY << "\" x2=\"" << RoseX + RoseRadius << "\" y2=\"" << RoseY << "\" />\n";
+	SVGFile << "\t<text style=\"text-anchor:middle\" x=\"" << RoseX << "\" y=\"" << RoseY - RoseRadius - 2 << "\">N</text>\n";
+	SVGFile << "\t<text style=\"text-anchor:middle;dominant-baseline:hanging\" x=\"" << RoseX << "\" y=\"" << RoseY + RoseRadius + 2 << "\">S</text>\n";
+	SVGFile << "\t<text style=\"dominant-baseline:middle\" x=\"" << RoseX + RoseRadius + 2 << "\" y=\"" << RoseY << "\">E</text>\n";
+	SVGFile << "\t<text style=\"text-anchor:end;dominant-baseline:middle\" x=\"" << RoseX - RoseRadius - 2 << "\" y=\"" << RoseY << "\">W</text>\n";
+
+	// Mean vector wind over the last 10 minutes as an arrow pointing downwind
+	if (TheSummary.MeanSpeed10 > 0)
+	{
+		const double Length = RoseRadius / 2.0;
+		const double Downwind = TheSummary.MeanDirection10 + 180;
+		SVGFile << "\t<!-- Mean Wind -->\n";
+		SVGFile << "\t<line style=\"stroke:black;stroke-width:2\" x1=\"" << RoseX2(TheSummary.MeanDirection10, Length) << "\" y1=\"" << RoseY2(TheSummary.MeanDirection10, Length) << "\" x2=\"" << RoseX2(Downwind, Length) << "\" y2=\"" << RoseY2(Downwind, Length) << "\" />\n";
+		SVGFile << "\t<polygon style=\"fill:black;stroke:black\" points=\"" << RoseX2(Downwind, Length + 6) << "," << RoseY2(Downwind, Length + 6) << " " << RoseX2(Downwind - 8, Length - 4) << "," << RoseY2(Downwind - 8, Length - 4) << " " << RoseX2(Downwind + 8, Length - 4) << "," << RoseY2(Downwind + 8, Length - 4) << "\" />\n";
+	}
+
+	// Speed band key and the current wind
+	int LegendY = FontSize * 4;
+	for (auto band = 1; band < RAPID_WIND_BANDS; band++)
+	{
+		SVGFile << "\t<rect style=\"fill:" << BandColors[band] << "\" x=\"" << LegendLeft << "\" y=\"" << LegendY - FontSize + 2 << "\" width=\"" << FontSize << "\" height=\"" << FontSize - 2 << "\" />\n";
+		SVGFile << "\t<text x=\"" << LegendLeft + FontSize + 4 << "\" y=\"" << LegendY << "\">" << BandNames[band] << "</text>\n";
+		LegendY += FontSize + 4;
+	}
+	SVGFile << "\t<text x=\"" << LegendLeft << "\" y=\"" << LegendY << "\">" << BandNames[0] << " " << FixedPoint(Calm, 1) << "%</text>\n";
+	LegendY += (FontSize + 4) * 2;
+	SVGFile << "\t<text x=\"" << LegendLeft << "\" y=\"" << LegendY << "\">2 min: " << FixedPoint(TheSummary.MeanSpeed2, 1) << " kn from " << int(std::lround(TheSummary.MeanDirection2)) % 360 << "&#176;</text>\n";
+	LegendY += FontSize + 4;
+	SVGFile << "\t<text x=\"" << LegendLeft << "\" y=\"" << LegendY << "\">10 min: " << FixedPoint(TheSummary.MeanSpeed10, 1) << " kn from " << int(std::lround(TheSummary.MeanDirection10)) % 360 << "&#176;</text>\n";
+	LegendY += FontSize + 4;
+	SVGFile << "\t<text x=\"" << LegendLeft << "\" y=\"" << LegendY << "\">10 min gust: " << FixedPoint(TheSummary.Gust10, 1) << " kn</text>\n";
+	LegendY += FontSize + 4;
+	SVGFile << "\t<text x=\"" << LegendLeft << "\" y=\"" << LegendY << "\">" << TheSummary.Count << " samples</text>\n";
+
+	SVGFile << "</svg>\n";
+}
+/////////////////////////////////////////////////////////////////////////////
+// The columns of the JSON and CSV data files after the time, in the units the rings hold: C, %, mb station pressure, knots, degrees, lux, W/m^2, mm and volts.
+struct DataColumn
+{
+	const char* Name;
+	double(*Value)(const TempestSeries& TheValues, const size_t index);
+};
+const std::array<DataColumn, 21> DataColumns = { {
+	{ "temperature", [](const TempestSeries& TheValues, const size_t index) { return(TheValues.Temperature[index]); } },
+	{ "temperature_min", [](const TempestSeries& TheValues, const size_t index) { return(TheValues.TemperatureMin[index]); } },
+	{ "temperature_max", [](const TempestSeries& TheValues, const size_t index) { return(TheValues.TemperatureMax[index]); } },
+	{ "humidity", [](const TempestSeries& TheValues, const size_t index) { return(TheValues.Humidity[index]); } },
+	{ "humidity_min", [](const TempestSeries& TheValues, const size_t index) { return(TheValues.HumidityMin[index]); } },
+	{ "humidity_max", [](const TempestSeries& TheValues, const size_t index) { return(TheValues.HumidityMax[index]); } },
+	{ "pressure", [](const TempestSeries& TheValues, const size_t index) { return(TheValues.OutsidePressure[index]); } },
+	{ "pressure_min", [](const TempestSeries& TheValues, const size_t index) { return(TheValues.OutsidePressureMin[index]); } },
+	{ "pressure_max", [](const TempestSeries& TheValues, const size_t index) { return(TheValues.OutsidePressureMax[index]); } },
+	{ "wind_speed", [](const TempestSeries& TheValues, const size_t index) { return(TheValues.WindSpeed[index]); } },
+	{ "wind_speed_min", [](const TempestSeries& TheValues, const size_t index) { return(TheValues.WindSpeedMin[index]); } },
+	{ "wind_speed_max", [](const TempestSeries& TheValues, const size_t index) { return(TheValues.WindSpeedMax[index]); } },
+	{ "wind_direction", [](const TempestSeries& TheValues, const size_t index) { return(double(TempestObservation::GetWindBearing(TheValues.WindX[index], TheValues.WindY[index]))); } },
+	{ "illuminance", [](const TempestSeries& TheValues, const size_t index) { return(double(TheValues.Illuminance[index])); } },
+	{ "uv", [](const TempestSeries& TheValues, const size_t index) { return(double(TheValues.UV[index])); } },
+	{ "uv_max", [](const TempestSeries& TheValues, const size_t index) { return(double(TheValues.UVMax[index])); } },
+	{ "solar_radiation", [](const TempestSeries& TheValues, const size_t index) { return(double(TheValues.SolarRadiation[index])); } },
+	{ "solar_radiation_max", [](const TempestSeries& TheValues, const size_t index) { return(double(TheValues.SolarRadiationMax[index])); } },
+	{ "rain", [](const TempestSeries& TheValues, const size_t index) { return(double(TheValues.Rain[index])); } },
+	{ "lightning_count", [](const TempestSeries& TheValues, const size_t index) { return(double(TheValues.LightningCount[index])); } },
+	{ "battery", [](const TempestSeries& TheValues, const size_t index) { return(TheValues.Battery[index]); } },
+} };
+// Appends one value of a data file, or Missing when the sample has none, like a battery that never reported
+inline void WriteDataValue(SVGBuffer& DataFile, const double Value, const char* Missing)
+{
+	if (std::isfinite(Value) && (std::fabs(Value) < DBL_MAX))
+		DataFile << Value;
+	else
+		DataFile << Missing;
+}
+// Writes the samples of a non-empty series as JSON, a row of values per sample in the order of "columns", oldest first, which is the order a chart draws them.
+// "newest" is the time of the newest data, the same time the graphs are labeled with.
+void RenderDataJSON(SVGBuffer& DataFile, const TempestSeries& TheValues, const std::string& Title)
+{
+	DataFile << "{\"title\":\"" << Title << "\",\"newest\":" << TheValues.NewestTime << ",\"columns\":[\"time\"";
+	for (auto const& Column : DataColumns)
+		DataFile << ",\"" << Column.Name << "\"";
+	DataFile << "],\"rows\":[";
+	for (auto index = TheValues.size(); index > 0; index--)
+	{
+		DataFile << ((index == TheValues.size()) ? "\n[" : ",\n[") << TheValues.Time[index - 1];
+		for (auto const& Column : DataColumns)
+		{
+			DataFile << ',';
+			WriteDataValue(DataFile, Column.Value(TheValues, index - 1), "null");
 		}
+		DataFile << ']';
 	}
+	DataFile << "]}\n";
 }
-enum class GraphType { daily, weekly, monthly, yearly };
-// Returns a curated vector of data points specific to the requested graph type from the internal memory structure map keyed off the Bluetooth address.
-void ReadMRTGData(std::vector<TempestObservation>& TheValues, const GraphType graph = GraphType::daily)
-{
-	if (TempestMRTGLogs.size() > 0)
-	{
-		auto DaySampleFirst = TempestMRTGLogs.begin() + 2;
-		auto DaySampleLast = TempestMRTGLogs.begin() + 1 + DAY_COUNT;
-		auto WeekSampleFirst = TempestMRTGLogs.begin() + 2 + DAY_COUNT;
-		auto WeekSampleLast = TempestMRTGLogs.begin() + 1 + DAY_COUNT + WEEK_COUNT;
-		auto MonthSampleFirst = TempestMRTGLogs.begin() + 2 + DAY_COUNT + WEEK_COUNT;
-		auto MonthSampleLast = TempestMRTGLogs.begin() + 1 + DAY_COUNT + WEEK_COUNT + MONTH_COUNT;
-		auto YearSampleFirst = TempestMRTGLogs.begin() + 2 + DAY_COUNT + WEEK_COUNT + MONTH_COUNT;
-		auto YearSampleLast = TempestMRTGLogs.begin() + 1 + DAY_COUNT + WEEK_COUNT + MONTH_COUNT + YEAR_COUNT;
-		if (graph == GraphType::daily)
+// Writes the samples of a non-empty series as CSV with a header line, oldest first. A missing value is left empty.
+void RenderDataCSV(SVGBuffer& DataFile, const TempestSeries& TheValues)
+{
+	DataFile << "time";
+	for (auto const& Column : DataColumns)
+		DataFile << ',' << Column.Name;
+	DataFile << '\n';
+	for (auto index = TheValues.size(); index > 0; index--)
+	{
+		DataFile << TheValues.Time[index - 1];
+		for (auto const& Column : DataColumns)
 		{
-			TheValues.resize(DAY_COUNT);
-			std::copy(DaySampleFirst, DaySampleLast, TheValues.begin());
-			auto iter = TheValues.begin();
-			while (iter->IsValid() && (iter != TheValues.end()))
-				iter++;
-			TheValues.resize(iter - TheValues.begin());
-			TheValues.begin()->Time = TempestMRTGLogs.begin()->Time; //HACK: include the most recent time sample
+			DataFile << ',';
+			WriteDataValue(DataFile, Column.Value(TheValues, index - 1), "");
 		}
-		else if (graph == GraphType::weekly)
+		DataFile << '\n';
+	}
+}
+/////////////////////////////////////////////////////////////////////////////
+// One of the graphs, or data files, drawn for each device. Render draws it into an SVGBuffer from a snapshot when its newest data is later than Since,
+// and returns the time of that data, or 0 when it drew nothing. The time axis layouts passed to it have to belong to the same device as the snapshot. The same table feeds the files in the SVG directory and the web server.
+class SVGGraph {
+public:
+	std::string Name;	// the end of the file name, weatherflow-<serial>-<Name>
+	std::string ContentType;	// served by the web server
+	GraphType Type;	// whose generation says when it has to be drawn again
+	bool RapidWind;	// drawn from the rapid wind summary instead of the rings, and drawn again when the summary's generation changes
+	std::function<time_t(SVGBuffer&, const TempestMRTGSnapshot&, const RapidWindSummary&, TimeAxisLayouts&, const std::string&, const time_t)> Render;
+};
+// Wraps a function drawing a TempestSeries as an SVGGraph of one graph type
+template <class DrawFunction>
+SVGGraph MakeSVGGraph(const std::string& Name, const GraphType graph, DrawFunction DrawSeries, const std::string& ContentType = "image/svg+xml")
+{
+	return(SVGGraph{ Name, ContentType, graph, false, [graph, DrawSeries](SVGBuffer& SVGFile, const TempestMRTGSnapshot& TheData, const RapidWindSummary&, TimeAxisLayouts& TimeAxis, const std::string& Title, const time_t Since)
 		{
-			TheValues.resize(WEEK_COUNT);
-			std::copy(WeekSampleFirst, WeekSampleLast, TheValues.begin());
-			auto iter = TheValues.begin();
-			while (iter->IsValid() && (iter != TheValues.end()))
-				iter++;
-			TheValues.resize(iter - TheValues.begin());
+			time_t rval = 0;
+			const TempestSeries TheValues(ReadMRTGData(TheData, graph));
+			if (!TheValues.empty() && (TheValues.NewestTime > Since))
+			{
+				DrawSeries(SVGFile, TheValues, Title, graph, TimeAxis[int(graph)]);
+				rval = TheValues.NewestTime;
+			}
+			return(rval);
+		} });
+}
+// The bit of the --battery, --minmax, --simplify and --envelope graph masks for a graph type. 1:daily, 2:weekly, 4:monthly, 8:yearly
+inline int GraphBit(const GraphType graph) { return(1 << int(graph)); }
+const std::vector<SVGGraph>& GetSVGGraphs(void)
+{
+	static const std::vector<SVGGraph> Graphs = []()
+	{
+		auto Temperature = [](SVGBuffer& SVGFile, const TempestSeries& TheValues, const std::string& Title, const GraphType graph, TimeAxisLayout& TimeAxis) { RenderTemperatureSVG(SVGFile, TheValues, Title, graph, TimeAxis, SVGFahrenheit, SVGBattery & GraphBit(graph), (SVGMinMax | SVGEnvelope) & GraphBit(graph), SVGSimplify & GraphBit(graph), SVGEnvelope & GraphBit(graph)); };
+		auto Wind = [](SVGBuffer& SVGFile, const TempestSeries& TheValues, const std::string& Title, const GraphType graph, TimeAxisLayout& TimeAxis) { RenderWindSVG(SVGFile, TheValues, Title, graph, TimeAxis, true, graph == GraphType::daily ? 1.0 : 4.0, SVGSimplify & GraphBit(graph), SVGEnvelope & GraphBit(graph)); };
+		auto Rain = [](SVGBuffer& SVGFile, const TempestSeries& TheValues, const std::string& Title, const GraphType graph, TimeAxisLayout& TimeAxis) { RenderRainSVG(SVGFile, TheValues, Title, graph, TimeAxis, SVGSimplify & GraphBit(graph), SVGEnvelope & GraphBit(graph)); };
+		auto DataJSON = [](SVGBuffer& DataFile, const TempestSeries& TheValues, const std::string& Title, const GraphType, TimeAxisLayout&) { RenderDataJSON(DataFile, TheValues, Title); };
+		auto DataCSV = [](SVGBuffer& DataFile, const TempestSeries& TheValues, const std::string&, const GraphType, TimeAxisLayout&) { RenderDataCSV(DataFile, TheValues); };
+		auto Solar = [](SVGBuffer& SVGFile, const TempestSeries& TheValues, const std::string& Title, const GraphType graph, TimeAxisLayout& TimeAxis) { RenderSolarSVG(SVGFile, TheValues, Title, graph, TimeAxis, (SVGMinMax | SVGEnvelope) & GraphBit(graph), SVGSimplify & GraphBit(graph), SVGEnvelope & GraphBit(graph)); };
+		const std::array<std::pair<GraphType, std::string>, 4> Periods = { std::make_pair(GraphType::daily, "day"), std::make_pair(GraphType::weekly, "week"), std::make_pair(GraphType::monthly, "month"), std::make_pair(GraphType::yearly, "year") };
+		std::vector<SVGGraph> rval;
+		for (auto const& [graph, Period] : Periods)
+		{
+			rval.push_back(MakeSVGGraph("temperature-" + Period + ".svg", graph, Temperature));
+			rval.push_back(MakeSVGGraph("wind-" + Period + ".svg", graph, Wind));
 		}
-		else if (graph == GraphType::monthly)
+		for (auto const& [graph, Period] : Periods)
 		{
-			TheValues.resize(MONTH_COUNT);
-			std::copy(MonthSampleFirst, MonthSampleLast, TheValues.begin());
-			auto iter = TheValues.begin();
-			while (iter->IsValid() && (iter != TheValues.end()))
-				iter++;
-			TheValues.resize(iter - TheValues.begin());
+			rval.push_back(MakeSVGGraph("rain-" + Period + ".svg", graph, Rain));
+			rval.push_back(MakeSVGGraph("solar-" + Period + ".svg", graph, Solar));
 		}
-		else if (graph == GraphType::yearly)
+		rval.push_back(SVGGraph{ "windrose.svg", "image/svg+xml", GraphType::daily, true, [](SVGBuffer& SVGFile, const TempestMRTGSnapshot&, const RapidWindSummary& TheSummary, TimeAxisLayouts&, const std::string& Title, const time_t Since)
+			{
+				time_t rval = 0;
+				if ((TheSummary.Count > 0) && (TheSummary.NewestTime > Since))
+				{
+					RenderWindRoseSVG(SVGFile, TheSummary, Title);
+					rval = TheSummary.NewestTime;
+				}
+				return(rval);
+			} });
+		for (auto const& [graph, Period] : Periods)
 		{
-			TheValues.resize(YEAR_COUNT);
-			std::copy(YearSampleFirst, YearSampleLast, TheValues.begin());
-			auto iter = TheValues.begin();
-			while (iter->IsValid() && (iter != TheValues.end()))
-				iter++;
-			TheValues.resize(iter - TheValues.begin());
+			rval.push_back(MakeSVGGraph(Period + ".json", graph, DataJSON, "application/json"));
+			rval.push_back(MakeSVGGraph(Period + ".csv", graph, DataCSV, "text/csv"));
 		}
-	}
+		return(rval);
+	}();
+	return(Graphs);
 }
-/////////////////////////////////////////////////////////////////////////////
-void WriteTemperatureSVG(std::vector<TempestObservation>& TheValues, const std::filesystem::path& SVGFileName, const std::string& Title = "", const GraphType graph = GraphType::daily, const bool Fahrenheit = true, const bool DrawBattery = false, const bool MinMax = false)
-{
-	if (!TheValues.empty())
-	{
-		// By declaring these items here, I'm then basing all my other dimensions on these
-		const int SVGWidth(500);
-		const int SVGHeight(135);
-		const int FontSize(12);
-		const int TickSize(2);
-		int GraphWidth = SVGWidth - (FontSize * 5);
-		const bool DrawHumidity = TheValues[0].GetHumidity() != 0; // HACK: I should really check the entire data set
-		struct stat64 SVGStat({ 0 });	// Zero the stat64 structure on allocation
+// Writes one graph of a device to its file. With CheckFile, only when there's data newer than the file, otherwise the caller already knows the data changed.
+bool WriteSVG(const SVGGraph& Graph, const std::filesystem::path& SVGFileName, const TempestMRTGSnapshot& TheData, const RapidWindSummary& RapidWindSnapshot, TimeAxisLayouts& TimeAxis, const std::string& Title, const bool CheckFile)
+{
+	bool rval = false;
+	struct stat64 SVGStat({ 0 });	// Zero the stat64 structure on allocation
+	if (CheckFile)
 		if (-1 == stat64(SVGFileName.c_str(), &SVGStat))
 			if (ConsoleVerbosity > 3)
 				std::cout << "[" << getTimeISO8601(true) << "] " << std::strerror(errno) << ": " << SVGFileName << std::endl;
-		if (TheValues.begin()->Time > SVGStat.st_mtim.tv_sec)	// only write the file if we have new data
+	thread_local SVGBuffer SVGFile;	// each render thread keeps its buffer, so the memory is only allocated once
+	SVGFile.clear();
+	const time_t NewestTime(Graph.Render(SVGFile, TheData, RapidWindSnapshot, TimeAxis, Title, SVGStat.st_mtim.tv_sec));	// only draws the graph if we have new data
+	if (NewestTime > 0)
+	{
+		if (ConsoleVerbosity > 0)
+			std::cout << "[" << getTimeISO8601() << "] Writing: " << SVGFileName.string() << " With Title: " << Title << std::endl;
+		else
+			std::cerr << "Writing: " << SVGFileName.string() << " With Title: " << Title << std::endl;
+		rval = PublishSVG(SVGFileName, SVGFile.view(), NewestTime);
+	}
+	return(rval);
+}
+/////////////////////////////////////////////////////////////////////////////
+// Points a file name from before there was more than one device at the file of one device, so existing web pages keep working.
+// The link is relative and replaced with a rename, so a web server never sees it missing.
+void LinkLegacySVG(const std::filesystem::path& SVGFileName, const std::filesystem::path& LegacyFileName)
+{
+	std::error_code ec;
+	if (std::filesystem::exists(SVGFileName, ec) && !(std::filesystem::is_symlink(LegacyFileName, ec) && (std::filesystem::read_symlink(LegacyFileName, ec) == SVGFileName.filename())))
+	{
+		std::filesystem::path TempFileName(LegacyFileName);
+		TempFileName += ".tmp";
+		std::filesystem::remove(TempFileName, ec);
+		std::filesystem::create_symlink(SVGFileName.filename(), TempFileName, ec);
+		if (!ec)
+			std::filesystem::rename(TempFileName, LegacyFileName, ec);
+		if (ec)
+			std::cerr << LegacyFileName << " " << ec.message() << std::endl;
+	}
+}
+// Renders the given SVG files of one device from one snapshot of its data. SVGRenderThreads threads take the graphs in turn until all have been written.
+// The legacy file name of a graph is linked when its file is written, and on the first render of a device, which is when CheckFiles is set.
+void RenderAllSVG(const TempestMRTGSnapshot Snapshot, const RapidWindSummary RapidWindSnapshot, TimeAxisLayouts& TimeAxis, const std::string Serial, const std::vector<const SVGGraph*> Graphs, const bool CheckFiles, const bool LegacyNames)
+{
+	const std::string ssTitle("Tempest " + Serial);
+	const std::string Prefix("weatherflow-" + Serial + "-");
+	std::atomic<size_t> NextGraph(0);
+	auto RenderGraphs = [&]()
+	{
+		for (auto index = NextGraph++; index < Graphs.size(); index = NextGraph++)
+		{
+			const std::filesystem::path SVGFileName(SVGDirectory / (Prefix + Graphs[index]->Name));
+			const auto RenderStart = std::chrono::steady_clock::now();
+			if (WriteSVG(*Graphs[index], SVGFileName, Snapshot, RapidWindSnapshot, TimeAxis, ssTitle, CheckFiles) || CheckFiles)
+				if (LegacyNames)
+					LinkLegacySVG(SVGFileName, SVGDirectory / ("weatherflow-" + Graphs[index]->Name));
+			const std::chrono::duration<double, std::milli> RenderTime(std::chrono::steady_clock::now() - RenderStart);
+			if (ConsoleVerbosity > 0)
+			{
+				std::ostringstream Timing;	// built first so lines from different threads don't interleave
+				Timing << "[" << getTimeISO8601() << "] Rendered: " << SVGFileName.filename().string() << " in " << std::fixed << std::setprecision(1) << RenderTime.count() << " ms" << std::endl;
+				std::cout << Timing.str() << std::flush;
+			}
+		}
+	};
+	std::vector<std::thread> Workers;
+	while (Workers.size() + 1 < std::min(size_t(SVGRenderThreads), Graphs.size()))
+		Workers.emplace_back(RenderGraphs);
+	RenderGraphs();
+	for (auto& Worker : Workers)
+		Worker.join();
+}
+// Starts rendering the SVG files of each device from a snapshot of its rings and rapid wind summary on another thread, so the receive loop keeps draining the socket.
+// Only the graphs whose generation has advanced since they were last rendered are drawn, so the weekly, monthly and yearly files
+// are left alone until their rings move, and the files aren't looked at. The first render of each device checks every file against its data instead.
+// Each device renders on its own, and if its previous render still hasn't finished, this one is skipped and the next period picks up the new data.
+void WriteAllSVG(void)
+{
+	std::string LegacySerial;	// the device with the lowest serial number also keeps the file names from before there was more than one
+	for (auto const& [Serial, Device] : TempestDevices)
+		if (!Device.MRTG.empty() && (LegacySerial.empty() || (Serial < LegacySerial)))
+			LegacySerial = Serial;
+	for (auto& [Serial, Device] : TempestDevices)
+		if (!Device.MRTG.empty())
 		{
-			std::ofstream SVGFile(SVGFileName);
-			if (SVGFile.is_open())
+			if (Device.SVGRendering.valid() && (Device.SVGRendering.wait_for(std::chrono::seconds(0)) != std::future_status::ready))
 			{
 				if (ConsoleVerbosity > 0)
-					std::cout << "[" << getTimeISO8601() << "] Writing: " << SVGFileName.string() << " With Title: " << Title << std::endl;
-				else
-					std::cerr << "Writing: " << SVGFileName.string() << " With Title: " << Title << std::endl;
-				std::ostringstream tempOString;
-				tempOString << "Temperature (" << std::fixed << std::setprecision(1) << TheValues[0].GetTemperature(Fahrenheit) << (Fahrenheit ? "°F)" : "°C)");
-				std::string YLegendTemperature(tempOString.str());
-				tempOString = std::ostringstream();
-				tempOString << "Humidity (" << std::fixed << std::setprecision(1) << TheValues[0].GetHumidity() << "%)";
-				std::string YLegendHumidity(tempOString.str());
-				tempOString = std::ostringstream();
-				tempOString << "Battery (" << TheValues[0].GetBattery() << "%)";
-				std::string YLegendBattery(tempOString.str());
-				int GraphTop = FontSize + TickSize;
-				int GraphBottom = SVGHeight - GraphTop;
-				int GraphRight = SVGWidth - GraphTop;
-				if (DrawHumidity)
-				{
-					GraphWidth -= FontSize * 2;
-					GraphRight -= FontSize + TickSize * 2;
-				}
-				if (DrawBattery)
-					GraphWidth -= FontSize;
-				int GraphLeft = GraphRight - GraphWidth;
-				int GraphVerticalDivision = (GraphBottom - GraphTop) / 4;
-				double TempMin = DBL_MAX;
-				double TempMax = -DBL_MAX;
-				double HumiMin = DBL_MAX;
-				double HumiMax = -DBL_MAX;
-				if (MinMax)
-					for (auto index = 0; index < (GraphWidth < TheValues.size() ? GraphWidth : TheValues.size()); index++)
-					{
-						TempMin = std::min(TempMin, TheValues[index].GetTemperatureMin(Fahrenheit));
-						TempMax = std::max(TempMax, TheValues[index].GetTemperatureMax(Fahrenheit));
-						HumiMin = std::min(HumiMin, TheValues[index].GetHumidityMin());
-						HumiMax = std::max(HumiMax, TheValues[index].GetHumidityMax());
-					}
-				else
-					for (auto index = 0; index < (GraphWidth < TheValues.size() ? GraphWidth : TheValues.size()); index++)
-					{
-						TempMin = std::min(TempMin, TheValues[index].GetTemperature(Fahrenheit));
-						TempMax = std::max(TempMax, TheValues[index].GetTemperature(Fahrenheit));
-						HumiMin = std::min(HumiMin, TheValues[index].GetHumidity());
-						HumiMax = std::max(HumiMax, TheValues[index].GetHumidity());
-					}
-
-				double TempVerticalDivision = (TempMax - TempMin) / 4;
-				double TempVerticalFactor = (GraphBottom - GraphTop) / (TempMax - TempMin);
-				double HumiVerticalDivision = (HumiMax - HumiMin) / 4;
-				double HumiVerticalFactor = (GraphBottom - GraphTop) / (HumiMax - HumiMin);
-				int FreezingLine = 0; // outside the range of the graph
-				if (Fahrenheit)
-				{
-					if ((TempMin < 32) && (32 < TempMax))
-						FreezingLine = ((TempMax - 32.0) * TempVerticalFactor) + GraphTop;
-				}
+					std::cout << "[" << getTimeISO8601() << "] Previous SVG files of " << Serial << " are still being rendered, skipping this update" << std::endl;
 				else
+					std::cerr << "Previous SVG files of " << Serial << " are still being rendered, skipping this update" << std::endl;
+			}
+			else
+			{
+				Device.Snapshot.Update(Device.MRTG);
+				const RapidWindSummary RapidWindSnapshot(Device.RapidWind.GetSummary());
+				std::vector<const SVGGraph*> Changed;
+				for (auto const& Graph : GetSVGGraphs())
+					if (!Device.SVGFilesChecked || (Graph.RapidWind ? (RapidWindSnapshot.Generation != Device.SVGRapidWindGeneration) : (Device.Snapshot.Generation[int(Graph.Type)] != Device.SVGGeneration[int(Graph.Type)])))
+						Changed.push_back(&Graph);
+				if (!Changed.empty())
 				{
-					if ((TempMin < 0) && (0 < TempMax))
-						FreezingLine = (TempMax * TempVerticalFactor) + GraphTop;
+					Device.SVGRendering = std::async(std::launch::async, RenderAllSVG, Device.Snapshot, RapidWindSnapshot, std::ref(Device.SVGTimeAxis), Serial, Changed, !Device.SVGFilesChecked, Serial == LegacySerial);
+					Device.SVGFilesChecked = true;
+					Device.SVGGeneration = Device.Snapshot.Generation;
+					Device.SVGRapidWindGeneration = RapidWindSnapshot.Generation;
 				}
+			}
+		}
+}
+/////////////////////////////////////////////////////////////////////////////
+// The built in web server serves the same graphs as the SVG files straight from memory, on its own thread with an epoll loop.
+// The receive loop hands each device's newest snapshot over through HTTPDevices. A graph is rendered the first time it's asked for
+// after its snapshot changes, and kept with an ETag, so browsers polling every minute mostly get a 304 without anything being drawn.
+class HTTPDevice {
+public:
+	TempestMRTGSnapshot MRTG;
+	RapidWindSummary RapidWind;
+};
+std::mutex HTTPDevicesMutex;
+std::map<std::string, HTTPDevice> HTTPDevices;	// replaced by the receive loop, copied by the server thread
+// Called from the receive loop after each batch of messages. Only the rings that changed are copied, before taking the lock, so the server thread never waits on a copy.
+void PublishHTTPSnapshots(void)
+{
+	for (auto& [Serial, Device] : TempestDevices)
+		if (!Device.MRTG.empty())
+		{
+			Device.Snapshot.Update(Device.MRTG);
+			const RapidWindSummary RapidWindSnapshot(Device.RapidWind.GetSummary());
+			std::lock_guard<std::mutex> lock(HTTPDevicesMutex);
+			HTTPDevice& Published(HTTPDevices[Serial]);
+			Published.MRTG = Device.Snapshot;
+			Published.RapidWind = RapidWindSnapshot;
+		}
+}
+// HTTP dates are always GMT, like Sun, 06 Nov 1994 08:49:37 GMT
+std::string getTimeHTTP(const time_t TheTime)
+{
+	char buffer[64] = { 0 };
+	struct tm UTC;
+	if (0 != strftime(buffer, sizeof(buffer), "%a, %d %b %Y %H:%M:%S GMT", gmtime_r(&TheTime, &UTC)))
+		return(std::string(buffer));
+	return("");
+}
+// FNV-1a, only used to make an ETag from the bytes of a rendered graph
+uint64_t HashFNV1a(const std::string_view TheData)
+{
+	uint64_t rval = 14695981039346656037ull;
+	for (const unsigned char c : TheData)
+		rval = (rval ^ c) * 1099511628211ull;
+	return(rval);
+}
+// Returns the value of a request header, or an empty view. Header names are compared without case.
+std::string_view GetHTTPHeader(const std::string_view Headers, const std::string_view Name)
+{
+	std::string_view rval;
+	for (size_t Start = Headers.find("\r\n"); (Start != std::string_view::npos) && rval.empty(); Start = Headers.find("\r\n", Start + 2))
+	{
+		const std::string_view Line(Headers.substr(Start + 2, Headers.find("\r\n", Start + 2) - (Start + 2)));
+		if ((Line.size() > Name.size()) && (Line[Name.size()] == ':') && std::equal(Name.begin(), Name.end(), Line.begin(), [](const char a, const char b) { return(std::tolower(static_cast<unsigned char>(a)) == std::tolower(static_cast<unsigned char>(b))); }))
+		{
+			rval = Line.substr(Name.size() + 1);
+			while (!rval.empty() && ((rval.front() == ' ') || (rval.front() == '\t')))
+				rval.remove_prefix(1);
+			while (!rval.empty() && ((rval.back() == ' ') || (rval.back() == '\t')))
+				rval.remove_suffix(1);
+		}
+	}
+	return(rval);
+}
+// True if an If-None-Match list holds ETag, or is *. Weak validators compare the same as strong ones for a GET.
+bool MatchETag(std::string_view IfNoneMatch, const std::string_view ETag)
+{
+	bool rval = false;
+	while (!IfNoneMatch.empty() && !rval)
+	{
+		const size_t Comma = IfNoneMatch.find(',');
+		std::string_view Tag(IfNoneMatch.substr(0, Comma));
+		IfNoneMatch = (Comma == std::string_view::npos) ? std::string_view() : IfNoneMatch.substr(Comma + 1);
+		while (!Tag.empty() && (Tag.front() == ' '))
+			Tag.remove_prefix(1);
+		while (!Tag.empty() && (Tag.back() == ' '))
+			Tag.remove_suffix(1);
+		if (Tag.substr(0, 2) == "W/")
+			Tag.remove_prefix(2);
+		rval = (Tag == "*") || (Tag == ETag);
+	}
+	return(rval);
+}
+// A graph the server has rendered, kept until the generation of its data changes
+class HTTPRendered {
+public:
+	uint64_t Generation = 0;
+	time_t NewestTime = 0;
+	std::string ETag;
+	std::string Body;
+};
+std::string HTTPStatus(const int Status, const std::string_view Reason, const bool Close, const std::string_view ExtraHeaders = "", const std::string_view Body = "", const bool SendBody = true)
+{
+	std::string rval("HTTP/1.1 " + std::to_string(Status) + " " + std::string(Reason) + "\r\n");
+	rval.append("Date: " + getTimeHTTP(time(nullptr)) + "\r\n");
+	rval.append(ExtraHeaders);
+	if (Status != 304)
+		rval.append("Content-Length: " + std::to_string(Body.size()) + "\r\n");
+	if (Close)
+		rval.append("Connection: close\r\n");
+	rval.append("\r\n");
+	if (SendBody)
+		rval.append(Body);
+	return(rval);
+}
+// Answers one complete request, whose request line and headers are in Request. Close is set when the connection shouldn't be kept open afterwards.
+std::string HTTPResponse(const std::string_view Request, std::map<std::string, HTTPRendered>& Rendered, std::map<std::string, TimeAxisLayouts>& TimeAxis, bool& Close)
+{
+	const std::string_view RequestLine(Request.substr(0, Request.find("\r\n")));
+	const size_t MethodEnd = RequestLine.find(' ');
+	const size_t TargetEnd = RequestLine.find(' ', MethodEnd == std::string_view::npos ? MethodEnd : MethodEnd + 1);
+	if ((MethodEnd == std::string_view::npos) || (TargetEnd == std::string_view::npos))
+	{
+		Close = true;
+		return(HTTPStatus(400, "Bad Request", Close));
+	}
+	const std::string_view Method(RequestLine.substr(0, MethodEnd));
+	std::string_view Target(RequestLine.substr(MethodEnd + 1, TargetEnd - (MethodEnd + 1)));
+	Target = Target.substr(0, Target.find('?'));
+	const std::string_view Version(RequestLine.substr(TargetEnd + 1));
+	std::string Connection(GetHTTPHeader(Request, "Connection"));
+	std::transform(Connection.begin(), Connection.end(), Connection.begin(), [](const unsigned char c) { return(std::tolower(c)); });
+	Close = (Version == "HTTP/1.0") ? (Connection != "keep-alive") : (Connection == "close");
+	const bool SendBody = (Method != "HEAD");
+	if ((Method != "GET") && (Method != "HEAD"))
+		return(HTTPStatus(405, "Method Not Allowed", Close, "Allow: GET, HEAD\r\n"));
 
-				SVGFile << "<?xml version=\"1.0\" encoding=\"utf-8\" standalone=\"no\"?>" << std::endl;
-				SVGFile << "<svg xmlns=\"http://www.w3.org/2000/svg\" xmlns:xlink=\"http://www.w3.org/1999/xlink\" width=\"" << SVGWidth << "\" height=\"" << SVGHeight << "\">" << std::endl;
-				SVGFile << "\t<!-- Created by: " << ProgramVersionString << " -->" << std::endl;
-				SVGFile << "\t<clipPath id=\"GraphRegion\"><polygon points=\"" << GraphLeft << "," << GraphTop << " " << GraphRight << "," << GraphTop << " " << GraphRight << "," << GraphBottom << " " << GraphLeft << "," << GraphBottom << "\" /></clipPath>" << std::endl;
-				SVGFile << "\t<style>" << std::endl;
-				SVGFile << "\t\ttext { font-family: sans-serif; font-size: " << FontSize << "px; fill: dimgrey; }" << std::endl;
-				SVGFile << "\t\tline { stroke: dimgrey; }" << std::endl;
-				SVGFile << "\t\tpolygon { fill-opacity: 0.5; }" << std::endl;
-#ifdef _DARK_STYLE_
-				SVGFile << "\t@media only screen and (prefers-color-scheme: dark) {" << std::endl;
-				SVGFile << "\t\ttext { fill: grey; }" << std::endl;
-				SVGFile << "\t\tline { stroke: grey; }" << std::endl;
-				SVGFile << "\t}" << std::endl;
-#endif // _DARK_STYLE_
-				SVGFile << "\t</style>" << std::endl;
-#ifdef DEBUG
-				SVGFile << "<!-- HumiMax: " << HumiMax << " -->" << std::endl;
-				SVGFile << "<!-- HumiMin: " << HumiMin << " -->" << std::endl;
-				SVGFile << "<!-- HumiVerticalFactor: " << HumiVerticalFactor << " -->" << std::endl;
-#endif // DEBUG
-				SVGFile << "\t<rect style=\"fill-opacity:0;stroke:grey;stroke-width:2\" width=\"" << SVGWidth << "\" height=\"" << SVGHeight << "\" />" << std::endl;
-
-				// Legend Text
-				int LegendIndex = 1;
-				SVGFile << "\t<text x=\"" << GraphLeft << "\" y=\"" << GraphTop - 2 << "\">" << Title << " Temperature &amp; Humidity</text>" << std::endl;
-				SVGFile << "\t<text style=\"text-anchor:end\" x=\"" << GraphRight << "\" y=\"" << GraphTop - 2 << "\">" << timeToExcelLocal(TheValues[0].Time) << "</text>" << std::endl;
-				SVGFile << "\t<text style=\"fill:blue;text-anchor:middle\" x=\"" << FontSize * LegendIndex << "\" y=\"50%\" transform=\"rotate(270 " << FontSize * LegendIndex << "," << (GraphTop + GraphBottom) / 2 << ")\">" << YLegendTemperature << "</text>" << std::endl;
-				if (DrawHumidity)
-				{
-					LegendIndex++;
-					SVGFile << "\t<text style=\"fill:green;text-anchor:middle\" x=\"" << FontSize * LegendIndex << "\" y=\"50%\" transform=\"rotate(270 " << FontSize * LegendIndex << "," << (GraphTop + GraphBottom) / 2 << ")\">" << YLegendHumidity << "</text>" << std::endl;
-				}
-				if (DrawBattery)
-				{
-					LegendIndex++;
-					SVGFile << "\t<text style=\"fill:OrangeRed\" text-anchor=\"middle\" x=\"" << FontSize * LegendIndex << "\" y=\"50%\" transform=\"rotate(270 " << FontSize * LegendIndex << "," << (GraphTop + GraphBottom) / 2 << ")\">" << YLegendBattery << "</text>" << std::endl;
-				}
-				if (DrawHumidity)
+	std::map<std::string, HTTPDevice> Devices;
+	{
+		std::lock_guard<std::mutex> lock(HTTPDevicesMutex);
+		Devices = HTTPDevices;	// only shared pointers and the small rapid wind summaries are copied
+	}
+	const std::vector<SVGGraph>& Graphs(GetSVGGraphs());
+	if ((Target == "/") || (Target == "/index.html"))
+	{
+		std::string Body("<!DOCTYPE html>\n<html>\n<head><title>Tempest</title><meta http-equiv=\"refresh\" content=\"300\"></head>\n<body>\n");
+		for (auto const& [Serial, Device] : Devices)
+		{
+			Body.append("<h1>" + Serial + "</h1>\n");
+			for (auto const& Graph : Graphs)
+				if (Graph.ContentType == "image/svg+xml")
+					Body.append("<img src=\"weatherflow-" + Serial + "-" + Graph.Name + "\" alt=\"" + Graph.Name + "\">\n");
+			Body.append("<p>");
+			for (auto const& Graph : Graphs)
+				if (Graph.ContentType != "image/svg+xml")
+					Body.append(" <a href=\"weatherflow-" + Serial + "-" + Graph.Name + "\">" + Graph.Name + "</a>");
+			Body.append("</p>\n");
+		}
+		Body.append("</body>\n</html>\n");
+		return(HTTPStatus(200, "OK", Close, "Content-Type: text/html; charset=utf-8\r\nCache-Control: no-cache\r\n", Body, SendBody));
+	}
+	// weatherflow-<serial>-<graph>.svg, or weatherflow-<graph>.svg for the device with the lowest serial number like the SVG file links, and the same for the data files
+	std::string_view Name(Target);
+	if (Name.substr(0, std::string_view("/weatherflow-").size()) == "/weatherflow-")
+	{
+		Name.remove_prefix(std::string_view("/weatherflow-").size());
+		auto Device = Devices.end();
+		for (auto TheDevice = Devices.begin(); (TheDevice != Devices.end()) && (Device == Devices.end()); TheDevice++)
+			if ((Name.size() > TheDevice->first.size()) && (Name.substr(0, TheDevice->first.size()) == TheDevice->first) && (Name[TheDevice->first.size()] == '-'))
+			{
+				Device = TheDevice;
+				Name.remove_prefix(TheDevice->first.size() + 1);
+			}
+		if ((Device == Devices.end()) && !Devices.empty())
+			Device = Devices.begin();
+		auto Graph = std::find_if(Graphs.begin(), Graphs.end(), [Name](const SVGGraph& TheGraph) { return(TheGraph.Name == Name); });
+		if ((Device != Devices.end()) && (Graph != Graphs.end()))
+		{
+			const uint64_t Generation(Graph->RapidWind ? Device->second.RapidWind.Generation : Device->second.MRTG.Generation[int(Graph->Type)]);
+			const std::string Key(Device->first + "-" + Graph->Name);
+			if ((Rendered.count(Key) == 0) || (Rendered[Key].Generation != Generation))
+			{
+				const auto RenderStart = std::chrono::steady_clock::now();
+				SVGBuffer SVGFile;
+				HTTPRendered& TheGraph(Rendered[Key]);
+				TheGraph.Generation = Generation;
+				TheGraph.NewestTime = Graph->Render(SVGFile, Device->second.MRTG, Device->second.RapidWind, TimeAxis[Device->first], "Tempest " + Device->first, 0);
+				TheGraph.Body.assign(SVGFile.view());
+				std::ostringstream ETag;
+				ETag << "\"" << std::hex << HashFNV1a(TheGraph.Body) << "\"";
+				TheGraph.ETag = ETag.str();
+				const std::chrono::duration<double, std::milli> RenderTime(std::chrono::steady_clock::now() - RenderStart);
+				if (ConsoleVerbosity > 0)
+					std::cout << "[" << getTimeISO8601() << "] Rendered: " << Target.substr(1) << " in " << std::fixed << std::setprecision(1) << RenderTime.count() << " ms" << std::endl;
+			}
+			const HTTPRendered& TheGraph(Rendered[Key]);
+			if (TheGraph.NewestTime > 0)
+			{
+				const std::string Headers("ETag: " + TheGraph.ETag + "\r\nLast-Modified: " + getTimeHTTP(TheGraph.NewestTime) + "\r\nCache-Control: no-cache\r\n");
+				if (MatchETag(GetHTTPHeader(Request, "If-None-Match"), TheGraph.ETag))
+					return(HTTPStatus(304, "Not Modified", Close, Headers));
+				return(HTTPStatus(200, "OK", Close, "Content-Type: " + Graph->ContentType + "\r\n" + Headers, TheGraph.Body, SendBody));
+			}
+		}
+	}
+	return(HTTPStatus(404, "Not Found", Close, "Content-Type: text/plain\r\n", "Not Found\n", SendBody));
+}
+// One client of the web server. Requests may be pipelined, so whatever follows a complete request stays in Request.
+class HTTPConnection {
+public:
+	std::string Request;	// received and not yet answered
+	std::string Response;	// not yet sent
+	bool Close = false;	// close once Response has been sent
+	time_t LastActive = 0;
+};
+const size_t HTTP_REQUEST_MAX(16 * 1024);	// longer request headers than this get a 431, nothing here needs more than a few hundred bytes
+const size_t HTTP_CONNECTION_MAX(256);	// connections beyond this are closed as soon as they are accepted
+const time_t HTTP_IDLE_TIMEOUT(60);	// keep alive connections with nothing happening for this long are closed
+std::atomic<bool> HTTPServerRun(true);
+int OpenHTTPSocket(const int Port)
+{
+	int rval = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, IPPROTO_TCP);
+	if (rval != -1)
+	{
+		int reuse = 1;
+		setsockopt(rval, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof reuse);
+		struct sockaddr_in si_me;
+		memset(&si_me, 0, sizeof(si_me));
+		si_me.sin_family = AF_INET;
+		si_me.sin_port = htons(Port);
+		si_me.sin_addr.s_addr = INADDR_ANY;
+		if ((-1 == ::bind(rval, (sockaddr*)&si_me, sizeof(sockaddr))) || (-1 == listen(rval, SOMAXCONN)))
+		{
+			std::cerr << std::strerror(errno) << ": HTTP port " << Port << std::endl;
+			close(rval);
+			rval = -1;
+		}
+	}
+	return(rval);
+}
+void HTTPServer(const int ListenSocket)
+{
+	const int EPoll = epoll_create1(EPOLL_CLOEXEC);
+	struct epoll_event ListenEvent = { 0 };
+	ListenEvent.events = EPOLLIN;
+	ListenEvent.data.fd = ListenSocket;
+	epoll_ctl(EPoll, EPOLL_CTL_ADD, ListenSocket, &ListenEvent);
+	std::unordered_map<int, HTTPConnection> Connections;
+	std::map<std::string, HTTPRendered> Rendered;	// only used on this thread
+	std::map<std::string, TimeAxisLayouts> TimeAxis;	// of each device, kept apart from the SVG file renders so neither waits on the other
+	auto CloseConnection = [&](const int Client)
+	{
+		epoll_ctl(EPoll, EPOLL_CTL_DEL, Client, nullptr);
+		close(Client);
+		Connections.erase(Client);
+	};
+	// Sends as much of the response as the socket takes, then waits for EPOLLOUT if there's more
+	auto SendResponse = [&](const int Client, HTTPConnection& Connection)
+	{
+		while (!Connection.Response.empty())
+		{
+			const ssize_t Sent = send(Client, Connection.Response.data(), Connection.Response.size(), MSG_NOSIGNAL);
+			if (Sent <= 0)
+				break;
+			Connection.Response.erase(0, Sent);
+		}
+		struct epoll_event ClientEvent = { 0 };
+		ClientEvent.events = Connection.Response.empty() ? EPOLLIN : EPOLLOUT;
+		ClientEvent.data.fd = Client;
+		epoll_ctl(EPoll, EPOLL_CTL_MOD, Client, &ClientEvent);
+		return(Connection.Response.empty() && Connection.Close);	// true when the connection is finished with
+	};
+	std::array<struct epoll_event, 64> Events;
+	while (HTTPServerRun)
+	{
+		const int EventCount = epoll_wait(EPoll, Events.data(), Events.size(), 1000);	// wakes each second to check HTTPServerRun
+		const time_t TimeNow = time(nullptr);
+		for (auto index = 0; index < EventCount; index++)
+		{
+			const int Client = Events[index].data.fd;
+			if (Client == ListenSocket)
+			{
+				for (int Accepted = accept4(ListenSocket, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC); Accepted != -1; Accepted = accept4(ListenSocket, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC))
 				{
-					if (MinMax)
-					{
-						SVGFile << "\t<!-- Humidity Max -->" << std::endl;
-						SVGFile << "\t<polygon style=\"fill:lime;stroke:green;clip-path:url(#GraphRegion)\" points=\"";
-						SVGFile << GraphLeft + 1 << "," << GraphBottom - 1 << " ";
-						for (auto index = 0; index < (GraphWidth < TheValues.size() ? GraphWidth : TheValues.size()); index++)
-							SVGFile << index + GraphLeft << "," << int(((HumiMax - TheValues[index].GetHumidityMax()) * HumiVerticalFactor) + GraphTop) << " ";
-						if (GraphWidth < TheValues.size())
-							SVGFile << GraphRight - 1 << "," << GraphBottom - 1;
-						else
-							SVGFile << GraphRight - (GraphWidth - TheValues.size()) << "," << GraphBottom - 1;
-						SVGFile << "\" />" << std::endl;
-						SVGFile << "\t<!-- Humidity Min -->" << std::endl;
-						SVGFile << "\t<polygon style=\"fill:lime;stroke:green;clip-path:url(#GraphRegion)\" points=\"";
-						SVGFile << GraphLeft + 1 << "," << GraphBottom - 1 << " ";
-						for (auto index = 0; index < (GraphWidth < TheValues.size() ? GraphWidth : TheValues.size()); index++)
-							SVGFile << index + GraphLeft << "," << int(((HumiMax - TheValues[index].GetHumidityMin()) * HumiVerticalFactor) + GraphTop) << " ";
-						if (GraphWidth < TheValues.size())
-							SVGFile << GraphRight - 1 << "," << GraphBottom - 1;
-						else
-							SVGFile << GraphRight - (GraphWidth - TheValues.size()) << "," << GraphBottom - 1;
-						SVGFile << "\" />" << std::endl;
-					}
+					if (Connections.size() >= HTTP_CONNECTION_MAX)
+						close(Accepted);
 					else
 					{
-						// Humidity Graphic as a Filled polygon
-						SVGFile << "\t<!-- Humidity -->" << std::endl;
-						SVGFile << "\t<polygon style=\"fill:lime;stroke:green;clip-path:url(#GraphRegion)\" points=\"";
-						SVGFile << GraphLeft + 1 << "," << GraphBottom - 1 << " ";
-						for (auto index = 0; index < (GraphWidth < TheValues.size() ? GraphWidth : TheValues.size()); index++)
-							SVGFile << index + GraphLeft << "," << int(((HumiMax - TheValues[index].GetHumidity()) * HumiVerticalFactor) + GraphTop) << " ";
-						if (GraphWidth < TheValues.size())
-							SVGFile << GraphRight - 1 << "," << GraphBottom - 1;
-						else
-							SVGFile << GraphRight - (GraphWidth - TheValues.size()) << "," << GraphBottom - 1;
-						SVGFile << "\" />" << std::endl;
+						struct epoll_event ClientEvent = { 0 };
+						ClientEvent.events = EPOLLIN;
+						ClientEvent.data.fd = Accepted;
+						epoll_ctl(EPoll, EPOLL_CTL_ADD, Accepted, &ClientEvent);
+						Connections[Accepted].LastActive = TimeNow;
 					}
 				}
-
-				// Top Line
-				SVGFile << "\t<line x1=\"" << GraphLeft - TickSize << "\" y1=\"" << GraphTop << "\" x2=\"" << GraphRight + TickSize << "\" y2=\"" << GraphTop << "\"/>" << std::endl;
-				SVGFile << "\t<text style=\"fill:blue;text-anchor:end;dominant-baseline:middle\" x=\"" << GraphLeft - TickSize << "\" y=\"" << GraphTop << "\">" << std::fixed << std::setprecision(1) << TempMax << "</text>" << std::endl;
-				if (DrawHumidity)
-					SVGFile << "\t<text style=\"fill:green;dominant-baseline:middle\" x=\"" << GraphRight + TickSize << "\" y=\"" << GraphTop << "\">" << std::fixed << std::setprecision(1) << HumiMax << "</text>" << std::endl;
-
-				// Bottom Line
-				SVGFile << "\t<line x1=\"" << GraphLeft - TickSize << "\" y1=\"" << GraphBottom << "\" x2=\"" << GraphRight + TickSize << "\" y2=\"" << GraphBottom << "\"/>" << std::endl;
-				SVGFile << "\t<text style=\"fill:blue;text-anchor:end;dominant-baseline:middle\" x=\"" << GraphLeft - TickSize << "\" y=\"" << GraphBottom << "\">" << std::fixed << std::setprecision(1) << TempMin << "</text>" << std::endl;
-				if (DrawHumidity)
-					SVGFile << "\t<text style=\"fill:green;dominant-baseline:middle\" x=\"" << GraphRight + TickSize << "\" y=\"" << GraphBottom << "\">" << std::fixed << std::setprecision(1) << HumiMin << "</text>" << std::endl;
-
-				// Left Line
-				SVGFile << "\t<line x1=\"" << GraphLeft << "\" y1=\"" << GraphTop << "\" x2=\"" << GraphLeft << "\" y2=\"" << GraphBottom << "\"/>" << std::endl;
-
-				// Right Line
-				SVGFile << "\t<line x1=\"" << GraphRight << "\" y1=\"" << GraphTop << "\" x2=\"" << GraphRight << "\" y2=\"" << GraphBottom << "\"/>" << std::endl;
-
-				// Vertical Division Dashed Lines
-				for (auto index = 1; index < 4; index++)
-				{
-					SVGFile << "\t<line style=\"stroke-dasharray:1\" x1=\"" << GraphLeft - TickSize << "\" y1=\"" << GraphTop + (GraphVerticalDivision * index) << "\" x2=\"" << GraphRight + TickSize << "\" y2=\"" << GraphTop + (GraphVerticalDivision * index) << "\" />" << std::endl;
-					SVGFile << "\t<text style=\"fill:blue;text-anchor:end;dominant-baseline:middle\" x=\"" << GraphLeft - TickSize << "\" y=\"" << GraphTop + (GraphVerticalDivision * index) << "\">" << std::fixed << std::setprecision(1) << TempMax - (TempVerticalDivision * index) << "</text>" << std::endl;
-					if (DrawHumidity)
-						SVGFile << "\t<text style=\"fill:green;dominant-baseline:middle\" x=\"" << GraphRight + TickSize << "\" y=\"" << GraphTop + (GraphVerticalDivision * index) << "\">" << std::fixed << std::setprecision(1) << HumiMax - (HumiVerticalDivision * index) << "</text>" << std::endl;
-				}
-
-				// Horizontal Line drawn at the freezing point
-				if ((GraphTop < FreezingLine) && (FreezingLine < GraphBottom))
+			}
+			else if (Connections.count(Client) > 0)
+			{
+				HTTPConnection& Connection(Connections[Client]);
+				Connection.LastActive = TimeNow;
+				bool Finished = (Events[index].events & (EPOLLERR | EPOLLHUP)) != 0;
+				if (!Finished && (Events[index].events & EPOLLOUT))
+					Finished = SendResponse(Client, Connection);
+				else if (!Finished && (Events[index].events & EPOLLIN))
 				{
-					SVGFile << "\t<!-- FreezingLine = " << FreezingLine << " -->" << std::endl;
-					SVGFile << "\t<line style=\"fill:red;stroke:red;stroke-dasharray:1\" x1=\"" << GraphLeft - TickSize << "\" y1=\"" << FreezingLine << "\" x2=\"" << GraphRight + TickSize << "\" y2=\"" << FreezingLine << "\" />" << std::endl;
+					char buffer[4096];
+					const ssize_t Received = recv(Client, buffer, sizeof(buffer), 0);
+					if (Received <= 0)
+						Finished = (Received == 0) || ((errno != EAGAIN) && (errno != EWOULDBLOCK));
+					else
+					{
+						Connection.Request.append(buffer, Received);
+						for (size_t HeaderEnd = Connection.Request.find("\r\n\r\n"); (HeaderEnd != std::string::npos) && !Connection.Close; HeaderEnd = Connection.Request.find("\r\n\r\n"))
+						{
+							Connection.Response.append(HTTPResponse(std::string_view(Connection.Request).substr(0, HeaderEnd + 2), Rendered, TimeAxis, Connection.Close));
+							Connection.Request.erase(0, HeaderEnd + 4);	// requests for graphs have no body
+						}
+						if (Connection.Request.size() > HTTP_REQUEST_MAX)
+						{
+							Connection.Close = true;
+							Connection.Response.append(HTTPStatus(431, "Request Header Fields Too Large", Connection.Close));
+							Connection.Request.clear();
+						}
+						Finished = SendResponse(Client, Connection);
+					}
 				}
-
-				// Horizontal Division Dashed Lines
-				for (auto index = 0; index < (GraphWidth < TheValues.size() ? GraphWidth : TheValues.size()); index++)
+				if (Finished)
+					CloseConnection(Client);
+			}
+		}
+		for (auto Connection = Connections.begin(); Connection != Connections.end();)
+		{
+			const int Client = (Connection++)->first;	// advanced first, closing the connection removes it
+			if (TimeNow - Connections[Client].LastActive > HTTP_IDLE_TIMEOUT)
+				CloseConnection(Client);
+		}
+	}
+	for (auto Connection = Connections.begin(); Connection != Connections.end(); Connection = Connections.begin())
+		CloseConnection(Connection->first);
+	close(EPoll);
+}
+/////////////////////////////////////////////////////////////////////////////
+// Each text log gets a sidecar index, weatherflow-YYYY-MM.idx, so a query over any time range only reads the log lines at its edges.
+// For every hour it holds the offset of the first line with an observation in that hour, and the sum of each device's observations in it.
+// Logs are only ever appended to, so when a log has grown since it was indexed, only the lines from its last indexed hour on are read.
+// If the layout of TempestObservation::WriteCache changes, LogIndexVersion must be incremented along with CacheFileVersion.
+const char LogIndexMagic[4] = { 'W', 'F', 'T', 'I' };
+const uint32_t LogIndexVersion(1);
+const time_t LOG_INDEX_HOUR(60 * 60);
+class LogIndexHour {
+public:
+	uint64_t Offset = 0;	// of the first line with an observation in this hour
+	std::map<std::string, TempestObservation> Devices;	// every observation of each device in the hour, added together
+};
+class LogIndex {
+public:
+	uint64_t Size = 0;	// of the log file when it was indexed, up to its last complete line
+	std::map<time_t, LogIndexHour> Hours;	// by the start of each hour with observations
+	bool Read(const std::filesystem::path& IndexFileName);
+	bool Write(const std::filesystem::path& IndexFileName) const;
+	bool Update(std::string_view Contents);
+	std::pair<size_t, size_t> GetHourLines(const time_t Hour, const size_t ContentsSize) const;
+};
+bool LogIndex::Read(const std::filesystem::path& IndexFileName)
+{
+	bool rval = false;
+	std::ifstream IndexFile(IndexFileName, std::ios_base::in | std::ios_base::binary);
+	if (IndexFile.is_open())
+	{
+		char Magic[sizeof(LogIndexMagic)] = { 0 };
+		uint32_t Version(0);
+		uint64_t HourCount(0);
+		IndexFile.read(Magic, sizeof(Magic));
+		ReadBinary(IndexFile, Version);
+		ReadBinary(IndexFile, Size);
+		ReadBinary(IndexFile, HourCount);
+		rval = IndexFile.good() && (0 == std::memcmp(Magic, LogIndexMagic, sizeof(Magic))) && (Version == LogIndexVersion);
+		for (uint64_t index = 0; rval && (index < HourCount); index++)
+		{
+			int64_t Hour(0);
+			uint32_t DeviceCount(0);
+			ReadBinary(IndexFile, Hour);
+			LogIndexHour& TheHour(Hours[Hour]);
+			ReadBinary(IndexFile, TheHour.Offset);
+			ReadBinary(IndexFile, DeviceCount);
+			for (uint32_t Device = 0; rval && (Device < DeviceCount); Device++)
+			{
+				uint8_t SerialLength(0);
+				ReadBinary(IndexFile, SerialLength);
+				std::string Serial(SerialLength, '\0');
+				IndexFile.read(Serial.data(), SerialLength);
+				rval = IndexFile.good() && IsValidSerial(Serial) && TheHour.Devices[Serial].ReadCache(IndexFile);
+			}
+			rval = rval && IndexFile.good();
+		}
+		rval = rval && (IndexFile.peek() == std::char_traits<char>::eof());
+		if (!rval)
+		{
+			std::cerr << IndexFileName << " is truncated, corrupt or from an incompatible version, indexing the log again." << std::endl;
+			Size = 0;
+			Hours.clear();
+		}
+	}
+	return(rval);
+}
+bool LogIndex::Write(const std::filesystem::path& IndexFileName) const
+{
+	bool rval = false;
+	std::filesystem::path TempFileName(IndexFileName);
+	TempFileName += ".tmp";
+	std::ofstream IndexFile(TempFileName, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+	if (IndexFile.is_open())
+	{
+		IndexFile.write(LogIndexMagic, sizeof(LogIndexMagic));
+		WriteBinary(IndexFile, LogIndexVersion);
+		WriteBinary(IndexFile, Size);
+		WriteBinary(IndexFile, uint64_t(Hours.size()));
+		for (auto const& [Hour, TheHour] : Hours)
+		{
+			WriteBinary(IndexFile, int64_t(Hour));
+			WriteBinary(IndexFile, TheHour.Offset);
+			WriteBinary(IndexFile, uint32_t(TheHour.Devices.size()));
+			for (auto const& [Serial, TheValue] : TheHour.Devices)
+			{
+				WriteBinary(IndexFile, uint8_t(Serial.size()));
+				IndexFile.write(Serial.data(), Serial.size());
+				TheValue.WriteCache(IndexFile);
+			}
+		}
+		IndexFile.close();
+		// Written to a temporary file and renamed, the same as the cache, so a query never finds a partial index
+		if (!IndexFile.fail())
+		{
+			std::error_code ec;
+			std::filesystem::rename(TempFileName, IndexFileName, ec);
+			if (ec)
+				std::cerr << IndexFileName << " " << ec.message() << std::endl;
+			else
+				rval = true;
+		}
+	}
+	if (!rval)
+		std::cerr << "Unable to write: " << IndexFileName << ", the index is only used for this query" << std::endl;
+	return(rval);
+}
+// Brings the index up to date with the contents of its log file, and returns true if anything changed.
+// A log that's smaller than what was indexed isn't the same file, and is indexed from the start.
+bool LogIndex::Update(std::string_view Contents)
+{
+	bool rval = false;
+	Contents = Contents.substr(0, Contents.rfind('\n') + 1);	// a line still being written is left for next time
+	if (Contents.size() < Size)
+	{
+		Size = 0;
+		Hours.clear();
+		rval = true;
+	}
+	if (Contents.size() > Size)
+	{
+		// The last indexed hour may not have been complete, so it's added up again from its first line.
+		// Lines before the end of what was indexed that belong to earlier hours were already counted.
+		time_t Rescan = 0;
+		size_t LineStart = 0;
+		if (!Hours.empty())
+		{
+			Rescan = Hours.rbegin()->first;
+			LineStart = Hours.rbegin()->second.Offset;
+			Hours.erase(Rescan);
+		}
+		while (LineStart < Contents.size())
+		{
+			const std::string_view TheLine(GetLine(Contents, LineStart));
+			const time_t ObservationTime = GetObservationTime(TheLine);
+			if (ObservationTime > 0)
+			{
+				const time_t Hour = ObservationTime - ObservationTime % LOG_INDEX_HOUR;
+				if ((LineStart >= Size) || (Hour >= Rescan))
 				{
-					struct tm UTC;
-					if (0 != localtime_r(&TheValues[index].Time, &UTC))
+					const std::string Serial(GetJSONString(TheLine, "serial_number"));
+					TempestObservation TheValue(TheLine);
+					if (IsValidSerial(Serial) && TheValue.IsValid())
 					{
-						if (graph == GraphType::daily)
-						{
-							if (UTC.tm_min == 0)
-							{
-								if (UTC.tm_hour == 0)
-									SVGFile << "\t<line style=\"stroke:red\" x1=\"" << GraphLeft + index << "\" y1=\"" << GraphTop << "\" x2=\"" << GraphLeft + index << "\" y2=\"" << GraphBottom + TickSize << "\" />" << std::endl;
-								else
-									SVGFile << "\t<line style=\"stroke-dasharray:1\" x1=\"" << GraphLeft + index << "\" y1=\"" << GraphTop << "\" x2=\"" << GraphLeft + index << "\" y2=\"" << GraphBottom + TickSize << "\" />" << std::endl;
-								if (UTC.tm_hour % 2 == 0)
-									SVGFile << "\t<text style=\"text-anchor:middle\" x=\"" << GraphLeft + index << "\" y=\"" << SVGHeight - 2 << "\">" << UTC.tm_hour << "</text>" << std::endl;
-							}
-						}
-						else if (graph == GraphType::weekly)
-						{
-							const std::string Weekday[] = { "Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat" };
-							if ((UTC.tm_hour == 0) && (UTC.tm_min == 0))
-							{
-								if (UTC.tm_wday == 0)
-									SVGFile << "\t<line style=\"stroke:red\" x1=\"" << GraphLeft + index << "\" y1=\"" << GraphTop << "\" x2=\"" << GraphLeft + index << "\" y2=\"" << GraphBottom + TickSize << "\" />" << std::endl;
-								else
-									SVGFile << "\t<line style=\"stroke-dasharray:1\" x1=\"" << GraphLeft + index << "\" y1=\"" << GraphTop << "\" x2=\"" << GraphLeft + index << "\" y2=\"" << GraphBottom + TickSize << "\" />" << std::endl;
-							}
-							else if ((UTC.tm_hour == 12) && (UTC.tm_min == 0))
-								SVGFile << "\t<text style=\"text-anchor:middle\" x=\"" << GraphLeft + index << "\" y=\"" << SVGHeight - 2 << "\">" << Weekday[UTC.tm_wday] << "</text>" << std::endl;
-						}
-						else if (graph == GraphType::monthly)
-						{
-							if ((UTC.tm_mday == 1) && (UTC.tm_hour == 0) && (UTC.tm_min == 0))
-								SVGFile << "\t<line style=\"stroke:red\" x1=\"" << GraphLeft + index << "\" y1=\"" << GraphTop << "\" x2=\"" << GraphLeft + index << "\" y2=\"" << GraphBottom + TickSize << "\" />" << std::endl;
-							if ((UTC.tm_wday == 0) && (UTC.tm_hour == 0) && (UTC.tm_min == 0))
-								SVGFile << "\t<line style=\"stroke-dasharray:1\" x1=\"" << GraphLeft + index << "\" y1=\"" << GraphTop << "\" x2=\"" << GraphLeft + index << "\" y2=\"" << GraphBottom + TickSize << "\" />" << std::endl;
-							else if ((UTC.tm_wday == 3) && (UTC.tm_hour == 12) && (UTC.tm_min == 0))
-								SVGFile << "\t<text style=\"text-anchor:middle\" x=\"" << GraphLeft + index << "\" y=\"" << SVGHeight - 2 << "\">Week " << UTC.tm_yday / 7 + 1 << "</text>" << std::endl;
-						}
-						else if (graph == GraphType::yearly)
+						auto TheHour = Hours.find(Hour);
+						if (TheHour == Hours.end())
 						{
-							const std::string Month[] = { "Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec" };
-							if ((UTC.tm_yday == 0) && (UTC.tm_mday == 1) && (UTC.tm_hour == 0) && (UTC.tm_min == 0))
-								SVGFile << "\t<line style=\"stroke:red\" x1=\"" << GraphLeft + index << "\" y1=\"" << GraphTop << "\" x2=\"" << GraphLeft + index << "\" y2=\"" << GraphBottom + TickSize << "\" />" << std::endl;
-							else if ((UTC.tm_mday == 1) && (UTC.tm_hour == 0) && (UTC.tm_min == 0))
-								SVGFile << "\t<line style=\"stroke-dasharray:1\" x1=\"" << GraphLeft + index << "\" y1=\"" << GraphTop << "\" x2=\"" << GraphLeft + index << "\" y2=\"" << GraphBottom + TickSize << "\" />" << std::endl;
-							else if ((UTC.tm_mday == 15) && (UTC.tm_hour == 0) && (UTC.tm_min == 0))
-								SVGFile << "\t<text style=\"text-anchor:middle\" x=\"" << GraphLeft + index << "\" y=\"" << SVGHeight - 2 << "\">" << Month[UTC.tm_mon] << "</text>" << std::endl;
+							TheHour = Hours.insert(std::make_pair(Hour, LogIndexHour())).first;
+							TheHour->second.Offset = LineStart;
 						}
+						TheHour->second.Devices[Serial] += TheValue;
 					}
 				}
-
-				// Directional Arrow
-				SVGFile << "\t<polygon style=\"fill:red;stroke:red;fill-opacity:1;\" points=\"" << GraphLeft - 3 << "," << GraphBottom << " " << GraphLeft + 3 << "," << GraphBottom - 3 << " " << GraphLeft + 3 << "," << GraphBottom + 3 << "\" />" << std::endl;
-
-				if (MinMax)
-				{
-					// Temperature Values as a filled polygon showing the minimum and maximum
-					SVGFile << "\t<!-- Temperature MinMax -->" << std::endl;
-					SVGFile << "\t<polygon style=\"fill:blue;stroke:blue;clip-path:url(#GraphRegion)\" points=\"";
-					for (auto index = 1; index < (GraphWidth < TheValues.size() ? GraphWidth : TheValues.size()); index++)
-						SVGFile << index + GraphLeft << "," << int(((TempMax - TheValues[index].GetTemperatureMax(Fahrenheit)) * TempVerticalFactor) + GraphTop) << " ";
-					for (auto index = (GraphWidth < TheValues.size() ? GraphWidth : TheValues.size()) - 1; index > 0; index--)
-						SVGFile << index + GraphLeft << "," << int(((TempMax - TheValues[index].GetTemperatureMin(Fahrenheit)) * TempVerticalFactor) + GraphTop) << " ";
-					SVGFile << "\" />" << std::endl;
-				}
-				else
-				{
-					// Temperature Values as a continuous line
-					SVGFile << "\t<!-- Temperature -->" << std::endl;
-					SVGFile << "\t<polyline style=\"fill:none;stroke:blue;clip-path:url(#GraphRegion)\" points=\"";
-					for (auto index = 1; index < (GraphWidth < TheValues.size() ? GraphWidth : TheValues.size()); index++)
-						SVGFile << index + GraphLeft << "," << int(((TempMax - TheValues[index].GetTemperature(Fahrenheit)) * TempVerticalFactor) + GraphTop) << " ";
-					SVGFile << "\" />" << std::endl;
-				}
-
-				// Battery Values as a continuous line
-				if (DrawBattery)
-				{
-					SVGFile << "\t<!-- Battery -->" << std::endl;
-					double BatteryVerticalFactor = (GraphBottom - GraphTop) / 100.0;
-					SVGFile << "\t<polyline style=\"fill:none;stroke:OrangeRed;clip-path:url(#GraphRegion)\" points=\"";
-					for (auto index = 1; index < (GraphWidth < TheValues.size() ? GraphWidth : TheValues.size()); index++)
-						SVGFile << index + GraphLeft << "," << int(((100 - TheValues[index].GetBattery()) * BatteryVerticalFactor) + GraphTop) << " ";
-					SVGFile << "\" />" << std::endl;
-				}
-
-				SVGFile << "</svg>" << std::endl;
-				SVGFile.close();
-				struct utimbuf SVGut;
-				SVGut.actime = TheValues.begin()->Time;
-				SVGut.modtime = TheValues.begin()->Time;
-				utime(SVGFileName.c_str(), &SVGut);
 			}
+			LineStart += TheLine.size() + 1;
 		}
+		Size = Contents.size();
+		rval = true;
 	}
+	return(rval);
 }
-/////////////////////////////////////////////////////////////////////////////
-void WriteWindSVG(std::vector<TempestObservation>& TheValues, const std::filesystem::path& SVGFileName, const std::string& Title = "", const GraphType graph = GraphType::daily, const bool MinMax = false, const double MinPressureDifferential = 4.0)
+// The byte range of the log lines of an hour. It runs from the first line of the hour to the first line of the hour after next,
+// which leaves room for observations that were logged a little late.
+std::pair<size_t, size_t> LogIndex::GetHourLines(const time_t Hour, const size_t ContentsSize) const
 {
-	// this overloaded function should allow both wind and pressue on same graph, with wind as left (primary) and pressure as right (secondary) scales.
-	// By declaring these items here, I'm then basing all my other dimensions on these
-	const int SVGWidth(500);
-	const int SVGHeight(135);
-	const int FontSize(12);
-	const int TickSize(2);
-	int GraphWidth = SVGWidth - (FontSize * 6);
-	if (!TheValues.empty())
+	std::pair<size_t, size_t> rval(0, 0);
+	auto TheHour = Hours.find(Hour);
+	if (TheHour != Hours.end())
 	{
-		struct stat64 SVGStat({ 0 });	// Zero the stat64 structure on allocation
-		if (-1 == stat64(SVGFileName.c_str(), &SVGStat))
-			if (ConsoleVerbosity > 0)
-				std::cout << "[" << getTimeISO8601(true) << "] " << std::strerror(errno) << ": " << SVGFileName << std::endl;
-		if (TheValues.begin()->Time > SVGStat.st_mtim.tv_sec)	// only write the file if we have new data
+		rval = std::make_pair(TheHour->second.Offset, ContentsSize);
+		for (auto Later = Hours.lower_bound(Hour + 2 * LOG_INDEX_HOUR); Later != Hours.end(); Later++)
+			if (Later->second.Offset > rval.first)
+			{
+				rval.second = Later->second.Offset;
+				break;
+			}
+	}
+	return(rval);
+}
+/////////////////////////////////////////////////////////////////////////////
+// --query start,end,resolution[,serial]. Start and end are seconds since the epoch or local times like 2024-03-01, 2024-03-01T06:00 or 2024-03-01T06:00:00,
+// and the resolution is seconds, or a number followed by m, h or d. Without a serial number, the device with the lowest one that has data is used.
+std::string LogQueryArgument;
+const size_t LOG_QUERY_MAX_BUCKETS(200000);	// about 40MB of observations, a little under two years at five minutes
+class LogQuery {
+public:
+	time_t Start = 0;
+	time_t End = 0;
+	time_t Resolution = 0;
+	std::string Serial;
+	bool Parse(const std::string& Argument);
+	size_t GetBucketCount(void) const { return((End - Start) / Resolution + ((End - Start) % Resolution == 0 ? 0 : 1)); };
+	static time_t ParseTime(const std::string& Text);
+	static time_t ParseResolution(const std::string& Text);
+};
+time_t LogQuery::ParseTime(const std::string& Text)
+{
+	time_t rval = 0;
+	if (!Text.empty() && std::all_of(Text.begin(), Text.end(), [](const unsigned char c) { return(std::isdigit(c)); }))
+		std::from_chars(Text.data(), Text.data() + Text.size(), rval);
+	else
+		for (auto Format : { "%Y-%m-%dT%H:%M:%S", "%Y-%m-%dT%H:%M", "%Y-%m-%d %H:%M:%S", "%Y-%m-%d %H:%M", "%Y-%m-%d", "%Y-%m" })
 		{
-			std::ofstream SVGFile(SVGFileName);
-			if (SVGFile.is_open())
+			struct tm Local = { 0 };
+			Local.tm_mday = 1;
+			const char* Parsed = strptime(Text.c_str(), Format, &Local);
+			if ((Parsed != nullptr) && (*Parsed == '\0'))
 			{
-				if (ConsoleVerbosity > 0)
-					std::cout << "[" << getTimeISO8601(true) << "] Writing: " << SVGFileName.string() << " With Title: " << Title << std::endl;
-				else
-					std::cerr << "Writing: " << SVGFileName.string() << " With Title: " << Title << std::endl;
-				std::ostringstream tempOString;
-				tempOString << "Wind Speed (" << std::fixed << std::setprecision(1) << TheValues[0].GetWindSpeed() << " kn)";
-				const std::string YLegendWindSpeed(tempOString.str());
-				tempOString.str("");
-				tempOString << "Wind Gust (" << std::fixed << std::setprecision(1) << TheValues[0].GetWindSpeedMax() << " kn)";
-				const std::string YLegendWindGust(tempOString.str());
-				tempOString.str("");
-				tempOString << "Pressure (" << std::fixed << std::setprecision(1) << TheValues[0].GetOutsidePressure() + AltitudeAdjustment << " hPa)";
-				const std::string YLegendPressure(tempOString.str());
-				double WindMin = DBL_MAX;
-				double WindMax = -DBL_MAX;
-				double PressureMin = DBL_MAX;
-				double PressureMax = -DBL_MAX;
-				if (MinMax)
-				{
-					for (auto index = 0; index < (GraphWidth < TheValues.size() ? GraphWidth : TheValues.size()); index++)
-					{
-						WindMin = std::min(WindMin, TheValues[index].GetWindSpeedMin());
-						WindMax = std::max(WindMax, TheValues[index].GetWindSpeedMax());
-					}
-					for (auto index = 0; index < (GraphWidth < TheValues.size() ? GraphWidth : TheValues.size()); index++)
-					{
-						PressureMin = std::min(PressureMin, TheValues[index].GetOutsidePressureMin());
-						PressureMax = std::max(PressureMax, TheValues[index].GetOutsidePressureMax());
-					}
-				}
-				else
+				Local.tm_isdst = -1;
+				rval = std::max(time_t(0), mktime(&Local));
+				break;
+			}
+		}
+	return(rval);
+}
+time_t LogQuery::ParseResolution(const std::string& Text)
+{
+	time_t rval = 0;
+	auto [Parsed, ec] = std::from_chars(Text.data(), Text.data() + Text.size(), rval);
+	const std::string_view Unit(Parsed, Text.data() + Text.size() - Parsed);
+	time_t UnitSeconds = 0;
+	if (Unit.empty() || (Unit == "s"))
+		UnitSeconds = 1;
+	else if (Unit == "m")
+		UnitSeconds = 60;
+	else if (Unit == "h")
+		UnitSeconds = 60 * 60;
+	else if (Unit == "d")
+		UnitSeconds = 24 * 60 * 60;
+	// A number too large to convert to seconds is rejected like any other bad resolution, instead of overflowing
+	if ((ec != std::errc()) || (rval <= 0) || (UnitSeconds == 0) || (rval > std::numeric_limits<time_t>::max() / UnitSeconds))
+		rval = 0;
+	else
+		rval *= UnitSeconds;
+	return(rval);
+}
+bool LogQuery::Parse(const std::string& Argument)
+{
+	std::vector<std::string> Fields;
+	std::istringstream Arguments(Argument);
+	for (std::string Field; std::getline(Arguments, Field, ',');)
+		Fields.push_back(Field);
+	if ((Fields.size() == 3) || (Fields.size() == 4))
+	{
+		Start = ParseTime(Fields[0]);
+		End = ParseTime(Fields[1]);
+		Resolution = ParseResolution(Fields[2]);
+		if (Fields.size() == 4)
+			Serial = Fields[3];
+	}
+	bool rval = true;
+	if ((Start <= 0) || (End <= Start))
+	{
+		std::cerr << "Query start and end must be times with start before end: " << Argument << std::endl;
+		rval = false;
+	}
+	else if (Resolution <= 0)
+	{
+		std::cerr << "Query resolution must be a number of seconds, or minutes, hours or days like 5m, 1h or 1d: " << Argument << std::endl;
+		rval = false;
+	}
+	else if (GetBucketCount() > LOG_QUERY_MAX_BUCKETS)
+	{
+		std::cerr << "Query would return " << GetBucketCount() << " samples, more than " << LOG_QUERY_MAX_BUCKETS << ", use a coarser resolution: " << Argument << std::endl;
+		rval = false;
+	}
+	else if (!Serial.empty() && !IsValidSerial(Serial))
+	{
+		std::cerr << "Invalid serial number: " << Serial << std::endl;
+		rval = false;
+	}
+	return(rval);
+}
+// Adds up the observations of each device in each Resolution wide bucket from Start. An hour that falls entirely within one bucket
+// comes from the index of its log file, and only hours cut by the ends of the range or by a bucket boundary are read from the log itself.
+// A month without a text log is read from its archive files instead.
+std::map<std::string, std::vector<TempestObservation>> ReadLogQuery(const LogQuery& Query)
+{
+	std::map<std::string, std::vector<TempestObservation>> rval;
+	size_t IndexedHours = 0, LoggedHours = 0;
+	auto AddObservation = [&Query, &rval](const std::string& Serial, const TempestObservation& TheValue, const time_t TheTime)
+	{
+		if ((TheTime >= Query.Start) && (TheTime < Query.End))
+		{
+			std::vector<TempestObservation>& Buckets(rval[Serial]);
+			if (Buckets.empty())
+				Buckets.resize(Query.GetBucketCount());
+			Buckets[(TheTime - Query.Start) / Query.Resolution] += TheValue;
+		}
+	};
+	// Log files are named by the UTC month they were written in, which can be a little after the time of the observation
+	const time_t FirstMonth(Query.Start);
+	struct tm UTC;
+	gmtime_r(&FirstMonth, &UTC);
+	UTC.tm_mday = 1;
+	UTC.tm_hour = UTC.tm_min = UTC.tm_sec = 0;
+	for (time_t Month = timegm(&UTC); Month < Query.End + LOG_INDEX_HOUR; UTC.tm_mon++, Month = timegm(&UTC))
+	{
+		const std::filesystem::path LogFileName(GenerateLogFileName(Month));
+		if (std::filesystem::exists(LogFileName))
+		{
+			MapLogFile(LogFileName, [&](const std::string_view Contents)
 				{
-					for (auto index = 0; index < (GraphWidth < TheValues.size() ? GraphWidth : TheValues.size()); index++)
-					{
-						WindMin = std::min(WindMin, TheValues[index].GetWindSpeed());
-						WindMax = std::max(WindMax, TheValues[index].GetWindSpeed());
-					}
-					for (auto index = 0; index < (GraphWidth < TheValues.size() ? GraphWidth : TheValues.size()); index++)
+					const std::filesystem::path IndexFileName(std::filesystem::path(LogFileName).replace_extension(".idx"));
+					LogIndex TheIndex;
+					TheIndex.Read(IndexFileName);
+					if (TheIndex.Update(Contents))
 					{
-						PressureMin = std::min(PressureMin, TheValues[index].GetOutsidePressure());
-						PressureMax = std::max(PressureMax, TheValues[index].GetOutsidePressure());
+						if (ConsoleVerbosity > 0)
+							std::cout << "[" << getTimeISO8601() << "] Indexing: " << LogFileName.string() << std::endl;
+						else
+							std::cerr << "Indexing: " << LogFileName.string() << std::endl;
+						TheIndex.Write(IndexFileName);
 					}
-				}
-				const int GraphTop = FontSize + TickSize;
-				const int GraphBottom = SVGHeight - GraphTop;
-				int GraphRight = SVGWidth - GraphTop;
-				const bool DrawPressure = PressureMax - PressureMin > MinPressureDifferential;
-				if (DrawPressure)
-				{
-					// Space for legend to be drawn on the right of the graph plus space for one more legend line on the left.
-					GraphWidth -= FontSize * 2;
-					GraphRight -= FontSize + TickSize * 2;
-				}
-				else
-				{
-					// Space to add the Pressure Legend on the left
-					GraphWidth -= FontSize;
-				}
-				int GraphLeft = GraphRight - GraphWidth;
-				const int GraphVerticalDivision = (GraphBottom - GraphTop) / 4;
-				const double WindVerticalDivision = (WindMax - WindMin) / 4;
-				const double WindVerticalFactor = (GraphBottom - GraphTop) / (WindMax - WindMin);
-				const double PressureVerticalDivision = (PressureMax - PressureMin) / 4;
-				const double PressureVerticalFactor = (GraphBottom - GraphTop) / (PressureMax - PressureMin);
-
-				SVGFile << "<?xml version=\"1.0\" encoding=\"utf-8\" standalone=\"no\"?>" << std::endl;
-				SVGFile << "<svg xmlns=\"http://www.w3.org/2000/svg\" xmlns:xlink=\"http://www.w3.org/1999/xlink\" width=\"" << SVGWidth << "\" height=\"" << SVGHeight << "\">" << std::endl;
-				SVGFile << "\t<!-- Created by: " << ProgramVersionString << " -->" << std::endl;
-				SVGFile << "\t<clipPath id=\"GraphRegion\"><polygon points=\"" << GraphLeft << "," << GraphTop << " " << GraphRight << "," << GraphTop << " " << GraphRight << "," << GraphBottom << " " << GraphLeft << "," << GraphBottom << "\" /></clipPath>" << std::endl;
-				SVGFile << "\t<style>" << std::endl;
-				SVGFile << "\t\ttext { font-family: sans-serif; font-size: " << FontSize << "px; fill: dimgrey; }" << std::endl;
-				SVGFile << "\t\tline { stroke: dimgrey; }" << std::endl;
-				SVGFile << "\t\tpolygon { fill-opacity: 0.5; }" << std::endl;
-				SVGFile << "\t\t.barometer-label { font-family: Georgia, serif; font-style: italic; font-size: " << int(PressureVerticalFactor * 10) << "px; opacity: 0.5; clip-path: url(#GraphRegion); text-anchor: middle; dominant-baseline: middle; }" << std::endl;
-#ifdef _DARK_STYLE_
-				SVGFile << "\t@media only screen and (prefers-color-scheme: dark) {" << std::endl;
-				SVGFile << "\t\ttext { fill: grey; }" << std::endl;
-				SVGFile << "\t\tline { stroke: grey; }" << std::endl;
-				SVGFile << "\t}" << std::endl;
-#endif // _DARK_STYLE_
-				SVGFile << "\t</style>" << std::endl;
-				SVGFile << "\t<rect style=\"fill-opacity:0;stroke:grey;stroke-width:2\" width=\"" << SVGWidth << "\" height=\"" << SVGHeight << "\" />" << std::endl;
-
-				// Legend Text
-				int LegendIndex = 1;
-				SVGFile << "\t<text x=\"" << GraphLeft << "\" y=\"" << GraphTop - 2 << "\">" << Title << " Wind &amp; Pressure</text>" << std::endl;
-				SVGFile << "\t<text style=\"text-anchor:end\" x=\"" << GraphRight << "\" y=\"" << GraphTop - 2 << "\">" << timeToExcelLocal(TheValues[0].Time) << "</text>" << std::endl;
-				SVGFile << "\t<text style=\"fill:blue;text-anchor:middle\" x=\"" << FontSize * LegendIndex << "\" y=\"50%\" transform=\"rotate(270 " << FontSize * LegendIndex << "," << (GraphTop + GraphBottom) / 2 << ")\">" << YLegendWindSpeed << "</text>" << std::endl;
-				LegendIndex++;
-				SVGFile << "\t<text style=\"fill:blue;text-anchor:middle\" x=\"" << FontSize * LegendIndex << "\" y=\"50%\" transform=\"rotate(270 " << FontSize * LegendIndex << "," << (GraphTop + GraphBottom) / 2 << ")\">" << YLegendWindGust << "</text>" << std::endl;
-				LegendIndex++;
-				SVGFile << "\t<text style=\"fill:green;text-anchor:middle\" x=\"" << FontSize * LegendIndex << "\" y=\"50%\" transform=\"rotate(270 " << FontSize * LegendIndex << "," << (GraphTop + GraphBottom) / 2 << ")\">" << YLegendPressure << "</text>" << std::endl;
-
-				// Top Line
-				SVGFile << "\t<line x1=\"" << GraphLeft - TickSize << "\" y1=\"" << GraphTop << "\" x2=\"" << GraphRight + TickSize << "\" y2=\"" << GraphTop << "\"/>" << std::endl;
-				SVGFile << "\t<text style=\"fill:blue;text-anchor:end;dominant-baseline:middle\" x=\"" << GraphLeft - TickSize << "\" y=\"" << GraphTop << "\">" << std::fixed << std::setprecision(1) << WindMax << "</text>" << std::endl;
-				if (DrawPressure)
-					SVGFile << "\t<text style=\"fill:green;dominant-baseline:middle\" x=\"" << GraphRight + TickSize << "\" y=\"" << GraphTop << "\">" << std::fixed << std::setprecision(1) << PressureMax + AltitudeAdjustment << "</text>" << std::endl;
-
-				// Vertical Division Dashed Lines
-				for (auto index = 1; index < 4; index++)
-				{
-					SVGFile << "\t<line style=\"stroke-dasharray:1\" x1=\"" << GraphLeft - TickSize << "\" y1=\"" << GraphTop + (GraphVerticalDivision * index) << "\" x2=\"" << GraphRight + TickSize << "\" y2=\"" << GraphTop + (GraphVerticalDivision * index) << "\" />" << std::endl;
-					SVGFile << "\t<text style=\"fill:blue;text-anchor:end;dominant-baseline:middle\" x=\"" << GraphLeft - TickSize << "\" y=\"" << GraphTop + (GraphVerticalDivision * index) << "\">" << std::fixed << std::setprecision(1) << WindMax - (WindVerticalDivision * index) << "</text>" << std::endl;
-					if (DrawPressure)
-						SVGFile << "\t<text style=\"fill:green;dominant-baseline:middle\" x=\"" << GraphRight + TickSize << "\" y=\"" << GraphTop + (GraphVerticalDivision * index) << "\">" << std::fixed << std::setprecision(1) << PressureMax - (PressureVerticalDivision * index) + AltitudeAdjustment << "</text>" << std::endl;
-				}
-
-				// Bottom Line
-				SVGFile << "\t<line x1=\"" << GraphLeft - TickSize << "\" y1=\"" << GraphBottom << "\" x2=\"" << GraphRight + TickSize << "\" y2=\"" << GraphBottom << "\"/>" << std::endl;
-				SVGFile << "\t<text style=\"fill:blue;text-anchor:end;dominant-baseline:middle\" x=\"" << GraphLeft - TickSize << "\" y=\"" << GraphBottom << "\">" << std::fixed << std::setprecision(1) << WindMin << "</text>" << std::endl;
-				if (DrawPressure)
-					SVGFile << "\t<text style=\"fill:green;dominant-baseline:middle\" x=\"" << GraphRight + TickSize << "\" y=\"" << GraphBottom << "\">" << std::fixed << std::setprecision(1) << PressureMin + AltitudeAdjustment << "</text>" << std::endl;
-
-				// Left Line
-				SVGFile << "\t<line x1=\"" << GraphLeft << "\" y1=\"" << GraphTop << "\" x2=\"" << GraphLeft << "\" y2=\"" << GraphBottom << "\"/>" << std::endl;
-
-				// Horizontal Division Dashed Lines
-				for (auto index = 0; index < (GraphWidth < TheValues.size() ? GraphWidth : TheValues.size()); index++)
-				{
-					struct tm UTC;
-					if (0 != localtime_r(&TheValues[index].Time, &UTC))
+					for (auto Hour = TheIndex.Hours.lower_bound(Query.Start - Query.Start % LOG_INDEX_HOUR); (Hour != TheIndex.Hours.end()) && (Hour->first < Query.End); Hour++)
 					{
-						if (graph == GraphType::daily)
+						const time_t HourEnd = Hour->first + LOG_INDEX_HOUR;
+						if ((Hour->first >= Query.Start) && (HourEnd <= Query.End) && ((Hour->first - Query.Start) / Query.Resolution == (HourEnd - 1 - Query.Start) / Query.Resolution))
 						{
-							if (UTC.tm_min == 0)
-							{
-								if (UTC.tm_hour == 0)
-									SVGFile << "\t<line style=\"stroke:red\" x1=\"" << GraphLeft + index << "\" y1=\"" << GraphTop << "\" x2=\"" << GraphLeft + index << "\" y2=\"" << GraphBottom + TickSize << "\" />" << std::endl;
-								else
-									SVGFile << "\t<line style=\"stroke-dasharray:1\" x1=\"" << GraphLeft + index << "\" y1=\"" << GraphTop << "\" x2=\"" << GraphLeft + index << "\" y2=\"" << GraphBottom + TickSize << "\" />" << std::endl;
-								if (UTC.tm_hour % 2 == 0)
-									SVGFile << "\t<text style=\"text-anchor:middle\" x=\"" << GraphLeft + index << "\" y=\"" << SVGHeight - 2 << "\">" << UTC.tm_hour << "</text>" << std::endl;
-							}
+							IndexedHours++;
+							for (auto const& [Serial, TheValue] : Hour->second.Devices)
+								AddObservation(Serial, TheValue, Hour->first);
 						}
-						else if (graph == GraphType::weekly)
+						else
 						{
-							const std::string Weekday[] = { "Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat" };
-							if ((UTC.tm_hour == 0) && (UTC.tm_min == 0))
+							LoggedHours++;
+							const auto [First, Last] = TheIndex.GetHourLines(Hour->first, Contents.size());
+							for (size_t LineStart = First; LineStart < Last;)
 							{
-								if (UTC.tm_wday == 0)
-									SVGFile << "\t<line style=\"stroke:red\" x1=\"" << GraphLeft + index << "\" y1=\"" << GraphTop << "\" x2=\"" << GraphLeft + index << "\" y2=\"" << GraphBottom + TickSize << "\" />" << std::endl;
-								else
-									SVGFile << "\t<line style=\"stroke-dasharray:1\" x1=\"" << GraphLeft + index << "\" y1=\"" << GraphTop << "\" x2=\"" << GraphLeft + index << "\" y2=\"" << GraphBottom + TickSize << "\" />" << std::endl;
+								const std::string_view TheLine(GetLine(Contents, LineStart));
+								LineStart += TheLine.size() + 1;
+								const time_t ObservationTime = GetObservationTime(TheLine);
+								if ((ObservationTime >= Hour->first) && (ObservationTime < HourEnd))
+								{
+									const std::string Serial(GetJSONString(TheLine, "serial_number"));
+									TempestObservation TheValue(TheLine);
+									if (IsValidSerial(Serial) && TheValue.IsValid())
+										AddObservation(Serial, TheValue, ObservationTime);
+								}
 							}
-							else if ((UTC.tm_hour == 12) && (UTC.tm_min == 0))
-								SVGFile << "\t<text style=\"text-anchor:middle\" x=\"" << GraphLeft + index << "\" y=\"" << SVGHeight - 2 << "\">" << Weekday[UTC.tm_wday] << "</text>" << std::endl;
-						}
-						else if (graph == GraphType::monthly)
-						{
-							if ((UTC.tm_mday == 1) && (UTC.tm_hour == 0) && (UTC.tm_min == 0))
-								SVGFile << "\t<line style=\"stroke:red\" x1=\"" << GraphLeft + index << "\" y1=\"" << GraphTop << "\" x2=\"" << GraphLeft + index << "\" y2=\"" << GraphBottom + TickSize << "\" />" << std::endl;
-							if ((UTC.tm_wday == 0) && (UTC.tm_hour == 0) && (UTC.tm_min == 0))
-								SVGFile << "\t<line style=\"stroke-dasharray:1\" x1=\"" << GraphLeft + index << "\" y1=\"" << GraphTop << "\" x2=\"" << GraphLeft + index << "\" y2=\"" << GraphBottom + TickSize << "\" />" << std::endl;
-							else if ((UTC.tm_wday == 3) && (UTC.tm_hour == 12) && (UTC.tm_min == 0))
-								SVGFile << "\t<text style=\"text-anchor:middle\" x=\"" << GraphLeft + index << "\" y=\"" << SVGHeight - 2 << "\">Week " << UTC.tm_yday / 7 + 1 << "</text>" << std::endl;
-						}
-						else if (graph == GraphType::yearly)
-						{
-							const std::string Month[] = { "Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec" };
-							if ((UTC.tm_yday == 0) && (UTC.tm_mday == 1) && (UTC.tm_hour == 0) && (UTC.tm_min == 0))
-								SVGFile << "\t<line style=\"stroke:red\" x1=\"" << GraphLeft + index << "\" y1=\"" << GraphTop << "\" x2=\"" << GraphLeft + index << "\" y2=\"" << GraphBottom + TickSize << "\" />" << std::endl;
-							else if ((UTC.tm_mday == 1) && (UTC.tm_hour == 0) && (UTC.tm_min == 0))
-								SVGFile << "\t<line style=\"stroke-dasharray:1\" x1=\"" << GraphLeft + index << "\" y1=\"" << GraphTop << "\" x2=\"" << GraphLeft + index << "\" y2=\"" << GraphBottom + TickSize << "\" />" << std::endl;
-							else if ((UTC.tm_mday == 15) && (UTC.tm_hour == 0) && (UTC.tm_min == 0))
-								SVGFile << "\t<text style=\"text-anchor:middle\" x=\"" << GraphLeft + index << "\" y=\"" << SVGHeight - 2 << "\">" << Month[UTC.tm_mon] << "</text>" << std::endl;
 						}
 					}
-				}
-
-				// Right Line
-				SVGFile << "\t<line x1=\"" << GraphRight << "\" y1=\"" << GraphTop << "\" x2=\"" << GraphRight << "\" y2=\"" << GraphBottom << "\"/>" << std::endl;
-
-				// Directional Arrow
-				SVGFile << "\t<polygon style=\"fill:red;stroke:red;fill-opacity:1;\" points=\"" << GraphLeft - 3 << "," << GraphBottom << " " << GraphLeft + 3 << "," << GraphBottom - 3 << " " << GraphLeft + 3 << "," << GraphBottom + 3 << "\" />" << std::endl;
-
-				if (MinMax)
+				}, MADV_RANDOM);
+		}
+		else if (std::filesystem::exists(LogDirectory))
+		{
+			const std::string Stem(LogFileName.stem().string());
+			const std::regex ArchiveFileRegex("weatherflow-[[:alnum:]-]+-" + Stem.substr(Stem.length() - std::string("YYYY-MM").length()) + ".wfa");
+			for (auto const& dir_entry : std::filesystem::directory_iterator{ LogDirectory })
+				if (dir_entry.is_regular_file() && std::regex_match(dir_entry.path().filename().string(), ArchiveFileRegex))
 				{
-					// OutsidePressure Values as a filled polygon showing the minimum and maximum
-					if (DrawPressure)
+					if (ConsoleVerbosity > 0)
+						std::cout << "[" << getTimeISO8601() << "] Reading: " << dir_entry.path().string() << std::endl;
+					else
+						std::cerr << "Reading: " << dir_entry.path().string() << std::endl;
+					const std::string Serial(GetArchiveSerial(dir_entry.path()));
+					for (auto const& Row : ReadArchiveFile(dir_entry.path(), Query.Start - 1))
 					{
-						SVGFile << "\t<!-- OutsidePressure MinMax -->" << std::endl;
-						SVGFile << "\t<polygon style=\"fill:green;stroke:green;clip-path:url(#GraphRegion)\" points=\"";
-						for (auto index = 1; index < (GraphWidth < TheValues.size() ? GraphWidth : TheValues.size()); index++)
-							SVGFile << index + GraphLeft << "," << int(((PressureMax - TheValues[index].GetOutsidePressureMax()) * PressureVerticalFactor) + GraphTop) << " ";
-						for (auto index = (GraphWidth < TheValues.size() ? GraphWidth : TheValues.size()) - 1; index > 0; index--)
-							SVGFile << index + GraphLeft << "," << int(((PressureMax - TheValues[index].GetOutsidePressureMin()) * PressureVerticalFactor) + GraphTop) << " ";
-						SVGFile << "\" />" << std::endl;
+						double obs[18];
+						std::copy(Row.begin(), Row.end(), obs);
+						TempestObservation TheValue(obs);
+						if (TheValue.IsValid())
+							AddObservation(Serial, TheValue, TheValue.Time);
 					}
-					// ApparentWindSpeed Values as a filled polygon showing the minimum and maximum
-					SVGFile << "\t<!-- ApparentWindSpeed MinMax -->" << std::endl;
-					SVGFile << "\t<polygon style=\"fill:blue;stroke:blue;clip-path:url(#GraphRegion)\" points=\"";
-					for (auto index = 1; index < (GraphWidth < TheValues.size() ? GraphWidth : TheValues.size()); index++)
-						SVGFile << index + GraphLeft << "," << int(((WindMax - TheValues[index].GetWindSpeedMax()) * WindVerticalFactor) + GraphTop) << " ";
-					for (auto index = (GraphWidth < TheValues.size() ? GraphWidth : TheValues.size()) - 1; index > 0; index--)
-						SVGFile << index + GraphLeft << "," << int(((WindMax - TheValues[index].GetWindSpeed()) * WindVerticalFactor) + GraphTop) << " ";
-					SVGFile << "\" />" << std::endl;
 				}
-				// OutsidePressure Values as a continuous line
-				if (DrawPressure)
+		}
+	}
+	if (ConsoleVerbosity > 0)
+		std::cout << "[" << getTimeISO8601() << "] Query: " << IndexedHours << " hours from the indexes, " << LoggedHours << " hours from the logs" << std::endl;
+	else
+		std::cerr << "Query: " << IndexedHours << " hours from the indexes, " << LoggedHours << " hours from the logs" << std::endl;
+	return(rval);
+}
+// Answers --query for one device. The buckets with observations are written as CSV on stdout, or with --svg as a CSV file and the
+// temperature, wind, rain and solar graphs in the SVG directory. The graphs draw one column per bucket, so they show the newest few hundred.
+bool RunLogQuery(const std::string& Argument)
+{
+	bool rval = false;
+	LogQuery Query;
+	if (LogDirectory.empty())
+		std::cerr << "A query needs the log directory, --log" << std::endl;
+	else if (Query.Parse(Argument))
+	{
+		if (SVGDirectory.empty())
+			ConsoleVerbosity = std::min(ConsoleVerbosity, 0);	// stdout is the CSV, so messages go to stderr
+		const std::map<std::string, std::vector<TempestObservation>> DeviceBuckets(ReadLogQuery(Query));
+		auto Device = Query.Serial.empty() ? DeviceBuckets.begin() : DeviceBuckets.find(Query.Serial);
+		if (Device == DeviceBuckets.end())
+			std::cerr << "No observations " << (Query.Serial.empty() ? "" : "of " + Query.Serial + " ") << "between " << timeToExcelLocal(Query.Start) << " and " << timeToExcelLocal(Query.End) << std::endl;
+		else
+		{
+			std::vector<TempestObservation> TheValues;	// newest first, like the rings
+			time_t NewestTime = 0;
+			for (size_t index = Device->second.size(); index > 0; index--)
+				if (Device->second[index - 1].IsValid())
+				{
+					NewestTime = std::max(NewestTime, Device->second[index - 1].Time);
+					TheValues.push_back(Device->second[index - 1]);
+					TheValues.back().Time = Query.Start + (index - 1) * Query.Resolution;
+				}
+			const TempestColumns Columns(TheValues);
+			TempestSeries TheSeries(Columns.GetSeries());
+			TheSeries.NewestTime = NewestTime;
+			// The time axis is marked like the graph whose samples are closest to the resolution
+			GraphType graph = GraphType::daily;
+			if (Query.Resolution >= time_t(YEAR_SAMPLE))
+				graph = GraphType::yearly;
+			else if (Query.Resolution >= time_t(MONTH_SAMPLE))
+				graph = GraphType::monthly;
+			else if (Query.Resolution >= time_t(WEEK_SAMPLE))
+				graph = GraphType::weekly;
+			const std::string Title("Tempest " + Device->first);
+			TimeAxisLayout TimeAxis;
+			SVGBuffer OutputFile;
+			RenderDataCSV(OutputFile, TheSeries);
+			if (SVGDirectory.empty())
+			{
+				std::cout << OutputFile.view();
+				std::cout.flush();
+				rval = std::cout.good();
+			}
+			else
+			{
+				const std::string Prefix("weatherflow-" + Device->first + "-query");
+				rval = PublishSVG(SVGDirectory / (Prefix + ".csv"), OutputFile.view(), NewestTime);
+				// A query can have any number of samples, so the graphs always fold them into their width, the way --envelope does, instead of only drawing the newest
+				const std::array<std::pair<std::string, std::function<void(SVGBuffer&)>>, 4> Graphs = { {
+					{ "-temperature.svg", [&](SVGBuffer& SVGFile) { RenderTemperatureSVG(SVGFile, TheSeries, Title, graph, TimeAxis, SVGFahrenheit, SVGBattery & GraphBit(graph), true, SVGSimplify & GraphBit(graph), true); } },
+					{ "-wind.svg", [&](SVGBuffer& SVGFile) { RenderWindSVG(SVGFile, TheSeries, Title, graph, TimeAxis, true, graph == GraphType::daily ? 1.0 : 4.0, SVGSimplify & GraphBit(graph), true); } },
+					{ "-rain.svg", [&](SVGBuffer& SVGFile) { RenderRainSVG(SVGFile, TheSeries, Title, graph, TimeAxis, SVGSimplify & GraphBit(graph), true); } },
+					{ "-solar.svg", [&](SVGBuffer& SVGFile) { RenderSolarSVG(SVGFile, TheSeries, Title, graph, TimeAxis, true, SVGSimplify & GraphBit(graph), true); } },
+				} };
+				for (auto const& [Name, Render] : Graphs)
 				{
-					SVGFile << "\t<!-- OutsidePressure -->" << std::endl;
-					SVGFile << "\t<polyline style=\"fill:none;stroke:green;clip-path:url(#GraphRegion)\" points=\"";
-					for (auto index = 1; index < (GraphWidth < TheValues.size() ? GraphWidth : TheValues.size()); index++)
-						SVGFile << index + GraphLeft << "," << int(((PressureMax - TheValues[index].GetOutsidePressure()) * PressureVerticalFactor) + GraphTop) << " ";
-					SVGFile << "\" />" << std::endl;
+					const std::filesystem::path SVGFileName(SVGDirectory / (Prefix + Name));
+					if (ConsoleVerbosity > 0)
+						std::cout << "[" << getTimeISO8601() << "] Writing: " << SVGFileName.string() << " With Title: " << Title << std::endl;
+					else
+						std::cerr << "Writing: " << SVGFileName.string() << " With Title: " << Title << std::endl;
+					OutputFile.clear();
+					Render(OutputFile);
+					rval = PublishSVG(SVGFileName, OutputFile.view(), NewestTime) && rval;
 				}
-				// ApparentWindSpeed Values as a continuous line
-				SVGFile << "\t<!-- ApparentWindSpeed -->" << std::endl;
-				SVGFile << "\t<polyline style=\"fill:none;stroke:blue;clip-path:url(#GraphRegion)\" points=\"";
-				for (auto index = 1; index < (GraphWidth < TheValues.size() ? GraphWidth : TheValues.size()); index++)
-					SVGFile << index + GraphLeft << "," << int(((WindMax - TheValues[index].GetWindSpeed()) * WindVerticalFactor) + GraphTop) << " ";
-				SVGFile << "\" />" << std::endl;
-
-				if (DrawPressure)
-					if (graph != GraphType::daily) // this text was way too busy on the daily graph
-					{
-						SVGFile << "\t<text class=\"barometer-label\" x=\"50%\" y=\"" << int(((PressureMax - 974) * PressureVerticalFactor) + GraphTop) << "\">Rain</text>" << std::endl;
-						SVGFile << "\t<text class=\"barometer-label\" x=\"50%\" y=\"" << int(((PressureMax - 999) * PressureVerticalFactor) + GraphTop) << "\">Change</text>" << std::endl;
-						SVGFile << "\t<text class=\"barometer-label\" x=\"50%\" y=\"" << int(((PressureMax - 1024) * PressureVerticalFactor) + GraphTop) << "\">Fair</text>" << std::endl;
-					}
-
-				SVGFile << "</svg>" << std::endl;
-				SVGFile.close();
-				struct utimbuf SVGut({ TheValues.begin()->Time, TheValues.begin()->Time });
-				utime(SVGFileName.c_str(), &SVGut);
 			}
 		}
 	}
+	return(rval);
 }
 /////////////////////////////////////////////////////////////////////////////
-void WriteAllSVG()
-{
-	std::string ssTitle("Tempest");
-	std::vector<TempestObservation> TheValues;
-	ReadMRTGData(TheValues, GraphType::daily);
-	WriteTemperatureSVG(TheValues, SVGDirectory / "weatherflow-temperature-day.svg", ssTitle, GraphType::daily, SVGFahrenheit, SVGBattery & 0x01, SVGMinMax & 0x01);
-	WriteWindSVG(TheValues, SVGDirectory / "weatherflow-wind-day.svg", ssTitle, GraphType::daily, true, 1.0);
-	ReadMRTGData(TheValues, GraphType::weekly);
-	WriteTemperatureSVG(TheValues, SVGDirectory / "weatherflow-temperature-week.svg", ssTitle, GraphType::weekly, SVGFahrenheit, SVGBattery & 0x02, SVGMinMax & 0x02);
-	WriteWindSVG(TheValues, SVGDirectory / "weatherflow-wind-week.svg", ssTitle, GraphType::weekly, true);
-	ReadMRTGData(TheValues, GraphType::monthly);
-	WriteTemperatureSVG(TheValues, SVGDirectory / "weatherflow-temperature-month.svg", ssTitle, GraphType::monthly, SVGFahrenheit, SVGBattery & 0x04, SVGMinMax & 0x04);
-	WriteWindSVG(TheValues, SVGDirectory / "weatherflow-wind-month.svg", ssTitle, GraphType::monthly, true);
-	ReadMRTGData(TheValues, GraphType::yearly);
-	WriteTemperatureSVG(TheValues, SVGDirectory / "weatherflow-temperature-year.svg", ssTitle, GraphType::yearly, SVGFahrenheit, SVGBattery & 0x08, SVGMinMax & 0x08);
-	WriteWindSVG(TheValues, SVGDirectory / "weatherflow-wind-year.svg", ssTitle, GraphType::yearly, true);
+// Times the single pass parser against the jsoncpp parser on every line of a recorded log file, and checks that both produce the same observations.
+void BenchmarkParsers(const std::filesystem::path& filename)
+{
+	std::ifstream TheFile(filename);
+	if (TheFile.is_open())
+	{
+		std::vector<std::string> Lines;
+		std::string TheLine;
+		while (std::getline(TheFile, TheLine))
+			Lines.push_back(TheLine);
+		TheFile.close();
+		std::cout << "[" << getTimeISO8601() << "] Benchmark: " << filename.string() << " (" << Lines.size() << " lines)" << std::endl;
+		std::ostringstream ResultsJsonCpp, ResultsJSON;
+		size_t ValidJsonCpp(0), ValidJSON(0);
+		auto StartJsonCpp = std::chrono::steady_clock::now();
+		for (auto const& Line : Lines)
+		{
+			TempestObservation TheValue;
+			if (TheValue.ReadJsonCpp(Line))
+			{
+				ValidJsonCpp++;
+				TheValue.WriteCache(ResultsJsonCpp);
+			}
+		}
+		auto StartJSON = std::chrono::steady_clock::now();
+		for (auto const& Line : Lines)
+		{
+			TempestObservation TheValue;
+			if (TheValue.ReadJSON(Line))
+			{
+				ValidJSON++;
+				TheValue.WriteCache(ResultsJSON);
+			}
+		}
+		auto Finish = std::chrono::steady_clock::now();
+		const std::chrono::duration<double, std::milli> DurationJsonCpp(StartJSON - StartJsonCpp);
+		const std::chrono::duration<double, std::milli> DurationJSON(Finish - StartJSON);
+		std::cout << "[                   ]  jsoncpp: " << std::fixed << std::setprecision(1) << DurationJsonCpp.count() << " ms, " << ValidJsonCpp << " observations" << std::endl;
+		std::cout << "[                   ]     fast: " << std::fixed << std::setprecision(1) << DurationJSON.count() << " ms, " << ValidJSON << " observations" << std::endl;
+		if (DurationJSON.count() > 0)
+			std::cout << "[                   ]  speedup: " << std::fixed << std::setprecision(1) << DurationJsonCpp.count() / DurationJSON.count() << "x" << std::endl;
+		std::cout << "[                   ]  results: " << (ResultsJsonCpp.str() == ResultsJSON.str() ? "identical" : "DIFFERENT") << std::endl;
+	}
+	else
+		std::cerr << "Unable to open: " << filename << std::endl;
+}
+// Times rendering all eight graphs into a std::ostringstream, the way the files used to be written, against rendering them into an SVGBuffer.
+// The rings are built from a log file, and the text of both is compared.
+void BenchmarkSVG(const std::filesystem::path& filename)
+{
+	ReadLoggedData(filename);
+	auto Device = std::find_if(TempestDevices.begin(), TempestDevices.end(), [](const auto& Device) { return(!Device.second.MRTG.empty()); });
+	if (Device != TempestDevices.end())
+	{
+		const TempestMRTGData& TheData(Device->second.MRTG);
+		TimeAxisLayouts& TimeAxis(Device->second.SVGTimeAxis);
+		const int Iterations(100);
+		const std::string ssTitle("Tempest");
+		const std::array<GraphType, 4> Graphs = { GraphType::daily, GraphType::weekly, GraphType::monthly, GraphType::yearly };
+		std::vector<TempestSeries> Series;
+		for (auto const& graph : Graphs)
+			Series.push_back(ReadMRTGData(TheData, graph));
+		std::cout << "[" << getTimeISO8601() << "] Benchmark: rendering 8 SVG files " << Iterations << " times" << std::endl;
+		std::string ResultsStream, ResultsBuffer;
+		size_t Bytes(0);
+		auto StartStream = std::chrono::steady_clock::now();
+		for (auto iteration = 0; iteration < Iterations; iteration++)
+			for (size_t index = 0; index < Graphs.size(); index++)
+			{
+				std::ostringstream SVGFile;
+				RenderTemperatureSVG(SVGFile, Series[index], ssTitle, Graphs[index], TimeAxis[index], SVGFahrenheit, true, true);
+				RenderWindSVG(SVGFile, Series[index], ssTitle, Graphs[index], TimeAxis[index], true, 1.0);
+				Bytes += SVGFile.str().size();
+				if (iteration == 0)
+					ResultsStream.append(SVGFile.str());
+			}
+		SVGBuffer SVGFile;	// reused the same way each render thread reuses its own
+		auto StartBuffer = std::chrono::steady_clock::now();
+		for (auto iteration = 0; iteration < Iterations; iteration++)
+			for (size_t index = 0; index < Graphs.size(); index++)
+			{
+				SVGFile.clear();
+				RenderTemperatureSVG(SVGFile, Series[index], ssTitle, Graphs[index], TimeAxis[index], SVGFahrenheit, true, true);
+				RenderWindSVG(SVGFile, Series[index], ssTitle, Graphs[index], TimeAxis[index], true, 1.0);
+				Bytes -= SVGFile.size();
+				if (iteration == 0)
+					ResultsBuffer.append(SVGFile.view());
+			}
+		auto Finish = std::chrono::steady_clock::now();
+		const std::chrono::duration<double, std::milli> DurationStream(StartBuffer - StartStream);
+		const std::chrono::duration<double, std::milli> DurationBuffer(Finish - StartBuffer);
+		std::cout << "[                   ] iostream: " << std::fixed << std::setprecision(1) << DurationStream.count() << " ms, " << ResultsStream.size() << " bytes per pass" << std::endl;
+		std::cout << "[                   ]   buffer: " << std::fixed << std::setprecision(1) << DurationBuffer.count() << " ms, " << ResultsBuffer.size() << " bytes per pass" << std::endl;
+		if (DurationBuffer.count() > 0)
+			std::cout << "[                   ]  speedup: " << std::fixed << std::setprecision(1) << DurationStream.count() / DurationBuffer.count() << "x" << std::endl;
+		std::cout << "[                   ]  results: " << ((ResultsStream == ResultsBuffer) && (Bytes == 0) ? "identical" : "DIFFERENT") << std::endl;
+	}
+	else
+		std::cerr << "No observations in: " << filename << std::endl;
 }
 /////////////////////////////////////////////////////////////////////////////
 volatile bool bRun = true; // This is declared volatile so that the compiler won't optimized it out of loops later in the code
@@ -1182,6 +4550,157 @@ void SignalHandlerSIGALRM(int signal)
 		std::cout << "[" << getTimeISO8601() << "] ***************** SIGALRM: Caught Alarm. *****************" << std::endl;
 }
 /////////////////////////////////////////////////////////////////////////////
+// UDP datagrams are read on their own thread with recvmmsg(), a batch at a time, into a fixed slab of buffers.
+// Full batches are handed to the main loop through a single producer, single consumer ring, and an eventfd wakes the main loop's select().
+// If the main loop falls behind and the ring is full, the ingest thread keeps draining the socket and counts what it throws away,
+// along with what the kernel reports it dropped before the datagrams were read.
+const size_t UDP_DATAGRAM_SIZE = 1024;	// Tempest messages are well under this, anything longer is counted as truncated
+const size_t UDP_BATCH_SIZE = 16;	// datagrams read by one recvmmsg() call
+const size_t UDP_BATCH_COUNT = 16;	// batches in the slab
+struct UDPBatch
+{
+	std::array<std::array<char, UDP_DATAGRAM_SIZE>, UDP_BATCH_SIZE> Data;
+	std::array<unsigned int, UDP_BATCH_SIZE> Length;
+	unsigned int Count = 0;
+};
+class UDPBatchQueue
+{
+public:
+	UDPBatch* front(void) { return(Head.load(std::memory_order_acquire) == Tail.load(std::memory_order_relaxed) ? nullptr : &Slab[Tail.load(std::memory_order_relaxed) % UDP_BATCH_COUNT]); };	// consumer
+	void pop(void) { Tail.store(Tail.load(std::memory_order_relaxed) + 1, std::memory_order_release); };	// consumer
+	UDPBatch* back(void) { return(Head.load(std::memory_order_relaxed) - Tail.load(std::memory_order_acquire) == UDP_BATCH_COUNT ? nullptr : &Slab[Head.load(std::memory_order_relaxed) % UDP_BATCH_COUNT]); };	// producer
+	void push(void) { Head.store(Head.load(std::memory_order_relaxed) + 1, std::memory_order_release); };	// producer
+private:
+	std::array<UDPBatch, UDP_BATCH_COUNT> Slab;
+	alignas(64) std::atomic<size_t> Head{ 0 };	// only written by the producer
+	alignas(64) std::atomic<size_t> Tail{ 0 };	// only written by the consumer
+};
+UDPBatchQueue UDPQueue;
+std::atomic<unsigned long long> UDPReceived(0);	// datagrams read from the socket
+std::atomic<unsigned long long> UDPDropped(0);	// datagrams thrown away because the queue was full, or by the kernel because the socket buffer was
+std::atomic<unsigned long long> UDPTruncated(0);	// datagrams longer than UDP_DATAGRAM_SIZE
+std::atomic<bool> UDPIngestRun(true);
+void UDPIngest(const int UDPSocket, const int WakeEvent)
+{
+	UDPBatch Overflow;	// receives the datagrams that have nowhere to go when the queue is full
+	std::array<struct iovec, UDP_BATCH_SIZE> IOVectors;
+	std::array<struct mmsghdr, UDP_BATCH_SIZE> Messages;
+	std::array<std::array<char, CMSG_SPACE(sizeof(uint32_t))>, UDP_BATCH_SIZE> Controls;	// SO_RXQ_OVFL count of datagrams the kernel dropped
+	uint32_t KernelDropped(0);
+	const int On(1);
+	setsockopt(UDPSocket, SOL_SOCKET, SO_RXQ_OVFL, &On, sizeof(On));
+	while (UDPIngestRun)
+	{
+		struct pollfd UDPPoll = { UDPSocket, POLLIN, 0 };
+		if (0 < poll(&UDPPoll, 1, 1000))	// wakes each second to check UDPIngestRun
+		{
+			UDPBatch* Batch = UDPQueue.back();
+			const bool QueueFull = (Batch == nullptr);
+			if (QueueFull)
+				Batch = &Overflow;
+			for (size_t index = 0; index < UDP_BATCH_SIZE; index++)
+			{
+				IOVectors[index].iov_base = Batch->Data[index].data();
+				IOVectors[index].iov_len = Batch->Data[index].size();
+				memset(&Messages[index], 0, sizeof(Messages[index]));
+				Messages[index].msg_hdr.msg_iov = &IOVectors[index];
+				Messages[index].msg_hdr.msg_iovlen = 1;
+				Messages[index].msg_hdr.msg_control = Controls[index].data();
+				Messages[index].msg_hdr.msg_controllen = Controls[index].size();
+			}
+			const int Count = recvmmsg(UDPSocket, Messages.data(), UDP_BATCH_SIZE, MSG_DONTWAIT, NULL);
+			if (Count > 0)
+			{
+				UDPReceived += Count;
+				Batch->Count = Count;
+				for (auto index = 0; index < Count; index++)
+				{
+					Batch->Length[index] = std::min(size_t(Messages[index].msg_len), UDP_DATAGRAM_SIZE);
+					if (Messages[index].msg_hdr.msg_flags & MSG_TRUNC)
+						UDPTruncated++;
+					for (auto Control = CMSG_FIRSTHDR(&Messages[index].msg_hdr); Control != NULL; Control = CMSG_NXTHDR(&Messages[index].msg_hdr, Control))
+						if ((Control->cmsg_level == SOL_SOCKET) && (Control->cmsg_type == SO_RXQ_OVFL))
+						{
+							uint32_t Total;
+							memcpy(&Total, CMSG_DATA(Control), sizeof(Total));
+							UDPDropped += uint32_t(Total - KernelDropped);
+							KernelDropped = Total;
+						}
+				}
+				if (QueueFull)
+					UDPDropped += Count;
+				else
+				{
+					UDPQueue.push();
+					const uint64_t One(1);
+					if (-1 == write(WakeEvent, &One, sizeof(One)))
+						if (ConsoleVerbosity > 0)
+							std::cout << "[" << getTimeISO8601() << "] " << std::strerror(errno) << ": UDP ingest wakeup" << std::endl;
+				}
+			}
+		}
+	}
+}
+void ProcessTempestMessage(const std::string_view JSonData)
+{
+	if (ConsoleVerbosity > 0)
+		std::cout << "[" << getTimeISO8601() << "] " << JSonData << std::endl;
+
+	// https://apidocs.tempestwx.com/reference/tempest-udp-broadcast
+	const std::string_view msgtype(GetTempestMessageType(JSonData));
+	const std::string Serial(GetJSONString(JSonData, "serial_number"));
+	if (!IsValidSerial(Serial))
+		return;	// every message this program uses comes from a device, and the serial number becomes part of file names
+	if (!msgtype.compare("rapid_wind"))
+	{
+		double observation[3];
+		if (ReadRapidWind(JSonData, observation))
+		{
+			//{"serial_number":"ST-00145757","type":"rapid_wind","hub_sn":"HB-00147479","ob":[1718217088,2.38,332]}
+			//{"serial_number":"ST-00145757","type":"rapid_wind","hub_sn":"HB-00147479","ob":[1718217091,2.02,335]}
+			//{"serial_number":"ST-00145757","type":"rapid_wind","hub_sn":"HB-00147479","ob":[1718217094,2.27,318]}
+			//{"serial_number":"ST-00145757","type":"rapid_wind","hub_sn":"HB-00147479","ob":[1718217097,2.66,339]}
+			//{"serial_number":"ST-00145757","type":"rapid_wind","hub_sn":"HB-00147479","ob":[1718217100,2.30,352]}
+			//{"serial_number":"ST-00145757","type":"rapid_wind","hub_sn":"HB-00147479","ob":[1718217103,1.74,354]}
+			//{"serial_number":"ST-00145757","type":"rapid_wind","hub_sn":"HB-00147479","ob":[1718217106,1.58,4]}
+			//{"serial_number":"ST-00145757","type":"rapid_wind","hub_sn":"HB-00147479","ob":[1718217109,2.35,351]}
+			auto timetick = time_t(observation[0]);
+			auto windspeed = float(observation[1]);
+			auto winddirection = int(observation[2]);
+			if (ConsoleVerbosity > 1)
+				std::cout << "[" << getTimeISO8601() << "] Rapid Wind: " << timetick << ", " << windspeed << ", " << winddirection << std::endl;
+			TempestDevices[Serial].RapidWind.push_back(timetick, windspeed, winddirection);
+		}
+	}
+	else if (!msgtype.compare("obs_st"))
+	{
+		double obs[18];
+		if (TempestObservation::ParseObservation(JSonData, obs))
+		{
+			TempestObservation observation(obs);
+			if (observation.IsValid())
+			{
+				if (ConsoleVerbosity > 1)
+					std::cout << "[" << timeToISO8601(observation.Time) << "] observation read properly: " << JSonData << std::endl;
+				UpdateMRTGData(TempestDevices[Serial].MRTG, observation);
+			}
+			if (LogArchive)
+			{
+				std::vector<ArchiveRow>& ToBeArchived(TempestDevices[Serial].Archive.ToBeArchived);
+				ToBeArchived.emplace_back();
+				std::copy(std::begin(obs), std::end(obs), ToBeArchived.back().begin());
+			}
+		}
+	}
+}
+void LogUDPCounters(void)
+{
+	if (ConsoleVerbosity > 0)
+		std::cout << "[" << getTimeISO8601() << "] UDP datagrams received: " << UDPReceived << " dropped: " << UDPDropped << " truncated: " << UDPTruncated << std::endl;
+	else if (UDPDropped + UDPTruncated > 0)
+		std::cerr << "UDP datagrams received: " << UDPReceived << " dropped: " << UDPDropped << " truncated: " << UDPTruncated << std::endl;
+}
+/////////////////////////////////////////////////////////////////////////////
 static void usage(int argc, char** argv)
 {
 	std::cout << "Usage: " << argv[0] << " [options]" << std::endl;
@@ -1190,20 +4709,33 @@ static void usage(int argc, char** argv)
 	std::cout << "    -h | --help          Print this message" << std::endl;
 	std::cout << "    -l | --log name      Logging Directory [" << LogDirectory << "]" << std::endl;
 	std::cout << "    -t | --time seconds  Time between log file writes [" << LogFileTime << "]" << std::endl;
+	std::cout << "    -y | --sync          fdatasync the log file after each write [" << std::boolalpha << LogFileSync << "]" << std::endl;
+	std::cout << "    -a | --archive       Also write observations to compressed .wfa archive files [" << std::boolalpha << LogArchive << "]" << std::endl;
+	std::cout << "    -C | --convert name  Convert a .txt log file, or every log file in a directory, to an archive file and exit" << std::endl;
 	std::cout << "    -v | --verbose level stdout verbosity level [" << ConsoleVerbosity << "]" << std::endl;
 	std::cout << "    -f | --cache name    cache file directory [" << CacheDirectory << "]" << std::endl;
 	std::cout << "    -s | --svg name      SVG output directory [" << SVGDirectory << "]" << std::endl;
 	std::cout << "    -c | --celsius       SVG output using degrees C [" << std::boolalpha << !SVGFahrenheit << "]" << std::endl;
 	std::cout << "    -p | --pressure      hPa offset for altitude difference from sea level [" << AltitudeAdjustment << "]" << std::endl;
 	std::cout << "    -b | --battery graph Draw the battery status on SVG graphs. 1:daily, 2:weekly, 4:monthly, 8:yearly" << std::endl;
-	std::cout << "    -x | --minmax graph  Draw the minimum and maximum temperature and humidity status on SVG graphs. 1:daily, 2:weekly, 4:monthly, 8:yearly" << std::endl;
+	std::cout << "    -x | --minmax graph  Draw the minimum and maximum temperature and humidity, and the peak solar and UV, on SVG graphs. 1:daily, 2:weekly, 4:monthly, 8:yearly" << std::endl;
+	std::cout << "    -S | --simplify graph Leave out points along straight runs of the SVG graph lines. 1:daily, 2:weekly, 4:monthly, 8:yearly" << std::endl;
+	std::cout << "    -e | --envelope graph Fold every sample into the width of the SVG graphs, drawing the minimum and maximum of each column. 1:daily, 2:weekly, 4:monthly, 8:yearly" << std::endl;
+	std::cout << "    -w | --workers count Number of threads reading log files at startup [" << LogReadThreads << "]" << std::endl;
+	std::cout << "    -r | --render-threads count Number of threads rendering SVG files [" << SVGRenderThreads << "]" << std::endl;
+	std::cout << "    -P | --http-port port Serve the graphs over HTTP from memory on this port, 0 for none [" << HTTPPort << "]" << std::endl;
+	std::cout << "    -Q | --query start,end,resolution[,serial] Write the logged observations of a time range as CSV, or CSV and SVG files with --svg, and exit" << std::endl;
+	std::cout << "    -B | --benchmark name Compare JSON parser and SVG writer speed on a log file and exit" << std::endl;
 	std::cout << std::endl;
 }
-static const char short_options[] = "hl:t:v:f:s:cp:b:x";
+static const char short_options[] = "hl:t:yaC:v:f:s:cp:b:xS:e:w:r:P:Q:B:";
 static const struct option long_options[] = {
 		{ "help",   no_argument,       NULL, 'h' },
 		{ "log",    required_argument, NULL, 'l' },
 		{ "time",   required_argument, NULL, 't' },
+		{ "sync",   no_argument,       NULL, 'y' },
+		{ "archive",no_argument,       NULL, 'a' },
+		{ "convert",required_argument, NULL, 'C' },
 		{ "verbose",required_argument, NULL, 'v' },
 		{ "cache",	required_argument, NULL, 'f' },
 		{ "svg",	required_argument, NULL, 's' },
@@ -1211,6 +4743,13 @@ static const struct option long_options[] = {
 		{ "pressure",required_argument,NULL, 'p' },
 		{ "battery",required_argument, NULL, 'b' },
 		{ "minmax",	required_argument, NULL, 'x' },
+		{ "simplify",	required_argument, NULL, 'S' },
+		{ "envelope",	required_argument, NULL, 'e' },
+		{ "workers",required_argument, NULL, 'w' },
+		{ "render-threads",required_argument, NULL, 'r' },
+		{ "http-port",required_argument, NULL, 'P' },
+		{ "query",	required_argument, NULL, 'Q' },
+		{ "benchmark",required_argument,NULL,'B' },
 		{ 0, 0, 0, 0 }
 };
 /////////////////////////////////////////////////////////////////////////////
@@ -1248,6 +4787,15 @@ int main(int argc, char** argv)
 			catch (const std::invalid_argument& ia) { std::cerr << "Invalid argument: " << ia.what() << std::endl; exit(EXIT_FAILURE); }
 			catch (const std::out_of_range& oor) { std::cerr << "Out of Range error: " << oor.what() << std::endl; exit(EXIT_FAILURE); }
 			break;
+		case 'y':	// --sync
+			LogFileSync = true;
+			break;
+		case 'a':	// --archive
+			LogArchive = true;
+			break;
+		case 'C':	// --convert
+			ConvertLogFiles(std::string(optarg));
+			exit(EXIT_SUCCESS);
 		case 'v':	// --verbose
 			try { ConsoleVerbosity = std::stoi(optarg); }
 			catch (const std::invalid_argument& ia) { std::cerr << "Invalid argument: " << ia.what() << std::endl; exit(EXIT_FAILURE); }
@@ -1285,12 +4833,52 @@ int main(int argc, char** argv)
 			catch (const std::invalid_argument& ia) { std::cerr << "Invalid argument: " << ia.what() << std::endl; exit(EXIT_FAILURE); }
 			catch (const std::out_of_range& oor) { std::cerr << "Out of Range error: " << oor.what() << std::endl; exit(EXIT_FAILURE); }
 			break;
+		case 'S':	// --simplify
+			try { SVGSimplify = std::stoi(optarg); }
+			catch (const std::invalid_argument& ia) { std::cerr << "Invalid argument: " << ia.what() << std::endl; exit(EXIT_FAILURE); }
+			catch (const std::out_of_range& oor) { std::cerr << "Out of Range error: " << oor.what() << std::endl; exit(EXIT_FAILURE); }
+			break;
+		case 'e':	// --envelope
+			try { SVGEnvelope = std::stoi(optarg); }
+			catch (const std::invalid_argument& ia) { std::cerr << "Invalid argument: " << ia.what() << std::endl; exit(EXIT_FAILURE); }
+			catch (const std::out_of_range& oor) { std::cerr << "Out of Range error: " << oor.what() << std::endl; exit(EXIT_FAILURE); }
+			break;
+		case 'w':	// --workers
+			try { LogReadThreads = std::max(1, std::stoi(optarg)); }
+			catch (const std::invalid_argument& ia) { std::cerr << "Invalid argument: " << ia.what() << std::endl; exit(EXIT_FAILURE); }
+			catch (const std::out_of_range& oor) { std::cerr << "Out of Range error: " << oor.what() << std::endl; exit(EXIT_FAILURE); }
+			break;
+		case 'r':	// --render-threads
+			try { SVGRenderThreads = std::max(1, std::stoi(optarg)); }
+			catch (const std::invalid_argument& ia) { std::cerr << "Invalid argument: " << ia.what() << std::endl; exit(EXIT_FAILURE); }
+			catch (const std::out_of_range& oor) { std::cerr << "Out of Range error: " << oor.what() << std::endl; exit(EXIT_FAILURE); }
+			break;
+		case 'P':	// --http-port
+			try { HTTPPort = std::stoi(optarg); }
+			catch (const std::invalid_argument& ia) { std::cerr << "Invalid argument: " << ia.what() << std::endl; exit(EXIT_FAILURE); }
+			catch (const std::out_of_range& oor) { std::cerr << "Out of Range error: " << oor.what() << std::endl; exit(EXIT_FAILURE); }
+			if ((HTTPPort < 0) || (HTTPPort > 65535))
+			{
+				std::cerr << "Invalid HTTP port: " << HTTPPort << std::endl;
+				exit(EXIT_FAILURE);
+			}
+			break;
+		case 'Q':	// --query
+			LogQueryArgument = std::string(optarg);
+			break;
+		case 'B':	// --benchmark
+			BenchmarkParsers(std::string(optarg));
+			BenchmarkSVG(std::string(optarg));
+			exit(EXIT_SUCCESS);
 		default:
 			usage(argc, argv);
 			exit(EXIT_FAILURE);
 		}
 	}
 	///////////////////////////////////////////////////////////////////////////////////////////////
+	if (!LogQueryArgument.empty())	// answered after all the options are read, since it uses --log, --svg and the graph options
+		exit(RunLogQuery(LogQueryArgument) ? EXIT_SUCCESS : EXIT_FAILURE);
+	///////////////////////////////////////////////////////////////////////////////////////////////
 	int ExitValue = EXIT_SUCCESS;
 	///////////////////////////////////////////////////////////////////////////////////////////////
 	if (ConsoleVerbosity > 0)
@@ -1312,32 +4900,42 @@ int main(int argc, char** argv)
 			std::cout << "[                   ]      svg: " << SVGDirectory << std::endl;
 			std::cout << "[                   ]  battery: " << SVGBattery << std::endl;
 			std::cout << "[                   ]   minmax: " << SVGMinMax << std::endl;
+			std::cout << "[                   ] simplify: " << SVGSimplify << std::endl;
+			std::cout << "[                   ] envelope: " << SVGEnvelope << std::endl;
 			std::cout << "[                   ]  celsius: " << std::boolalpha << !SVGFahrenheit << std::endl;
 			//std::cout << "[                   ] titlemap: " << SVGTitleMapFilename << std::endl;
 			std::cout << "[                   ]     time: " << LogFileTime << std::endl;
+			std::cout << "[                   ]     sync: " << std::boolalpha << LogFileSync << std::endl;
+			std::cout << "[                   ]  archive: " << std::boolalpha << LogArchive << std::endl;
+			std::cout << "[                   ]  workers: " << LogReadThreads << std::endl;
+			std::cout << "[                   ]   render: " << SVGRenderThreads << std::endl;
+			std::cout << "[                   ]     http: " << HTTPPort << std::endl;
 		}
 	}
 	else
 		std::cerr << ProgramVersionString << " (starting)" << std::endl;
 	///////////////////////////////////////////////////////////////////////////////////////////////
 	tzset();
+	LocalTime.clear();	// drops any spans found with the time zone in effect before this
 	///////////////////////////////////////////////////////////////////////////////////////////////
-	if (!SVGDirectory.empty())
+	if (!SVGDirectory.empty() || (HTTPPort > 0))
 	{
 		//if (SVGTitleMapFilename.empty()) // If this wasn't set as a parameter, look in the SVG Directory for a default titlemap
 		//	SVGTitleMapFilename = std::filesystem::path(SVGDirectory / "gvh-titlemap.txt");
 		//ReadTitleMap(SVGTitleMapFilename);
 		ReadCacheDirectory(); // if cache directory is configured, read it before reading all the normal logs
-		ReadLoggedData(); // only read the logged data if creating SVG files
-		//GenerateCacheFile(GoveeMRTGLogs); // update cache files if any new data was in logs
-		WriteAllSVG();
+		ReadLoggedData(); // only read the logged data if creating SVG files or serving them
+		ReadRapidWindLogs();
+		GenerateCacheFile(); // update cache file if any new data was in logs
+		if (!SVGDirectory.empty())
+			WriteAllSVG();
 	}
 	///////////////////////////////////////////////////////////////////////////////////////////////
 	auto previousHandlerSIGINT = std::signal(SIGINT, SignalHandlerSIGINT);	// Install CTR-C signal handler
 	auto previousHandlerSIGHUP = std::signal(SIGHUP, SignalHandlerSIGHUP);	// Install Hangup signal handler
 	auto previousAlarmHandler = std::signal(SIGALRM, SignalHandlerSIGALRM);	// Install Alarm signal handler
 	bRun = true;
-	std::queue<std::string> DataToBeLogged;
+	LogSpool DataToBeLogged;
 	struct sockaddr_in si_me;
 	memset(&si_me, 0, sizeof(si_me));
 	si_me.sin_family = AF_INET;
@@ -1347,86 +4945,55 @@ int main(int argc, char** argv)
 	int broadcast = 1;
 	setsockopt(UDPSocket, SOL_SOCKET, SO_BROADCAST, &broadcast, sizeof broadcast);
 	::bind(UDPSocket, (sockaddr*)&si_me, sizeof(sockaddr));
-	time_t TimeStart(0), TimeSVG(0);
+	time_t TimeStart(0), TimeSVG(0), TimeCache(0);
 	time(&TimeStart);
+	TimeCache = TimeStart;
+	// The ingest thread doesn't take the signals, so they interrupt the select() below and the loop sees bRun change
+	sigset_t IngestSignals, PreviousSignals;
+	sigemptyset(&IngestSignals);
+	sigaddset(&IngestSignals, SIGINT);
+	sigaddset(&IngestSignals, SIGHUP);
+	sigaddset(&IngestSignals, SIGALRM);
+	pthread_sigmask(SIG_BLOCK, &IngestSignals, &PreviousSignals);
+	const int UDPWakeEvent = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+	std::thread UDPIngestThread(UDPIngest, UDPSocket, UDPWakeEvent);
+	const int HTTPSocket = (HTTPPort > 0) ? OpenHTTPSocket(HTTPPort) : -1;
+	std::thread HTTPServerThread;
+	if (HTTPSocket != -1)
+	{
+		PublishHTTPSnapshots();
+		HTTPServerThread = std::thread(HTTPServer, HTTPSocket);
+	}
+	pthread_sigmask(SIG_SETMASK, &PreviousSignals, NULL);
 	while (bRun)
 	{
-		// This select() call coming up will sit and wait until until the socket read would return something that's not EAGAIN/EWOULDBLOCK
+		// This select() call coming up will sit and wait until the ingest thread has queued datagrams, or the timeout
 		// But first we need to set a timeout -- we need to do this every time before we call select()
 		struct timeval select_timeout = { 60, 0 };	// 60 second timeout, 0 microseconds
 		// and reset the value of check_set, since that's what will tell us what descriptors were ready
 		// Set up the file descriptor set that select() will use
 		fd_set check_set;
 		FD_ZERO(&check_set);
-		FD_SET(UDPSocket, &check_set);
-		// This will block until either a read is ready (i.e. wont return EWOULDBLOCK) -1 on error, 0 on timeout, otherwise number of FDs changed
-		if (0 < select(UDPSocket + 1, &check_set, NULL, NULL, &select_timeout))	// returns number of handles ready to read. 0 or negative indicate other than good data to read.
+		FD_SET(UDPWakeEvent, &check_set);
+		// This will block until either a read is ready (i.e. wont return EWOULDBLOCK) -1 on error, 0 on timeout, otherwise number of FDs changed
+		if (0 < select(UDPWakeEvent + 1, &check_set, NULL, NULL, &select_timeout))	// returns number of handles ready to read. 0 or negative indicate other than good data to read.
 		{
-			// We got data ready to read, check and make sure it's the right descriptor, just as a sanity check (it shouldn't be possible ot get anything else)
-			if (FD_ISSET(UDPSocket, &check_set))
-			{
-				// okay, if we made it this far, we can read our descriptor, and shouldn't get EAGAIN. Ideally, the right way to process this is 'read in a loop
-				// until you get EAGAIN and then go back to select()', but worst case is that you don't read everything availableand select() immediately returns, so not
-				// a *huge* deal just doing one read and then back to select, here.
-
-				char buf[1024];	// msgs are super small
-				struct sockaddr_in si_other;
-				unsigned slen = sizeof(sockaddr);
-				auto bufDataLen = recvfrom(UDPSocket, buf, sizeof(buf), 0, (sockaddr*)&si_other, &slen);
-				//auto bufDataLen = read(s, buf, sizeof(buf));
-				std::string JSonData(buf, 0, bufDataLen);
-				DataToBeLogged.push(JSonData);
+			uint64_t WakeCount;
+			if (-1 == read(UDPWakeEvent, &WakeCount, sizeof(WakeCount)))	// resets the eventfd counter, the queue itself says how much is waiting
 				if (ConsoleVerbosity > 0)
-					std::cout << "[" << getTimeISO8601() << "] " << JSonData << std::endl;
-
-				// https://github.com/open-source-parsers/jsoncpp
-				const auto rawJsonLength = static_cast<int>(JSonData.length());
-				JSONCPP_STRING err;
-				Json::Value root;
-				Json::CharReaderBuilder builder;
-				const std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
-				if (!reader->parse(JSonData.c_str(), JSonData.c_str() + rawJsonLength, &root, &err))
-				{
-					if (ConsoleVerbosity > 0)
-						std::cout << "json reader error" << std::endl;
-					//return EXIT_FAILURE;
-				}
-				else
+					std::cout << "[" << getTimeISO8601() << "] " << std::strerror(errno) << ": UDP ingest wakeup" << std::endl;
+			for (auto Batch = UDPQueue.front(); Batch != nullptr; Batch = UDPQueue.front())
+			{
+				for (size_t index = 0; index < Batch->Count; index++)
 				{
-					// https://apidocs.tempestwx.com/reference/tempest-udp-broadcast
-					const std::string msgtype = root["type"].asString();
-					if (!msgtype.compare("rapid_wind"))
-					{
-						const Json::Value observation = root["ob"];
-						if (observation.size() == 3)
-						{
-							//{"serial_number":"ST-00145757","type":"rapid_wind","hub_sn":"HB-00147479","ob":[1718217088,2.38,332]}
-							//{"serial_number":"ST-00145757","type":"rapid_wind","hub_sn":"HB-00147479","ob":[1718217091,2.02,335]}
-							//{"serial_number":"ST-00145757","type":"rapid_wind","hub_sn":"HB-00147479","ob":[1718217094,2.27,318]}
-							//{"serial_number":"ST-00145757","type":"rapid_wind","hub_sn":"HB-00147479","ob":[1718217097,2.66,339]}
-							//{"serial_number":"ST-00145757","type":"rapid_wind","hub_sn":"HB-00147479","ob":[1718217100,2.30,352]}
-							//{"serial_number":"ST-00145757","type":"rapid_wind","hub_sn":"HB-00147479","ob":[1718217103,1.74,354]}
-							//{"serial_number":"ST-00145757","type":"rapid_wind","hub_sn":"HB-00147479","ob":[1718217106,1.58,4]}
-							//{"serial_number":"ST-00145757","type":"rapid_wind","hub_sn":"HB-00147479","ob":[1718217109,2.35,351]}
-							auto timetick = observation[0].asLargestInt();
-							auto windspeed = observation[1].asFloat();
-							auto winddirection = observation[2].asInt();
-							if (ConsoleVerbosity > 1)
-								std::cout << "[" << getTimeISO8601() << "] Rapid Wind: " << timetick << ", " << windspeed << ", " << winddirection << std::endl;
-						}
-					}
-					else if (!msgtype.compare("obs_st"))
-					{
-						TempestObservation observation(JSonData);
-						if (observation.IsValid())
-						{
-							if (ConsoleVerbosity > 1)
-								std::cout << "[" << timeToISO8601(observation.Time) << "] observation read properly: " << JSonData << std::endl;
-							UpdateMRTGData(observation);
-						}
-					}
+					const std::string_view JSonData(Batch->Data[index].data(), Batch->Length[index]);
+					ProcessTempestMessage(JSonData);
+					DataToBeLogged.push(JSonData);
 				}
+				UDPQueue.pop();
 			}
+			if (HTTPSocket != -1)
+				PublishHTTPSnapshots();
 		}
 		time_t TimeNow;
 		time(&TimeNow);
@@ -1443,10 +5010,34 @@ int main(int argc, char** argv)
 				std::cout << "[" << getTimeISO8601() << "] " << std::dec << LogFileTime << " seconds or more have passed. Writing LOG Files" << std::endl;
 			TimeStart = TimeNow;
 			GenerateLogFile(DataToBeLogged);
+			GenerateArchiveFiles();
+			LogUDPCounters();
 		}
+		if ((!SVGDirectory.empty() || (HTTPPort > 0)) && (difftime(TimeNow, TimeCache) > CACHE_SAMPLE))
+		{
+			TimeCache = TimeNow;
+			GenerateCacheFile();
+		}
+	}
+	UDPIngestRun = false;
+	UDPIngestThread.join();
+	if (HTTPServerThread.joinable())
+	{
+		HTTPServerRun = false;
+		HTTPServerThread.join();
+		close(HTTPSocket);
 	}
+	close(UDPWakeEvent);
 	close(UDPSocket);
+	LogUDPCounters();
+	for (auto& [Serial, Device] : TempestDevices)
+		if (Device.SVGRendering.valid())
+			Device.SVGRendering.wait(); // let the files being rendered be completed before exiting
 	GenerateLogFile(DataToBeLogged);
+	GenerateArchiveFiles();
+	CloseLogFile();
+	if (!SVGDirectory.empty() || (HTTPPort > 0))
+		GenerateCacheFile(); // The cache is only complete if the logged data was read at startup, which only happens when creating or serving SVG files
 	std::signal(SIGALRM, previousAlarmHandler);	// Restore original Alarm signal handler
 	std::signal(SIGHUP, previousHandlerSIGHUP);	// Restore original Hangup signal handler
 	std::signal(SIGINT, previousHandlerSIGINT);	// Restore original Ctrl-C signal handler
@@ -1,4 +1,11 @@
 #include "wimiso8601.h"
+// glibc declares localtime_r() and gmtime_r() as functions rather than macros, so name them here to select the reentrant versions below.
+#if defined(__unix__) && !defined(localtime_r)
+#define localtime_r localtime_r
+#endif
+#if defined(__unix__) && !defined(gmtime_r)
+#define gmtime_r gmtime_r
+#endif
 /////////////////////////////////////////////////////////////////////////////
 std::string timeToISO8601(const time_t& TheTime, const bool LocalTime)
 {